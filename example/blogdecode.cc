@@ -0,0 +1,28 @@
+#include <szmuduo/BinaryLogging.h>
+
+#include <stdio.h>
+
+/**************************************************************************************
+ * 二进制日志解码：把 BinaryLogging 写出的文件还原为文本
+ *
+ *  ./blogdecode server.blog > server.log
+**************************************************************************************/
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <binary log file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = ::fopen(argv[1], "rb");
+    if (in == nullptr)
+    {
+        perror("fopen");
+        return 1;
+    }
+    bool ok = BinaryLogging::decode(in, stdout);
+    ::fclose(in);
+    return ok ? 0 : 1;
+}
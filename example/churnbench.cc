@@ -0,0 +1,119 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 连接建立 / 关闭压测：客户端线程不断 connect -> 收到服务端问候 -> close，
+ * 统计每秒完成的连接数，以及平均每个连接的堆分配次数（替换全局 operator new 计数）。
+ *
+ *  ./churnbench [客户端线程数] [秒数] [服务端 IO 线程数]
+**************************************************************************************/
+
+static std::atomic<long> g_allocs(0);
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+static const uint16_t kPort = 8001;
+
+static void clientThread(std::atomic<bool>* running, std::atomic<long>* done)
+{
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    while (*running)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0)
+        {
+            char c;
+            if (::read(fd, &c, 1) == 1)
+            {
+                ++*done;
+            }
+        }
+        ::close(fd);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 5;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 2;
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "ChurnBench");
+    server.setThreadNum(numThreads);
+    server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->send("x");
+        }
+    });
+    server.start();
+
+    std::atomic<bool> running(true);
+    std::atomic<long> done(0);
+    std::vector<std::thread> clients;
+
+    std::thread timer([&]() {
+        for (int i = 0; i < numClients; ++i)
+        {
+            clients.emplace_back(clientThread, &running, &done);
+        }
+
+        // 预热一秒，使连接池进入稳定状态
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        long startDone = done, startAllocs = g_allocs;
+        auto start = std::chrono::steady_clock::now();
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+        long conns = done - startDone;
+        long allocs = g_allocs - startAllocs;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        running = false;
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+        printf("connections: %ld  conn/s: %.0f  heap allocs/conn: %.2f\n",
+               conns, conns / elapsed, conns ? (double)allocs / conns : 0.0);
+        loop.quit();
+    });
+
+    loop.loop();
+    timer.join();
+    return 0;
+}
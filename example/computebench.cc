@@ -0,0 +1,307 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/ComputePool.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/InetAddress.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+#include <szmuduo/CurrentThread.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/**************************************************************************************
+ * 廉价请求和昂贵请求混合时的尾延迟：服务器 1 个 IO 线程，昂贵请求在 messageCallback 中
+ * 做 cost 微秒的计算（inline），或交给 ComputePool（pool）。
+ *     cheap 客户端逐个发送廉价请求，统计时延；heavy 客户端逐个发送昂贵请求；另有一个
+ * 流水线客户端每批发送 1 个昂贵请求 + 3 个廉价请求，检查响应顺序与请求顺序一致。
+ *     请求和响应都是 16 字节：4 字节序号、1 字节类型（'c' / 'e'），其余填充。
+ *     nice 为计算线程的调度优先级（ThreadInitCallback 中 setpriority），CPU 不够时让
+ * IO 线程优先运行。
+ *
+ *  ./computebench [inline|pool] [计算线程数] [cheap 客户端数] [heavy 客户端数] [秒数] [cost 微秒] [nice]
+**************************************************************************************/
+
+static const uint16_t kPort = 8052;
+static const size_t kMessageSize = 16;
+
+static volatile uint64_t g_sink;
+static uint64_t g_roundsPerMicro = 1;
+
+// 模拟压缩 / 加密：对一块内存反复做 FNV 哈希
+static uint64_t burnRounds(uint64_t rounds)
+{
+    static const char block[256] = { 1 };
+    uint64_t h = 1469598103934665603ULL;
+    for (uint64_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < sizeof(block); ++i)
+        {
+            h = (h ^ static_cast<unsigned char>(block[i] + r)) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+static void burn(int micros)
+{
+    g_sink = burnRounds(g_roundsPerMicro * micros);
+}
+
+static void calibrate()
+{
+    uint64_t rounds = 1000;
+    while (true)
+    {
+        int64_t start = Timestamp::monotonicMicros();
+        g_sink = burnRounds(rounds);
+        int64_t elapsed = Timestamp::monotonicMicros() - start;
+        if (elapsed > 20 * 1000)
+        {
+            g_roundsPerMicro = std::max<uint64_t>(1, rounds / elapsed);
+            return;
+        }
+        rounds *= 2;
+    }
+}
+
+static int connectServer()
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    InetAddress addr(kPort, "127.0.0.1");
+    if (::connect(fd, addr.getSockAddr(), addr.length()) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool readFull(int fd, char* buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = ::read(fd, buf + got, len - got);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static void encode(char* msg, uint32_t seq, char type)
+{
+    memset(msg, 0, kMessageSize);
+    memcpy(msg, &seq, sizeof(seq));
+    msg[4] = type;
+}
+
+static uint32_t decodeSeq(const char* msg)
+{
+    uint32_t seq = 0;
+    memcpy(&seq, msg, sizeof(seq));
+    return seq;
+}
+
+struct Results
+{
+    std::mutex mutex;
+    std::vector<int64_t> cheapLatencies;
+    uint64_t heavyRequests = 0;
+    uint64_t pipelinedBatches = 0;
+    uint64_t orderErrors = 0;
+};
+
+// 逐个发送同一类型的请求
+static void runPingPong(char type, int64_t deadline, Results* results)
+{
+    int fd = connectServer();
+    char request[kMessageSize];
+    char response[kMessageSize];
+    std::vector<int64_t> latencies;
+    uint32_t seq = 0;
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        encode(request, seq, type);
+        int64_t start = Timestamp::monotonicMicros();
+        if (::write(fd, request, kMessageSize) != (ssize_t)kMessageSize || !readFull(fd, response, kMessageSize))
+        {
+            break;
+        }
+        latencies.push_back(Timestamp::monotonicMicros() - start);
+        ++seq;
+    }
+    ::close(fd);
+
+    std::lock_guard<std::mutex> lock(results->mutex);
+    if (type == 'c')
+    {
+        results->cheapLatencies.insert(results->cheapLatencies.end(), latencies.begin(), latencies.end());
+    }
+    else
+    {
+        results->heavyRequests += latencies.size();
+    }
+}
+
+// 每批 1 个昂贵 + 3 个廉价请求一起发出，响应必须按序号返回
+static void runPipelined(int64_t deadline, Results* results)
+{
+    int fd = connectServer();
+    const int kBatch = 4;
+    char requests[kBatch * kMessageSize];
+    char responses[kBatch * kMessageSize];
+    uint32_t seq = 0;
+    uint64_t batches = 0;
+    uint64_t errors = 0;
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        for (int i = 0; i < kBatch; ++i)
+        {
+            encode(requests + i * kMessageSize, seq + i, i == 0 ? 'e' : 'c');
+        }
+        if (::write(fd, requests, sizeof(requests)) != (ssize_t)sizeof(requests)
+            || !readFull(fd, responses, sizeof(responses)))
+        {
+            break;
+        }
+        for (int i = 0; i < kBatch; ++i)
+        {
+            if (decodeSeq(responses + i * kMessageSize) != seq + i)
+            {
+                ++errors;
+            }
+        }
+        seq += kBatch;
+        ++batches;
+    }
+    ::close(fd);
+
+    std::lock_guard<std::mutex> lock(results->mutex);
+    results->pipelinedBatches += batches;
+    results->orderErrors += errors;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "pool";
+    int computeThreads = argc > 2 ? atoi(argv[2]) : 2;
+    int numCheap = argc > 3 ? atoi(argv[3]) : 4;
+    int numHeavy = argc > 4 ? atoi(argv[4]) : 2;
+    double seconds = argc > 5 ? atof(argv[5]) : 3.0;
+    int cost = argc > 6 ? atoi(argv[6]) : 2000;
+    int niceness = argc > 7 ? atoi(argv[7]) : 0;
+
+    Logger::setLogLevel(FATAL);
+    calibrate();
+
+    EventLoop loop;
+    ComputePool pool("ComputeBench");
+    if (mode == "pool")
+    {
+        pool.start(computeThreads, [niceness](int) {
+            if (niceness != 0)
+            {
+                ::setpriority(PRIO_PROCESS, CurrentThread::tid(), niceness);
+            }
+        });
+    }
+
+    TcpServer server(&loop, InetAddress(kPort), "ComputeBench");
+    server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.setMessageCalback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        while (buf->readableBytes() >= kMessageSize)
+        {
+            std::string msg(buf->peek(), kMessageSize);
+            buf->retrieve(kMessageSize);
+            bool heavy = msg[4] == 'e';
+            if (mode == "inline")
+            {
+                if (heavy)
+                {
+                    burn(cost);
+                }
+                conn->send(msg);
+            }
+            else if (heavy)
+            {
+                pool.submit(conn, [cost]() { burn(cost); },
+                            [msg](const TcpConnectionPtr& c) { c->send(msg); });
+            }
+            else
+            {
+                // 不经过工作线程，前面有昂贵请求时排在它之后
+                pool.submit(conn, ComputePool::Task(),
+                            [msg](const TcpConnectionPtr& c) { c->send(msg); });
+            }
+        }
+    });
+    server.setThreadNum(1);
+    server.start();
+
+    std::thread driver([&]() {
+        usleep(100 * 1000);
+        Results results;
+        int64_t deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numCheap; ++i)
+        {
+            clients.emplace_back(runPingPong, 'c', deadline, &results);
+        }
+        for (int i = 0; i < numHeavy; ++i)
+        {
+            clients.emplace_back(runPingPong, 'e', deadline, &results);
+        }
+        clients.emplace_back(runPipelined, deadline, &results);
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+
+        std::vector<int64_t>& latencies = results.cheapLatencies;
+        std::sort(latencies.begin(), latencies.end());
+        if (latencies.empty())
+        {
+            printf("%s: no response\n", mode.c_str());
+        }
+        else
+        {
+            ComputePoolStats stats = pool.stats();
+            printf("%-6s %d compute threads (nice %d), cost %d us: cheap %.0f/s p50 %lld us p99 %lld us p99.9 %lld us, "
+                   "heavy %.0f/s, pipelined %.0f batches/s, order errors %llu, stolen %llu\n",
+                   mode.c_str(), mode == "pool" ? computeThreads : 0, niceness, cost,
+                   latencies.size() / seconds,
+                   (long long)latencies[latencies.size() / 2],
+                   (long long)latencies[latencies.size() * 99 / 100],
+                   (long long)latencies[latencies.size() * 999 / 1000],
+                   results.heavyRequests / seconds, results.pipelinedBatches / seconds,
+                   (unsigned long long)results.orderErrors, (unsigned long long)stats.stolen);
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
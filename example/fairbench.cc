@@ -0,0 +1,164 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 读取预算压测：一个 IO 线程上，一个连接持续灌入数据，其他连接做小包往返，
+ * 统计往返时延的分位数。回调对每个字节做少量计算，模拟协议解析的开销。
+ *
+ *  ./fairbench [lt|et] [每轮读取预算字节数，0 表示不限] [往返次数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8037;
+static const int kPingClients = 8;
+static const size_t kPingSize = 64;
+
+static volatile uint32_t g_sink;
+
+static int connectServer()
+{
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    timeval timeout = {1, 0};       // 不设预算的边沿触发下往返连接可能一直得不到处理
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    // 模拟解析：每个字节参与一次计算
+    const char* p = buf->peek();
+    size_t len = buf->readableBytes();
+    uint32_t sum = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        sum = sum * 31 + static_cast<unsigned char>(p[i]);
+    }
+    g_sink = sum;
+
+    if (len > 0 && p[0] == 'p')     // 往返连接原样返回
+    {
+        conn->send(buf->retrieveAllAsString());
+    }
+    else
+    {
+        buf->retrieveAll();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool edgeTriggered = argc > 1 && strcmp(argv[1], "et") == 0;
+    size_t budget = argc > 2 ? atoi(argv[2]) : 0;
+    int numPings = argc > 3 ? atoi(argv[3]) : 20000;
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "FairBench");
+    server.setThreadNum(1);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setReadBudget(budget);
+    server.setMessageCalback(onMessage);
+    server.start();
+
+    std::atomic<bool> running(true);
+    std::thread flooder([&]() {
+        int fd = connectServer();
+        std::string chunk(256 * 1024, 'f');
+        while (running)
+        {
+            if (::write(fd, chunk.data(), chunk.size()) <= 0)
+            {
+                break;
+            }
+        }
+        ::close(fd);
+    });
+
+    std::thread pinger([&]() {
+        std::vector<int> fds;
+        for (int i = 0; i < kPingClients; ++i)
+        {
+            fds.push_back(connectServer());
+        }
+        ::usleep(200 * 1000);       // 等灌入连接达到稳定状态
+
+        int timeouts = 0;
+        std::vector<double> rtts;
+        rtts.reserve(numPings);
+        char msg[kPingSize];
+        memset(msg, 'p', sizeof(msg));
+        char buf[kPingSize];
+        for (int i = 0; i < numPings; ++i)
+        {
+            int fd = fds[i % kPingClients];
+            auto start = std::chrono::steady_clock::now();
+            ::write(fd, msg, sizeof(msg));
+            size_t got = 0;
+            while (got < sizeof(buf))
+            {
+                ssize_t n = ::read(fd, buf + got, sizeof(buf) - got);
+                if (n <= 0)
+                {
+                    break;
+                }
+                got += n;
+            }
+            if (got < sizeof(buf))
+            {
+                if (++timeouts >= 3)
+                {
+                    break;
+                }
+                continue;
+            }
+            rtts.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        std::sort(rtts.begin(), rtts.end());
+        if (timeouts >= 3 || rtts.empty())
+        {
+            printf("%s, read budget %zu: %zu round trips done, then starved (no reply within 1s)\n",
+                   edgeTriggered ? "et" : "lt", budget, rtts.size());
+        }
+        else
+        {
+            printf("%s, read budget %zu: p50 %.0f us, p99 %.0f us, p999 %.0f us, max %.0f us\n",
+                   edgeTriggered ? "et" : "lt", budget,
+                   rtts[rtts.size() / 2], rtts[rtts.size() * 99 / 100],
+                   rtts[rtts.size() * 999 / 1000], rtts.back());
+        }
+
+        running = false;
+        for (int fd : fds)
+        {
+            ::close(fd);
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    pinger.join();
+    flooder.join();
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+#include <szmuduo/Payload.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 广播压测：一个发布线程把消息推给所有订阅连接，统计每秒投递的消息数和内存峰值。
+ *     payload：TcpServer::broadcast，每条消息一个共享 Payload，每个 loop 一个任务
+ *     copy   ：逐个连接 sendTo，每个连接拷贝一份并投递一个跨线程任务
+ *
+ *  ./fanoutbench [payload|copy] [订阅连接数] [IO 线程数] [消息字节数] [消息条数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8036;
+static const int kClientThreads = 4;
+static const int kBatch = 16;       // 每批发布的消息数，发布后等待全部收到
+
+static long peakRssKb()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// 订阅端：每个线程用 epoll 读自己的连接，只统计字节数
+static void clientThread(int numConns, std::atomic<bool>* running, std::atomic<long>* received)
+{
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < numConns; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    epoll_event events[256];
+    char buf[65536];
+    while (*running)
+    {
+        int n = ::epoll_wait(epfd, events, 256, 10);
+        for (int i = 0; i < n; ++i)
+        {
+            ssize_t len;
+            while ((len = ::read(events[i].data.fd, buf, sizeof(buf))) > 0)
+            {
+                *received += len;
+            }
+        }
+    }
+    ::close(epfd);
+}
+
+int main(int argc, char* argv[])
+{
+    bool usePayload = argc <= 1 || strcmp(argv[1], "copy") != 0;
+    int numSubscribers = argc > 2 ? atoi(argv[2]) : 2000;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 4;
+    size_t msgSize = argc > 4 ? atoi(argv[4]) : 256;
+    int numMessages = argc > 5 ? atoi(argv[5]) : 2000;
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "FanoutBench");
+    server.setThreadNum(numThreads);
+
+    std::mutex mutex;
+    std::vector<ConnectionId> ids;
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ids.push_back(conn->id());
+        }
+    });
+    server.start();
+
+    std::atomic<bool> running(true);
+    std::atomic<long> received(0);
+
+    std::thread publisher([&]() {
+        std::vector<std::thread> clients;
+        for (int i = 0; i < kClientThreads; ++i)
+        {
+            int n = numSubscribers / kClientThreads + (i < numSubscribers % kClientThreads ? 1 : 0);
+            clients.emplace_back(clientThread, n, &running, &received);
+        }
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (ids.size() == static_cast<size_t>(numSubscribers))
+                {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::string msg(msgSize, 'x');
+        long rssBefore = peakRssKb();
+        auto start = std::chrono::steady_clock::now();
+        for (int sent = 0; sent < numMessages; )
+        {
+            for (int b = 0; b < kBatch && sent < numMessages; ++b, ++sent)
+            {
+                if (usePayload)
+                {
+                    server.broadcast(Payload::create(msg));
+                }
+                else
+                {
+                    for (ConnectionId id : ids)
+                    {
+                        server.sendTo(id, msg);
+                    }
+                }
+            }
+            long expected = static_cast<long>(sent) * numSubscribers * msgSize;
+            while (received < expected)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double deliveries = static_cast<double>(numMessages) * numSubscribers;
+        printf("%s: %d subscribers, %d io threads, %zu-byte messages\n",
+               usePayload ? "payload" : "copy", numSubscribers, numThreads, msgSize);
+        printf("published %.0f msg/s, delivered %.0f msg/s, peak RSS %ld KB (+%ld KB during run)\n",
+               numMessages / elapsed, deliveries / elapsed, peakRssKb(), peakRssKb() - rssBefore);
+
+        running = false;
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    publisher.join();
+    return 0;
+}
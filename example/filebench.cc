@@ -0,0 +1,229 @@
+#include <szmuduo/HttpServer.h>
+#include <szmuduo/StaticFileHandler.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 静态文件服务压测：在临时目录中生成若干 1KB ~ 32KB 的文件，客户端用 keep-alive 连接
+ * 轮流请求这些文件，比较缓存全部命中（hot）、缓存放不下每次都要打开映射（cold）、
+ * 以及带 If-Modified-Since 的条件请求（304）三种情况的每秒请求数。
+ * 最后修改一个文件，检查 inotify 是否使缓存项失效、下一次请求拿到新内容。
+ *
+ *  ./filebench [hot|cold|304] [文件数] [连接数] [秒数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8043;
+
+using Clock = std::chrono::steady_clock;
+
+struct ClientConn
+{
+    int fd;
+    std::string input;
+    size_t next;
+};
+
+static size_t takeResponse(const std::string& input)
+{
+    size_t headerEnd = input.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+    {
+        return 0;
+    }
+    size_t pos = input.find("Content-Length: ");
+    size_t length = pos < headerEnd ? strtoul(input.c_str() + pos + 16, nullptr, 10) : 0;
+    size_t total = headerEnd + 4 + length;
+    return input.size() >= total ? total : 0;
+}
+
+static std::string fetch(const std::string& path)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+    std::string request = "GET " + path + " HTTP/1.1\r\nConnection: close\r\n\r\n";
+    ::write(fd, request.data(), request.size());
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+    {
+        response.append(buf, n);
+    }
+    ::close(fd);
+    return response;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "hot";
+    int numFiles = argc > 2 ? atoi(argv[2]) : 2000;
+    int numConns = argc > 3 ? atoi(argv[3]) : 64;
+    double seconds = argc > 4 ? atof(argv[4]) : 3.0;
+
+    // 生成测试文件，分散在 8 个子目录中
+    char root[] = "/tmp/filebench-XXXXXX";
+    if (::mkdtemp(root) == nullptr)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::vector<std::string> requests;
+    std::string content;
+    for (int i = 0; i < numFiles; ++i)
+    {
+        char dir[64];
+        snprintf(dir, sizeof(dir), "/d%d", i % 8);
+        ::mkdir((std::string(root) + dir).c_str(), 0755);
+        char name[64];
+        snprintf(name, sizeof(name), "%s/f%d.html", dir, i);
+        content.assign(1024 * (1 + i % 32), static_cast<char>('a' + i % 26));
+        std::string path = std::string(root) + name;
+        FILE* fp = fopen(path.c_str(), "w");
+        fwrite(content.data(), 1, content.size(), fp);
+        fclose(fp);
+
+        std::string request = std::string("GET ") + name + " HTTP/1.1\r\nHost: localhost\r\n";
+        if (mode == "304")
+        {
+            struct stat st;
+            ::stat(path.c_str(), &st);
+            struct tm tm;
+            ::gmtime_r(&st.st_mtime, &tm);
+            char date[64];
+            strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+            request += std::string("If-Modified-Since: ") + date + "\r\n";
+        }
+        requests.push_back(request + "\r\n");
+    }
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+    // cold：缓存只能放一个文件，轮流请求时每次都不命中
+    StaticFileHandler files(&loop, root, mode == "cold" ? 1 : StaticFileHandler::kDefaultMaxEntries);
+    HttpServer server(&loop, InetAddress(kPort), "FileBench");
+    server.setThreadNum(2);
+    server.setHttpCallback(std::ref(files));
+    server.start();
+
+    std::thread driver([&]() {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+        // hot / 304 先把所有文件读一遍
+        if (mode != "cold")
+        {
+            for (int i = 0; i < numFiles; ++i)
+            {
+                char name[64];
+                snprintf(name, sizeof(name), "/d%d/f%d.html", i % 8, i);
+                fetch(name);
+            }
+        }
+        StaticFileHandler::Stats before = files.stats();
+
+        int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        std::vector<ClientConn> conns(numConns);
+        for (int i = 0; i < numConns; ++i)
+        {
+            ClientConn& c = conns[i];
+            c.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            ::connect(c.fd, (sockaddr*)&addr, sizeof(addr));
+            int one = 1;
+            ::setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = i;
+            ::epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+            c.next = i * 7919 % numFiles;
+            ::write(c.fd, requests[c.next].data(), requests[c.next].size());
+        }
+
+        uint64_t done = 0;
+        uint64_t bytes = 0;
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::duration<double>(seconds);
+        epoll_event events[256];
+        std::vector<char> buf(256 * 1024);
+        while (Clock::now() < deadline)
+        {
+            int n = ::epoll_wait(epfd, events, 256, 10);
+            for (int i = 0; i < n; ++i)
+            {
+                ClientConn& c = conns[events[i].data.u32];
+                ssize_t r = ::read(c.fd, buf.data(), buf.size());
+                if (r <= 0)
+                {
+                    ::epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+                    continue;
+                }
+                c.input.append(buf.data(), r);
+                bytes += r;
+                size_t len;
+                while ((len = takeResponse(c.input)) > 0)
+                {
+                    c.input.erase(0, len);
+                    ++done;
+                    c.next = (c.next + 1) % numFiles;
+                    ::write(c.fd, requests[c.next].data(), requests[c.next].size());
+                }
+            }
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        for (ClientConn& c : conns)
+        {
+            ::close(c.fd);
+        }
+        ::close(epfd);
+
+        StaticFileHandler::Stats after = files.stats();
+        printf("%s: %d files, %d connections, %.0f req/s, %.1f MB/s, hits %lu, misses %lu, 304 %lu, cached %zu (%.1f MB)\n",
+               mode.c_str(), numFiles, numConns, done / elapsed, bytes / elapsed / 1024 / 1024,
+               after.hits - before.hits, after.misses - before.misses, after.notModified - before.notModified,
+               after.entries, after.mappedBytes / 1024.0 / 1024.0);
+
+        // 修改一个已缓存的文件，inotify 使缓存失效后应返回新内容
+        fetch("/d0/f0.html");
+        std::string path = std::string(root) + "/d0/f0.html";
+        FILE* fp = fopen(path.c_str(), "w");
+        fputs("updated", fp);
+        fclose(fp);
+        usleep(100 * 1000);
+        std::string response = fetch("/d0/f0.html");
+        bool updated = response.size() >= 7 && response.compare(response.size() - 7, 7, "updated") == 0;
+        printf("  after modifying a file: invalidations %lu, new content %s\n",
+               files.stats().invalidations, updated ? "served" : "NOT served");
+
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+
+    std::string cleanup = std::string("rm -rf ") + root;
+    return system(cleanup.c_str()) == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+#include <szmuduo/HttpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * HttpServer 压测（类似 wrk）：服务器提供 /plaintext 和 /json 两个接口，客户端线程用
+ * epoll 维持若干 keep-alive 连接，每个连接一次发送 pipeline 个请求，收齐响应后再发下一批，
+ * 统计每秒请求数和请求时延。
+ *
+ *  ./httpbench [plaintext|json] [连接数] [pipeline] [秒数] [客户端线程数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8042;
+
+using Clock = std::chrono::steady_clock;
+
+static void onRequest(const HttpRequest& req, HttpResponse* resp)
+{
+    if (req.path() == "/plaintext")
+    {
+        resp->setContentType("text/plain");
+        resp->addHeader("Server", "szmuduo");
+        resp->setBody("Hello, World!");
+    }
+    else if (req.path() == "/json")
+    {
+        char body[64];
+        int n = snprintf(body, sizeof(body), "{\"message\":\"%s\"}", "Hello, World!");
+        resp->setContentType("application/json");
+        resp->addHeader("Server", "szmuduo");
+        resp->setBody(StringPiece(body, n));
+    }
+    else
+    {
+        resp->setStatusCode(404);
+    }
+}
+
+struct ClientConn
+{
+    int fd;
+    std::string input;
+    int outstanding;
+    Clock::time_point sentAt;
+};
+
+// 从 input 中取出一个完整响应，返回其长度，不完整返回 0
+static size_t takeResponse(const std::string& input)
+{
+    size_t headerEnd = input.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+    {
+        return 0;
+    }
+    size_t pos = input.find("Content-Length: ");
+    size_t length = pos < headerEnd ? strtoul(input.c_str() + pos + 16, nullptr, 10) : 0;
+    size_t total = headerEnd + 4 + length;
+    return input.size() >= total ? total : 0;
+}
+
+static void runClient(int numConns, int pipeline, const std::string& request, double seconds,
+                      std::atomic<uint64_t>& completed, std::vector<double>& latencies, std::mutex& mutex)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    std::string batch;
+    for (int i = 0; i < pipeline; ++i)
+    {
+        batch += request;
+    }
+
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<ClientConn> conns(numConns);
+    for (int i = 0; i < numConns; ++i)
+    {
+        ClientConn& c = conns[i];
+        c.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        ::connect(c.fd, (sockaddr*)&addr, sizeof(addr));
+        int one = 1;
+        ::setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+        c.outstanding = pipeline;
+        c.sentAt = Clock::now();
+        ::write(c.fd, batch.data(), batch.size());
+    }
+
+    std::vector<double> local;
+    uint64_t done = 0;
+    auto deadline = Clock::now() + std::chrono::duration<double>(seconds);
+    epoll_event events[256];
+    char buf[65536];
+    while (Clock::now() < deadline)
+    {
+        int n = ::epoll_wait(epfd, events, 256, 10);
+        for (int i = 0; i < n; ++i)
+        {
+            ClientConn& c = conns[events[i].data.u32];
+            ssize_t r = ::read(c.fd, buf, sizeof(buf));
+            if (r <= 0)
+            {
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+                continue;
+            }
+            c.input.append(buf, r);
+            size_t len;
+            while ((len = takeResponse(c.input)) > 0)
+            {
+                c.input.erase(0, len);
+                ++done;
+                local.push_back(std::chrono::duration<double, std::micro>(Clock::now() - c.sentAt).count());
+                if (--c.outstanding == 0)
+                {
+                    c.outstanding = pipeline;
+                    c.sentAt = Clock::now();
+                    ::write(c.fd, batch.data(), batch.size());
+                }
+            }
+        }
+    }
+
+    for (ClientConn& c : conns)
+    {
+        ::close(c.fd);
+    }
+    ::close(epfd);
+    completed += done;
+    std::unique_lock<std::mutex> lock(mutex);
+    latencies.insert(latencies.end(), local.begin(), local.end());
+}
+
+int main(int argc, char* argv[])
+{
+    std::string endpoint = argc > 1 ? argv[1] : "plaintext";
+    int numConns = argc > 2 ? atoi(argv[2]) : 64;
+    int pipeline = argc > 3 ? atoi(argv[3]) : 1;
+    double seconds = argc > 4 ? atof(argv[4]) : 3.0;
+    int numClients = argc > 5 ? atoi(argv[5]) : 1;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(kPort), "HttpBench");
+    server.setThreadNum(2);
+    server.setHttpCallback(onRequest);
+    server.start();
+
+    std::string request = "GET /" + endpoint + " HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "User-Agent: httpbench\r\n"
+                          "Accept: */*\r\n\r\n";
+
+    std::thread driver([&]() {
+        std::atomic<uint64_t> completed(0);
+        std::vector<double> latencies;
+        std::mutex mutex;
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numClients; ++i)
+        {
+            clients.emplace_back(runClient, numConns / numClients, pipeline, std::cref(request), seconds,
+                                 std::ref(completed), std::ref(latencies), std::ref(mutex));
+        }
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        if (latencies.empty())
+        {
+            printf("%s: no response\n", endpoint.c_str());
+        }
+        else
+        {
+            printf("%s: %d connections, pipeline %d, %.0f req/s, p50 %.0f us, p99 %.0f us\n",
+                   endpoint.c_str(), numConns, pipeline, completed.load() / seconds,
+                   latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100]);
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * socket 选项预设的小请求 / 小响应时延测试：客户端发 64 字节请求，服务器分两次 send
+ * 回复 16 字节头部和 100 字节正文（常见的头部、正文分开写），客户端收齐后再发下一个。
+ *
+ *  ./latencybench [default|latency|throughput] [客户端数] [每个客户端的请求数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8040;
+static const size_t kRequestSize = 64;
+static const size_t kHeaderSize = 16;
+static const size_t kBodySize = 100;
+
+static bool readFull(int fd, char* buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = ::read(fd, buf + got, len - got);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string profile = argc > 1 ? argv[1] : "default";
+    int numClients = argc > 2 ? atoi(argv[2]) : 4;
+    int numRequests = argc > 3 ? atoi(argv[3]) : 200;
+
+    SocketOptions options;
+    if (profile == "latency")
+    {
+        options = SocketOptions::latency();
+    }
+    else if (profile == "throughput")
+    {
+        options = SocketOptions::throughput();
+    }
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "LatencyBench");
+    server.setThreadNum(2);
+    server.setSocketOptions(options);
+
+    const std::string header(kHeaderSize, 'h');
+    const std::string body(kBodySize, 'b');
+    server.setMessageCalback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        while (buf->readableBytes() >= kRequestSize)
+        {
+            buf->retrieve(kRequestSize);
+            conn->send(header);
+            conn->send(body);
+        }
+    });
+    server.start();
+
+    std::mutex mutex;
+    std::vector<double> rtts;
+    std::thread driver([&]() {
+        std::vector<std::thread> clients;
+        auto start = std::chrono::steady_clock::now();
+        for (int c = 0; c < numClients; ++c)
+        {
+            clients.emplace_back([&]() {
+                sockaddr_in addr;
+                addr.sin_family = AF_INET;
+                addr.sin_port = htons(kPort);
+                addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+
+                char request[kRequestSize];
+                memset(request, 'q', sizeof(request));
+                char response[kHeaderSize + kBodySize];
+                std::vector<double> local;
+                for (int i = 0; i < numRequests; ++i)
+                {
+                    auto t0 = std::chrono::steady_clock::now();
+                    ::write(fd, request, sizeof(request));
+                    if (!readFull(fd, response, sizeof(response)))
+                    {
+                        break;
+                    }
+                    local.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+                }
+                ::close(fd);
+                std::unique_lock<std::mutex> lock(mutex);
+                rtts.insert(rtts.end(), local.begin(), local.end());
+            });
+        }
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::sort(rtts.begin(), rtts.end());
+        printf("%s: %zu requests, %.0f req/s, p50 %.0f us, p99 %.0f us, max %.0f us\n",
+               profile.c_str(), rtts.size(), rtts.size() / elapsed,
+               rtts[rtts.size() / 2], rtts[rtts.size() * 99 / 100], rtts.back());
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
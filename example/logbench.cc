@@ -0,0 +1,104 @@
+#include <szmuduo/Logger.h>
+#include <szmuduo/AsyncLogging.h>
+#include <szmuduo/BinaryLogging.h>
+
+#include <string>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**************************************************************************************
+ * 日志压测：多个线程同时调用 LOG_INFO，统计总吞吐和调用方单次调用耗时的分位数。
+ *
+ *  ./logbench [async|stdout|binary|off] [线程数] [每线程条数]
+ *      async ：AsyncLogging 写入当前目录下的 logbench.*.log（500MB 滚动）
+ *      stdout：默认输出到 stdout，建议重定向到文件或 /dev/null
+ *      binary：BinaryLogging 写入 logbench.blog，用 blogdecode 解码
+ *      off   ：运行期级别设为 ERROR，测量被关闭的 LOG_INFO 的开销
+**************************************************************************************/
+
+static void worker(int id, int count, std::vector<int64_t>* latencies)
+{
+    latencies->reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        LOG_INFO("logbench thread %d message %d: the quick brown fox jumps over the lazy dog", id, i);
+        auto end = std::chrono::steady_clock::now();
+        latencies->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* mode = argc > 1 ? argv[1] : "async";
+    bool async = strcmp(mode, "async") == 0;
+    int numThreads = argc > 2 ? atoi(argv[2]) : 16;
+    int count = argc > 3 ? atoi(argv[3]) : 100000;
+
+    AsyncLogging log("logbench", 500 * 1000 * 1000);
+    if (async)
+    {
+        log.start();
+        Logger::instance().setOutput(std::bind(&AsyncLogging::append, &log,
+                                               std::placeholders::_1, std::placeholders::_2));
+        Logger::instance().setFlush(std::bind(&AsyncLogging::flush, &log));
+    }
+    else if (strcmp(mode, "binary") == 0)
+    {
+        BinaryLogging::instance().start("logbench.blog");
+    }
+    else if (strcmp(mode, "off") == 0)
+    {
+        Logger::setLogLevel(ERROR);
+    }
+
+    std::vector<std::vector<int64_t>> latencies(numThreads);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back(worker, i, count, &latencies[i]);
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    Logger::instance().flush();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<int64_t> all;
+    for (const std::vector<int64_t>& v : latencies)
+    {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(all.size() * p))];
+    };
+
+    long total = static_cast<long>(numThreads) * count;
+    fprintf(stderr, "%s: %d threads, %ld messages in %.3f s, %.0f msg/s\n",
+            mode, numThreads, total, elapsed, total / elapsed);
+    fprintf(stderr, "caller latency ns: p50 %ld  p99 %ld  p99.9 %ld  max %ld\n",
+            percentile(0.5), percentile(0.99), percentile(0.999), all.empty() ? 0L : all.back());
+    if (async)
+    {
+        log.stop();
+        fprintf(stderr, "dropped bytes: %zu\n", log.droppedBytes());
+    }
+    if (BinaryLogging::active())
+    {
+        BinaryLogging::instance().stop();
+        fprintf(stderr, "dropped entries: %llu\n",
+                static_cast<unsigned long long>(BinaryLogging::instance().droppedEntries()));
+    }
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 过载保护测试：服务器每处理一个 64 字节请求要忙 200us，先建立一个探测连接每 10ms ping 一次，
+ * 1s 后一个客户端线程用非阻塞 connect 涌入大量连接（均匀穿插着只连接不发数据的空闲连接），每个活跃连接
+ * 收到回复后立即发下一个请求。比较涌入前后探测连接的往返时延。
+ *
+ *  ./overloadbench [none|capped] [涌入连接数] [其中空闲连接数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8041;
+static const size_t kRequestSize = 64;
+static const int kWorkMicros = 200;
+static const double kBaselineSeconds = 1.0;
+static const double kFloodSeconds = 3.0;
+
+using Clock = std::chrono::steady_clock;
+
+static void busyWork(int micros)
+{
+    auto end = Clock::now() + std::chrono::microseconds(micros);
+    while (Clock::now() < end)
+    {
+    }
+}
+
+static sockaddr_in serverAddr()
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    return addr;
+}
+
+static bool readFull(int fd, char* buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = ::read(fd, buf + got, len - got);
+        if (n <= 0)
+        {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static void report(const char* phase, std::vector<double>& rtts)
+{
+    if (rtts.empty())
+    {
+        printf("  %-8s no reply\n", phase);
+        return;
+    }
+    std::sort(rtts.begin(), rtts.end());
+    printf("  %-8s %4zu pings, p50 %7.0f us, p99 %7.0f us, max %7.0f us\n", phase, rtts.size(),
+           rtts[rtts.size() / 2], rtts[rtts.size() * 99 / 100], rtts.back());
+}
+
+// 涌入的连接：非阻塞 connect，活跃连接收到完整回复后立即发下一个请求
+static void flood(int numConns, int numIdle, const std::atomic_bool& stop, std::atomic<uint64_t>& served)
+{
+    sockaddr_in addr = serverAddr();
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<int> fds;
+    std::vector<size_t> received(numConns + 1, 0);
+    char request[kRequestSize];
+    memset(request, 'f', sizeof(request));
+
+    for (int i = 0; i < numConns; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+        fds.push_back(fd);
+        if (numIdle > 0 && i % (numConns / numIdle) == 0)
+        {
+            continue;
+        }
+        epoll_event ev;
+        ev.events = EPOLLOUT;
+        ev.data.u32 = i;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    std::vector<bool> sent(numConns, false);
+    epoll_event events[256];
+    char buf[4096];
+    while (!stop)
+    {
+        int n = ::epoll_wait(epfd, events, 256, 10);
+        for (int i = 0; i < n; ++i)
+        {
+            int idx = events[i].data.u32;
+            int fd = fds[idx];
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                continue;
+            }
+            if (!sent[idx])
+            {
+                // 连接建立，发第一个请求，之后只关心读
+                sent[idx] = true;
+                ::write(fd, request, sizeof(request));
+                epoll_event ev;
+                ev.events = EPOLLIN;
+                ev.data.u32 = idx;
+                ::epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+                continue;
+            }
+            ssize_t r = ::read(fd, buf, sizeof(buf));
+            if (r <= 0)
+            {
+                if (r == 0 || errno != EAGAIN)
+                {
+                    ::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                }
+                continue;
+            }
+            received[idx] += r;
+            while (received[idx] >= kRequestSize)
+            {
+                received[idx] -= kRequestSize;
+                ++served;
+                ::write(fd, request, sizeof(request));
+            }
+        }
+    }
+
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+    ::close(epfd);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "none";
+    int numConns = argc > 2 ? atoi(argv[2]) : 2000;
+    int numIdle = argc > 3 ? atoi(argv[3]) : 500;
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "OverloadBench");
+    server.setThreadNum(2);
+    if (mode == "capped")
+    {
+        server.setMaxConnections(512, 48);
+        server.setLoadShedding(0.01, 0.015, 0.5);
+    }
+
+    server.setMessageCalback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        while (buf->readableBytes() >= kRequestSize)
+        {
+            busyWork(kWorkMicros);
+            conn->send(buf->retrieveAsString(kRequestSize));
+        }
+    });
+    server.start();
+
+    std::vector<double> baseline;
+    std::vector<double> loaded;
+    std::atomic<uint64_t> served(0);
+    std::thread driver([&]() {
+        sockaddr_in addr = serverAddr();
+        int probe = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::connect(probe, (sockaddr*)&addr, sizeof(addr));
+
+        std::atomic_bool stop(false);
+        std::thread flooder;
+        char request[kRequestSize];
+        memset(request, 'p', sizeof(request));
+        char response[kRequestSize];
+        auto start = Clock::now();
+        while (true)
+        {
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            if (elapsed >= kBaselineSeconds + kFloodSeconds)
+            {
+                break;
+            }
+            if (elapsed >= kBaselineSeconds && !flooder.joinable())
+            {
+                flooder = std::thread(flood, numConns, numIdle, std::ref(stop), std::ref(served));
+            }
+
+            auto t0 = Clock::now();
+            ::write(probe, request, sizeof(request));
+            if (!readFull(probe, response, sizeof(response)))
+            {
+                break;
+            }
+            double rtt = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+            (flooder.joinable() ? loaded : baseline).push_back(rtt);
+            usleep(10000);
+        }
+
+        TcpServerStats stats = server.stats();
+        stop = true;
+        flooder.join();
+        ::close(probe);
+
+        printf("%s: flood %d connections (%d idle)\n", mode.c_str(), numConns, numIdle);
+        report("baseline", baseline);
+        report("flood", loaded);
+        printf("  served %lu flood requests, %zu connections, loop lag %ld us, shed %lu, accept %s\n",
+               served.load(), stats.connections, stats.loopLagMicros, stats.shedConnections,
+               stats.acceptPaused ? "paused" : "open");
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
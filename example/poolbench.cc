@@ -0,0 +1,278 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/TcpClient.h>
+#include <szmuduo/ConnectionPool.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 出站连接池压测：本地代理把客户端的每个请求（固定长度）转发给后端，收到后端的响应
+ * 后回给客户端。pooled 模式从代理 IO loop 的 ConnectionPool 借出预热的连接，fresh 模式
+ * 每个请求用 TcpClient 新建一个到后端的连接，用完关闭。客户端线程用阻塞 socket 逐个
+ * 发送请求，统计每秒请求数和往返时延。
+ *
+ *  ./poolbench [pooled|fresh] [客户端连接数] [秒数] [请求字节数]
+**************************************************************************************/
+
+static const uint16_t kBackendPort = 8045;
+static const uint16_t kProxyPort = 8046;
+
+static size_t g_messageSize = 64;
+static bool g_pooled = true;
+
+// 代理 IO 线程的连接池，只在该线程中访问
+static thread_local ConnectionPool* t_pool = nullptr;
+static std::mutex g_poolsMutex;
+static std::vector<std::pair<EventLoop*, ConnectionPool*>> g_pools;
+
+// 一个客户端连接的代理状态，只在代理 IO 线程中访问
+struct Session
+{
+    TcpConnectionWeakPtr client;
+    std::shared_ptr<TcpClient> fresh;       // fresh 模式下本次请求的后端连接
+};
+using SessionPtr = std::shared_ptr<Session>;
+
+// 后端：原样返回收到的数据
+static void onBackendMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    conn->send(buf);
+}
+
+// 代理收到后端的完整响应：回给客户端，归还或关闭后端连接
+static void onUpstreamMessage(const TcpConnectionPtr& backend, Buffer* buf, Timestamp)
+{
+    if (buf->readableBytes() < g_messageSize)
+    {
+        return;
+    }
+    std::string response = buf->retrieveAsString(g_messageSize);
+    SessionPtr session = std::static_pointer_cast<Session>(backend->getContext());
+    backend->setContext(std::shared_ptr<void>());
+    if (g_pooled)
+    {
+        t_pool->checkin(backend);
+    }
+    else if (session && session->fresh)
+    {
+        // 正在该 TcpClient 的回调中，延后析构（析构时关闭连接）
+        std::shared_ptr<TcpClient> fresh;
+        fresh.swap(session->fresh);
+        backend->getLoop()->queueInLoop([fresh]() {});
+    }
+
+    TcpConnectionPtr client = session ? session->client.lock() : TcpConnectionPtr();
+    if (client)
+    {
+        client->send(response);
+    }
+}
+
+static void forward(const TcpConnectionPtr& client, const SessionPtr& session, const std::string& request)
+{
+    if (g_pooled)
+    {
+        t_pool->checkout([client, session, request](const TcpConnectionPtr& backend) {
+            if (!backend)
+            {
+                client->shutdown();
+                return;
+            }
+            backend->setContext(session);
+            backend->send(request);
+        });
+        return;
+    }
+
+    std::shared_ptr<TcpClient> fresh = std::make_shared<TcpClient>(
+        client->getLoop(), InetAddress(kBackendPort), "fresh");
+    fresh->setConnectionCallback([session, request](const TcpConnectionPtr& backend) {
+        if (backend->connected())
+        {
+            backend->setTcpNoDelay(true);
+            backend->setContext(session);
+            backend->send(request);
+        }
+    });
+    fresh->setMessageCallback(onUpstreamMessage);
+    session->fresh = fresh;
+    fresh->connect();
+}
+
+static void onClientConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        conn->setTcpNoDelay(true);
+        SessionPtr session = std::make_shared<Session>();
+        session->client = conn;
+        conn->setContext(session);
+    }
+}
+
+static void onClientMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    SessionPtr session = std::static_pointer_cast<Session>(conn->getContext());
+    while (session && buf->readableBytes() >= g_messageSize)
+    {
+        forward(conn, session, buf->retrieveAsString(g_messageSize));
+    }
+}
+
+static void runClient(double seconds, std::atomic<uint64_t>& completed,
+                      std::vector<int64_t>& latencies, std::mutex& mutex)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kProxyPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    std::string request(g_messageSize, 'q');
+    std::vector<char> response(g_messageSize);
+    std::vector<int64_t> local;
+    int64_t deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        int64_t start = Timestamp::monotonicMicros();
+        if (::write(fd, request.data(), request.size()) != (ssize_t)request.size())
+        {
+            break;
+        }
+        size_t got = 0;
+        while (got < g_messageSize)
+        {
+            ssize_t n = ::read(fd, response.data() + got, g_messageSize - got);
+            if (n <= 0)
+            {
+                break;
+            }
+            got += n;
+        }
+        if (got < g_messageSize)
+        {
+            break;
+        }
+        local.push_back(Timestamp::monotonicMicros() - start);
+    }
+    ::close(fd);
+
+    completed += local.size();
+    std::lock_guard<std::mutex> lock(mutex);
+    latencies.insert(latencies.end(), local.begin(), local.end());
+}
+
+int main(int argc, char* argv[])
+{
+    g_pooled = !(argc > 1 && strcmp(argv[1], "fresh") == 0);
+    int numClients = argc > 2 ? atoi(argv[2]) : 8;
+    double seconds = argc > 3 ? atof(argv[3]) : 1.0;
+    g_messageSize = argc > 4 ? atoi(argv[4]) : 64;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+
+    TcpServer backend(&loop, InetAddress(kBackendPort), "Backend");
+    backend.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    backend.setMessageCalback(onBackendMessage);
+    backend.setThreadNum(1);
+    backend.start();
+
+    TcpServer proxy(&loop, InetAddress(kProxyPort), "Proxy");
+    proxy.setThreadInitCallback([](EventLoop* ioLoop) {
+        if (!g_pooled)
+        {
+            return;
+        }
+        t_pool = new ConnectionPool(ioLoop, InetAddress(kBackendPort), "pool");
+        t_pool->setMinIdle(8);
+        t_pool->setMessageCallback(onUpstreamMessage);
+        t_pool->start();
+        std::lock_guard<std::mutex> lock(g_poolsMutex);
+        g_pools.push_back(std::make_pair(ioLoop, t_pool));
+    });
+    proxy.setConnectionCallback(onClientConnection);
+    proxy.setMessageCalback(onClientMessage);
+    proxy.setThreadNum(1);
+    proxy.start();
+
+    std::thread driver([&]() {
+        usleep(100 * 1000);     // 等待连接池预热
+        std::atomic<uint64_t> completed(0);
+        std::vector<int64_t> latencies;
+        std::mutex mutex;
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numClients; ++i)
+        {
+            clients.emplace_back(runClient, seconds, std::ref(completed), std::ref(latencies), std::ref(mutex));
+        }
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        if (latencies.empty())
+        {
+            printf("no response\n");
+        }
+        else
+        {
+            printf("%s: %d clients, %.0f req/s, p50 %lld us, p99 %lld us\n",
+                   g_pooled ? "pooled" : "fresh", numClients, completed.load() / seconds,
+                   (long long)latencies[latencies.size() / 2],
+                   (long long)latencies[latencies.size() * 99 / 100]);
+        }
+
+        // 连接池在所属 IO 线程中打印统计并析构
+        for (auto& item : g_pools)
+        {
+            ConnectionPool* pool = item.second;
+            std::promise<void> destroyed;
+            item.first->runInLoop([pool, &destroyed]() {
+                ConnectionPool::Stats stats = pool->stats();
+                printf("pool: created %llu, reused %llu, evicted %llu, idle %zu\n",
+                       (unsigned long long)stats.created, (unsigned long long)stats.reused,
+                       (unsigned long long)stats.evicted, stats.idle);
+                delete pool;
+                destroyed.set_value();
+            });
+            destroyed.get_future().wait();
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
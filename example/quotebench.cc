@@ -0,0 +1,123 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 低延迟发送测试：服务器每 200us 推送一条 256 字节的行情，客户端每 1ms 才读一条，
+ * 消费速度跟不上。统计客户端收到的行情的“年龄”（发出到收到的时间）。
+ *     normal ：普通发送，积压的旧行情先占满内核缓冲区，再堆在 outputBuffer 中
+ *     lowlat ：setLowLatencySend(4KB)，每次推送前丢弃队列中还没开始发送的旧行情
+ *
+ *  ./quotebench [normal|lowlat] [秒数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8039;
+static const size_t kQuoteSize = 256;
+
+struct Quote
+{
+    int64_t sentMicros;
+    int64_t seq;
+    char padding[kQuoteSize - 16];
+};
+
+int main(int argc, char* argv[])
+{
+    bool lowLatency = argc > 1 && strcmp(argv[1], "lowlat") == 0;
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "QuoteBench");
+    if (lowLatency)
+    {
+        server.setLowLatencySend(4096);
+    }
+
+    TcpConnectionPtr subscriber;
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        subscriber = conn->connected() ? conn : TcpConnectionPtr();
+    });
+    server.start();
+
+    int64_t seq = 0;
+    size_t discarded = 0;
+    loop.runEvery(0.0002, [&]() {
+        if (!subscriber)
+        {
+            return;
+        }
+        if (lowLatency)
+        {
+            discarded += subscriber->discardPendingOutput();     // 旧行情不再有意义
+        }
+        Quote quote;
+        memset(&quote, 0, sizeof(quote));
+        quote.sentMicros = Timestamp::monotonicMicros();
+        quote.seq = ++seq;
+        subscriber->send(std::string(reinterpret_cast<const char*>(&quote), sizeof(quote)));
+    });
+
+    std::thread client([&]() {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int rcvbuf = 4096;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr;
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+
+        std::vector<double> ages;
+        int64_t lastSeq = 0;
+        int64_t skipped = 0;
+        int64_t deadline = Timestamp::monotonicMicros() + seconds * Timestamp::kMicroSecondsPerSecond;
+        while (Timestamp::monotonicMicros() < deadline)
+        {
+            Quote quote;
+            size_t got = 0;
+            while (got < sizeof(quote))
+            {
+                ssize_t n = ::read(fd, reinterpret_cast<char*>(&quote) + got, sizeof(quote) - got);
+                if (n <= 0)
+                {
+                    break;
+                }
+                got += n;
+            }
+            ages.push_back((Timestamp::monotonicMicros() - quote.sentMicros) / 1000.0);
+            skipped += quote.seq - lastSeq - 1;
+            lastSeq = quote.seq;
+            ::usleep(1000);     // 慢消费者
+        }
+        ::close(fd);
+
+        std::vector<double> last(ages.end() - ages.size() / 3, ages.end());    // 最后三分之一
+        std::sort(last.begin(), last.end());
+        printf("%s: received %zu quotes, skipped %ld, age of last third p50 %.1f ms max %.1f ms\n",
+               lowLatency ? "lowlat" : "normal", ages.size(), static_cast<long>(skipped),
+               last[last.size() / 2], last.back());
+        loop.queueInLoop([&]() {
+            if (lowLatency)
+            {
+                printf("server discarded %zu bytes of stale quotes\n", discarded);
+            }
+            loop.quit();
+        });
+    });
+
+    loop.loop();
+    client.join();
+    return 0;
+}
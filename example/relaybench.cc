@@ -0,0 +1,265 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/TcpClient.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/CurrentThread.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * TCP 转发压测：source --> proxy --> sink，全部在本机回环上。
+ *     source 线程用阻塞 socket 连续发送 seconds 秒后半关闭；proxy 为每个连接建立一个到
+ * sink 的连接并转发；sink 统计收到的字节数。source 最后读到 EOF 说明半关闭经过代理
+ * 正确传递。除吞吐量外还统计代理 IO 线程消耗的 CPU 时间（每 GB 数据）。
+ *     splice    TcpConnection::relay，两个连接在同一个 loop 上，splice 经管道转发
+ *     buffered  应用自己转发：messageCallback 中 send(buf)，水位线背压（两次用户态拷贝）
+ *     cross     TcpConnection::relay，两个连接在不同 loop 上，回退到缓冲转发
+ *
+ *  ./relaybench [splice|buffered|cross] [连接数] [秒数]
+**************************************************************************************/
+
+static const uint16_t kSinkPort = 8047;
+static const uint16_t kProxyPort = 8048;
+static const size_t kChunk = 64 * 1024;
+
+static std::string g_mode = "splice";
+static std::atomic<uint64_t> g_sinkBytes(0);
+static std::atomic<int> g_sinkClosed(0);
+static std::mutex g_loopsMutex;
+static std::vector<EventLoop*> g_proxyLoops;
+static std::vector<int> g_proxyTids;
+
+// 线程消耗的 CPU 时间（秒），读 /proc/self/task/<tid>/stat 的 utime + stime
+static double threadCpuSeconds(int tid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr)
+    {
+        return 0;
+    }
+    char line[1024];
+    size_t n = fread(line, 1, sizeof(line) - 1, fp);
+    fclose(fp);
+    line[n] = '\0';
+    // 线程名之后（")" 之后）依次是 state ppid ... utime(第 14 项) stime(第 15 项)
+    const char* p = strrchr(line, ')');
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    if (p == nullptr || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+    {
+        return 0;
+    }
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static double proxyCpuSeconds()
+{
+    std::lock_guard<std::mutex> lock(g_loopsMutex);
+    double total = 0;
+    for (int tid : g_proxyTids)
+    {
+        total += threadCpuSeconds(tid);
+    }
+    return total;
+}
+
+static void onSinkMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+    g_sinkBytes += buf->readableBytes();
+    buf->retrieveAll();
+}
+
+static void onSinkConnection(const TcpConnectionPtr& conn)
+{
+    if (!conn->connected())
+    {
+        ++g_sinkClosed;
+    }
+}
+
+// 应用自己转发：把 from 收到的数据 send 给 to，to 积压时暂停读取 from
+static void forwardBuffered(const TcpConnectionPtr& from, const TcpConnectionPtr& to)
+{
+    TcpConnectionWeakPtr weakTo(to);
+    from->setMessageCallback([weakTo](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        TcpConnectionPtr target = weakTo.lock();
+        if (target)
+        {
+            target->send(buf);
+        }
+        else
+        {
+            buf->retrieveAll();
+        }
+    });
+    to->setWaterMarks(1024 * 1024, 256 * 1024, false);
+    to->addProducer(from);
+}
+
+static void onProxyConnection(const TcpConnectionPtr& conn)
+{
+    if (!conn->connected())
+    {
+        return;
+    }
+
+    // 后端连上之前先不读
+    conn->stopRead();
+    EventLoop* backendLoop = conn->getLoop();
+    if (g_mode == "cross")
+    {
+        std::lock_guard<std::mutex> lock(g_loopsMutex);
+        for (EventLoop* loop : g_proxyLoops)
+        {
+            if (loop != conn->getLoop())
+            {
+                backendLoop = loop;
+                break;
+            }
+        }
+    }
+
+    // TcpClient 由自己的连接回调持有，后端连接断开（转发结束）后在 loop 中析构
+    std::shared_ptr<TcpClient> client = std::make_shared<TcpClient>(backendLoop, InetAddress(kSinkPort), "backend");
+    std::shared_ptr<std::shared_ptr<TcpClient>> holder = std::make_shared<std::shared_ptr<TcpClient>>(client);
+    TcpConnectionWeakPtr weakConn(conn);
+    client->setConnectionCallback([weakConn, holder](const TcpConnectionPtr& backend) {
+        if (!backend->connected())
+        {
+            std::shared_ptr<TcpClient> self;
+            self.swap(*holder);
+            backend->getLoop()->queueInLoop([self]() {});
+            return;
+        }
+        TcpConnectionPtr front = weakConn.lock();
+        if (!front)
+        {
+            backend->shutdown();
+            return;
+        }
+        if (g_mode == "buffered")
+        {
+            forwardBuffered(front, backend);
+            forwardBuffered(backend, front);
+        }
+        else
+        {
+            TcpConnection::relay(front, backend);
+        }
+        front->startRead();
+    });
+    client->connect();
+}
+
+static void runSource(double seconds, uint64_t* sent, bool* gotEof)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kProxyPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    std::string chunk(kChunk, 'r');
+    int64_t deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        ssize_t n = ::write(fd, chunk.data(), chunk.size());
+        if (n <= 0)
+        {
+            break;
+        }
+        *sent += n;
+    }
+    ::shutdown(fd, SHUT_WR);
+
+    // sink 读到 EOF 后关闭，经过代理传回 EOF
+    char buf[256];
+    while (::read(fd, buf, sizeof(buf)) > 0)
+    {
+    }
+    *gotEof = true;
+    ::close(fd);
+}
+
+int main(int argc, char* argv[])
+{
+    g_mode = argc > 1 ? argv[1] : "splice";
+    int numConns = argc > 2 ? atoi(argv[2]) : 1;
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+
+    TcpServer sink(&loop, InetAddress(kSinkPort), "Sink");
+    sink.setConnectionCallback(onSinkConnection);
+    sink.setMessageCalback(onSinkMessage);
+    sink.setThreadNum(1);
+    sink.start();
+
+    TcpServer proxy(&loop, InetAddress(kProxyPort), "Proxy");
+    proxy.setThreadInitCallback([](EventLoop* ioLoop) {
+        std::lock_guard<std::mutex> lock(g_loopsMutex);
+        g_proxyLoops.push_back(ioLoop);
+        g_proxyTids.push_back(CurrentThread::tid());
+    });
+    proxy.setConnectionCallback(onProxyConnection);
+    proxy.setThreadNum(2);
+    proxy.start();
+
+    std::thread driver([&]() {
+        usleep(100 * 1000);
+        std::vector<uint64_t> sent(numConns, 0);
+        std::unique_ptr<bool[]> gotEof(new bool[numConns]());
+        int64_t start = Timestamp::monotonicMicros();
+        double cpuStart = proxyCpuSeconds();
+        std::vector<std::thread> sources;
+        for (int i = 0; i < numConns; ++i)
+        {
+            sources.emplace_back(runSource, seconds, &sent[i], &gotEof[i]);
+        }
+        for (std::thread& t : sources)
+        {
+            t.join();
+        }
+        double elapsed = (Timestamp::monotonicMicros() - start) / 1e6;
+        double cpu = proxyCpuSeconds() - cpuStart;
+
+        uint64_t total = 0;
+        int eofs = 0;
+        for (int i = 0; i < numConns; ++i)
+        {
+            total += sent[i];
+            eofs += gotEof[i] ? 1 : 0;
+        }
+        printf("%s: %d connections, %.0f MB/s, proxy cpu %.2f s/GB, sent %llu, received %llu, half-close %d/%d\n",
+               g_mode.c_str(), numConns, g_sinkBytes.load() / elapsed / 1e6,
+               g_sinkBytes.load() > 0 ? cpu / (g_sinkBytes.load() / 1e9) : 0.0,
+               (unsigned long long)total, (unsigned long long)g_sinkBytes.load(), eofs, numConns);
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
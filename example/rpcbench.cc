@@ -0,0 +1,236 @@
+#include <szmuduo/RpcServer.h>
+#include <szmuduo/RpcClient.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/EventLoopThread.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/**************************************************************************************
+ * RpcServer / RpcClient 压测：服务器注册两个方法，kEcho 在 IO 线程中直接回复，
+ * kAsyncEcho 交给工作线程回复（响应乱序）。客户端 loop 上的每个连接始终保持 depth 个
+ * 未完成的调用，一个调用完成立即发起下一个，统计每秒调用数和调用时延。
+ *
+ *  ./rpcbench [inline|async] [连接数] [depth，不指定时依次测 1 ~ 1024] [秒数] [正文字节数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8044;
+static const uint32_t kEcho = 1;
+static const uint32_t kAsyncEcho = 2;
+
+// 最简单的工作线程池：异步处理函数在这里回复
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int numThreads) : quit_(false)
+    {
+        for (int i = 0; i < numThreads; ++i)
+        {
+            threads_.emplace_back([this]() { work(); });
+        }
+    }
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cond_.notify_all();
+        for (std::thread& t : threads_)
+        {
+            t.join();
+        }
+    }
+
+    void run(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+private:
+    void work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return quit_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_;
+    bool quit_;
+    std::vector<std::thread> threads_;
+};
+
+// 一轮压测的状态，除 running / inflight 外只在客户端 loop 线程中访问
+struct Round
+{
+    uint32_t method;
+    std::string payload;
+    std::atomic<bool> running;
+    std::atomic<int> inflight;
+    uint64_t completed;
+    uint64_t failed;
+    std::vector<int64_t> latencies;
+};
+
+static void issue(Round* round, RpcClient* client)
+{
+    int64_t start = Timestamp::monotonicMicros();
+    ++round->inflight;
+    client->call(round->method, round->payload, [round, client, start](uint16_t status, const StringPiece&) {
+        if (round->running)
+        {
+            if (status == RpcCodec::kOk)
+            {
+                ++round->completed;
+                round->latencies.push_back(Timestamp::monotonicMicros() - start);
+            }
+            else
+            {
+                ++round->failed;
+            }
+            issue(round, client);
+        }
+        --round->inflight;
+    });
+}
+
+static void runRound(EventLoop* clientLoop, std::vector<std::unique_ptr<RpcClient>>& clients,
+                     uint32_t method, int depth, double seconds, size_t payloadSize)
+{
+    Round round;
+    round.method = method;
+    round.payload.assign(payloadSize, 'x');
+    round.running = true;
+    round.inflight = 0;
+    round.completed = 0;
+    round.failed = 0;
+
+    clientLoop->runInLoop([&]() {
+        for (auto& client : clients)
+        {
+            for (int i = 0; i < depth; ++i)
+            {
+                issue(&round, client.get());
+            }
+        }
+    });
+    usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+    round.running = false;
+    while (round.inflight > 0)
+    {
+        usleep(1000);
+    }
+
+    std::sort(round.latencies.begin(), round.latencies.end());
+    if (round.latencies.empty())
+    {
+        printf("depth %4d: no response\n", depth);
+        return;
+    }
+    printf("depth %4d: %8.0f calls/s, p50 %6lld us, p99 %6lld us, failed %llu\n",
+           depth, round.completed / seconds,
+           (long long)round.latencies[round.latencies.size() / 2],
+           (long long)round.latencies[round.latencies.size() * 99 / 100],
+           (unsigned long long)round.failed);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "inline";
+    int numConns = argc > 2 ? atoi(argv[2]) : 4;
+    int onlyDepth = argc > 3 ? atoi(argv[3]) : 0;
+    double seconds = argc > 4 ? atof(argv[4]) : 2.0;
+    size_t payloadSize = argc > 5 ? atoi(argv[5]) : 64;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+    WorkerPool workers(2);
+    RpcServer server(&loop, InetAddress(kPort), "RpcBench");
+    server.setThreadNum(2);
+    server.registerMethod(kEcho, [](const RpcRequest& req, const RpcResponder& resp) {
+        resp.reply(req.payload);
+    });
+    server.registerMethod(kAsyncEcho, [&workers](const RpcRequest& req, const RpcResponder& resp) {
+        std::string arg = req.payload.toString();
+        workers.run([arg, resp]() { resp.reply(arg); });
+    });
+    server.start();
+
+    std::thread driver([&]() {
+        EventLoopThread clientThread;
+        EventLoop* clientLoop = clientThread.startLoop();
+        std::vector<std::unique_ptr<RpcClient>> clients;
+        for (int i = 0; i < numConns; ++i)
+        {
+            clients.emplace_back(new RpcClient(clientLoop, InetAddress(kPort), "RpcBenchClient"));
+            clients.back()->connect();
+        }
+        for (auto& client : clients)
+        {
+            while (!client->connected())
+            {
+                usleep(1000);
+            }
+        }
+
+        uint32_t method = mode == "async" ? kAsyncEcho : kEcho;
+        printf("%s, %d connections, %zu byte payload\n", mode.c_str(), numConns, payloadSize);
+        std::vector<int> depths;
+        if (onlyDepth > 0)
+        {
+            depths.push_back(onlyDepth);
+        }
+        else
+        {
+            depths = { 1, 4, 16, 64, 256, 1024 };
+        }
+        for (int depth : depths)
+        {
+            runRound(clientLoop, clients, method, depth, seconds, payloadSize);
+        }
+
+        // RpcClient 在客户端 loop 线程中析构
+        std::promise<void> destroyed;
+        clientLoop->runInLoop([&]() {
+            clients.clear();
+            destroyed.set_value();
+        });
+        destroyed.get_future().wait();
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * 发送限速测试：服务器对每个连接不停发送，客户端统计实际收到的速率。
+ * 第二阶段在运行中把服务器整体限速减半，检查修改是否立即生效。
+ *
+ *  ./shapebench [每连接限速 KB/s] [服务器限速 KB/s] [连接数] [每阶段秒数]
+ *      限速为 0 表示不限制
+**************************************************************************************/
+
+static const uint16_t kPort = 8038;
+
+int main(int argc, char* argv[])
+{
+    double connRate = (argc > 1 ? atof(argv[1]) : 512) * 1024;
+    double serverRate = (argc > 2 ? atof(argv[2]) : 2048) * 1024;
+    int numConns = argc > 3 ? atoi(argv[3]) : 8;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "ShapeBench");
+    server.setThreadNum(2);
+    server.setConnectionRateLimit(connRate);
+    server.setRateLimit(serverRate);
+
+    const std::string chunk(64 * 1024, 'x');
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->send(chunk);
+        }
+    });
+    // 每次写完再发一块，保证发送队列一直有数据
+    server.setWriteCompleteCallback([&](const TcpConnectionPtr& conn) {
+        conn->send(chunk);
+    });
+    server.start();
+
+    std::thread client([&]() {
+        sockaddr_in addr;
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+        int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        std::vector<long> received(numConns, 0);
+        for (int i = 0; i < numConns; ++i)
+        {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+            epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u64 = (static_cast<uint64_t>(i) << 32) | static_cast<uint32_t>(fd);
+            ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        }
+
+        char buf[65536];
+        for (int phase = 0; phase < 2; ++phase)
+        {
+            if (phase == 1)
+            {
+                serverRate /= 2;
+                server.setRateLimit(serverRate);
+            }
+            std::fill(received.begin(), received.end(), 0);
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + std::chrono::seconds(seconds);
+            while (std::chrono::steady_clock::now() < end)
+            {
+                epoll_event events[64];
+                int n = ::epoll_wait(epfd, events, 64, 10);
+                for (int i = 0; i < n; ++i)
+                {
+                    int fd = static_cast<int>(events[i].data.u64 & 0xffffffff);
+                    ssize_t len = ::read(fd, buf, sizeof(buf));
+                    if (len > 0)
+                    {
+                        received[events[i].data.u64 >> 32] += len;
+                    }
+                }
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            long total = 0;
+            for (long r : received)
+            {
+                total += r;
+            }
+            auto mm = std::minmax_element(received.begin(), received.end());
+            printf("phase %d: server limit %.0f KB/s, connection limit %.0f KB/s\n",
+                   phase + 1, serverRate / 1024, connRate / 1024);
+            printf("  total %.0f KB/s, per connection min %.0f KB/s max %.0f KB/s\n",
+                   total / elapsed / 1024, *mm.first / elapsed / 1024, *mm.second / elapsed / 1024);
+        }
+        printf("bytes written under the server limit: %lu\n",
+               static_cast<unsigned long>(server.stats().rateLimitedBytes));
+        ::close(epfd);
+        loop.quit();
+    });
+
+    loop.loop();
+    client.join();
+    return 0;
+}
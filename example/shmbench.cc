@@ -0,0 +1,228 @@
+#include <szmuduo/ShmServer.h>
+#include <szmuduo/ShmClient.h>
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/TcpClient.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/InetAddress.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+/**************************************************************************************
+ * 同机两个进程之间的往返时延：fork 出的服务器进程原样返回收到的数据，客户端进程收齐
+ * 回复后再发下一个请求，两端都在 EventLoop 中。统计每秒往返次数、时延，以及两个进程
+ * 每次往返共消耗的 CPU 时间。
+ *     shm       ShmServer / ShmClient，共享内存环 + eventfd
+ *     tcp       TcpServer / TcpClient，127.0.0.1
+ *     unix      TcpServer / TcpClient，抽象命名空间的 Unix 域 socket
+ * busypoll 为 shm 两端读空后继续轮询的微秒数（0 不轮询），同时输出两端写 eventfd 和
+ * 省掉的通知次数。
+ *
+ *  ./shmbench [shm|tcp|unix] [秒数] [消息字节数] [busypoll 微秒]
+**************************************************************************************/
+
+static const uint16_t kPort = 8051;
+
+static double cpuSeconds(int who)
+{
+    rusage usage;
+    ::getrusage(who, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static InetAddress serverAddress(const std::string& mode)
+{
+    if (mode == "tcp")
+    {
+        return InetAddress(kPort, "127.0.0.1");
+    }
+    return InetAddress::unixPath("@szmuduo-shmbench-" + mode);
+}
+
+// 服务器进程：第一个连接断开后退出，打印本端通知次数
+static void runServer(const std::string& mode, int busyPoll)
+{
+    EventLoop loop;
+    InetAddress addr = serverAddress(mode);
+    if (mode == "shm")
+    {
+        ShmServer server(&loop, addr, "ShmBench");
+        server.setBusyPoll(busyPoll);
+        server.setConnectionCallback([&loop](const ShmConnectionPtr& conn) {
+            if (!conn->connected())
+            {
+                printf("  server wakeups sent %llu, skipped %llu\n",
+                       (unsigned long long)conn->wakeupsSent(), (unsigned long long)conn->wakeupsSkipped());
+                loop.quit();
+            }
+        });
+        server.setMessageCallback([](const ShmConnectionPtr& conn, Buffer* buf, Timestamp) {
+            conn->send(buf);
+        });
+        server.start();
+        loop.loop();
+    }
+    else
+    {
+        TcpServer server(&loop, addr, "ShmBench");
+        server.setConnectionCallback([&loop](const TcpConnectionPtr& conn) {
+            if (conn->connected())
+            {
+                conn->setTcpNoDelay(true);
+            }
+            else
+            {
+                loop.quit();
+            }
+        });
+        server.setMessageCalback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+            conn->send(buf);
+        });
+        server.start();
+        loop.loop();
+    }
+}
+
+// 客户端：收齐 size 字节的回复后记录时延，再发下一个请求
+struct PingPong
+{
+    size_t size;
+    int64_t deadline;
+    int64_t start;
+    std::string request;
+    std::vector<int64_t> latencies;
+
+    // 返回 false 表示时间到，不再发送
+    bool onMessage(Buffer* buf)
+    {
+        if (buf->readableBytes() < size)
+        {
+            return true;
+        }
+        buf->retrieve(size);
+        int64_t now = Timestamp::monotonicMicros();
+        latencies.push_back(now - start);
+        start = now;
+        return now < deadline;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "shm";
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    size_t size = argc > 3 ? atoi(argv[3]) : 64;
+    int busyPoll = argc > 4 ? atoi(argv[4]) : 0;
+
+    Logger::setLogLevel(FATAL);
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        runServer(mode, busyPoll);
+        return 0;
+    }
+    usleep(100 * 1000);
+
+    EventLoop loop;
+    InetAddress addr = serverAddress(mode);
+    PingPong ping;
+    ping.size = size;
+    ping.request.assign(size, 'q');
+    double cpuStart = cpuSeconds(RUSAGE_SELF);
+    uint64_t wakeupsSent = 0;
+    uint64_t wakeupsSkipped = 0;
+
+    if (mode == "shm")
+    {
+        ShmClient client(&loop, addr, "ShmBench");
+        client.setBusyPoll(busyPoll);
+        client.setConnectionCallback([&](const ShmConnectionPtr& conn) {
+            if (conn->connected())
+            {
+                ping.deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+                ping.start = Timestamp::monotonicMicros();
+                conn->send(ping.request);
+            }
+            else
+            {
+                wakeupsSent = conn->wakeupsSent();
+                wakeupsSkipped = conn->wakeupsSkipped();
+                loop.quit();
+            }
+        });
+        client.setMessageCallback([&](const ShmConnectionPtr& conn, Buffer* buf, Timestamp) {
+            if (ping.onMessage(buf))
+            {
+                conn->send(ping.request);
+            }
+            else
+            {
+                conn->shutdown();
+            }
+        });
+        client.connect();
+        loop.loop();
+    }
+    else
+    {
+        TcpClient client(&loop, addr, "ShmBench");
+        client.setConnectionCallback([&](const TcpConnectionPtr& conn) {
+            if (conn->connected())
+            {
+                conn->setTcpNoDelay(true);
+                ping.deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+                ping.start = Timestamp::monotonicMicros();
+                conn->send(ping.request);
+            }
+            else
+            {
+                loop.quit();
+            }
+        });
+        client.setMessageCallback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+            if (ping.onMessage(buf))
+            {
+                conn->send(ping.request);
+            }
+            else
+            {
+                conn->shutdown();
+            }
+        });
+        client.connect();
+        loop.loop();
+    }
+    // 客户端半关闭后服务器关闭连接并退出，客户端读到 EOF 后退出 loop
+
+    double cpu = cpuSeconds(RUSAGE_SELF) - cpuStart;
+    ::waitpid(pid, nullptr, 0);
+    cpu += cpuSeconds(RUSAGE_CHILDREN);
+
+    std::vector<int64_t>& latencies = ping.latencies;
+    std::sort(latencies.begin(), latencies.end());
+    if (latencies.empty())
+    {
+        printf("%s: no response\n", mode.c_str());
+        return 1;
+    }
+    printf("%-5s busypoll %d us, %zu bytes: %.0f round trips/s, p50 %lld us, p99 %lld us, cpu %.1f us/round trip\n",
+           mode.c_str(), busyPoll, size, latencies.size() / seconds,
+           (long long)latencies[latencies.size() / 2],
+           (long long)latencies[latencies.size() * 99 / 100],
+           cpu * 1e6 / latencies.size());
+    if (mode == "shm")
+    {
+        printf("  client wakeups sent %llu, skipped %llu\n",
+               (unsigned long long)wakeupsSent, (unsigned long long)wakeupsSkipped);
+    }
+    return 0;
+}
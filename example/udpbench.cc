@@ -0,0 +1,209 @@
+#include <szmuduo/UdpServer.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+/**************************************************************************************
+ * UdpServer 压测：服务器把收到的每个数据报原样发回。每个客户端线程一个 socket，
+ * 每次发出 window 个数据报，收齐回复（或等待超时，视为丢包）后再发下一批，统计每秒
+ * 收到的回复数，以及服务器每次 recvmmsg / sendmmsg 平均处理的数据报数。
+ *     batch    服务器一次 recvmmsg 最多收的数据报数（1 即逐个 recvmsg）
+ *     offload  on 时客户端和服务器都开启 GSO 发送、GRO 接收
+ *
+ *  ./udpbench [batch] [offload on|off] [客户端数] [秒数] [数据报字节数] [window] [IO 线程数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8049;
+
+static size_t countSegments(const msghdr& hdr, size_t len)
+{
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&hdr); cm != nullptr; cm = CMSG_NXTHDR(const_cast<msghdr*>(&hdr), cm))
+    {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+        {
+            int segment = 0;
+            memcpy(&segment, CMSG_DATA(cm), sizeof(segment));
+            if (segment > 0)
+            {
+                return (len + segment - 1) / segment;
+            }
+        }
+    }
+    return 1;
+}
+
+static void runClient(double seconds, size_t payload, size_t window, bool offload, uint64_t* replies, uint64_t* lost)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    timeval timeout = { 0, 100 * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (offload)
+    {
+        // 一次 send 多个数据报，由内核按 payload 切分；回复按 GRO 合并后收取
+        int segment = static_cast<int>(payload);
+        int on = 1;
+        ::setsockopt(fd, SOL_UDP, UDP_SEGMENT, &segment, sizeof(segment));
+        ::setsockopt(fd, SOL_UDP, UDP_GRO, &on, sizeof(on));
+    }
+
+    // 一次 GSO send 不超过 UDP 数据报的最大长度，段数不超过内核的 UDP_MAX_SEGMENTS（64）
+    size_t segmentsPerSend = std::min<size_t>(64, std::max<size_t>(1, 65507 / payload));
+
+    std::string out(payload * window, 'u');
+    std::vector<mmsghdr> sendMsgs(window);
+    std::vector<iovec> sendIov(window);
+    for (size_t i = 0; i < window; ++i)
+    {
+        sendIov[i].iov_base = &out[i * payload];
+        sendIov[i].iov_len = payload;
+        memset(&sendMsgs[i].msg_hdr, 0, sizeof(msghdr));
+        sendMsgs[i].msg_hdr.msg_iov = &sendIov[i];
+        sendMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const size_t slot = 65536;
+    const size_t controlSpace = CMSG_SPACE(sizeof(int));
+    std::vector<char> in(window * slot);
+    std::vector<char> control(window * controlSpace);
+    std::vector<mmsghdr> recvMsgs(window);
+    std::vector<iovec> recvIov(window);
+
+    int64_t deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        if (offload)
+        {
+            bool failed = false;
+            for (size_t sent = 0; sent < window && !failed; sent += segmentsPerSend)
+            {
+                size_t n = std::min(segmentsPerSend, window - sent);
+                if (::send(fd, &out[sent * payload], n * payload, 0) < 0)
+                {
+                    perror("send");
+                    failed = true;
+                }
+            }
+            if (failed)
+            {
+                break;
+            }
+        }
+        else if (::sendmmsg(fd, sendMsgs.data(), static_cast<unsigned int>(window), 0) < 0)
+        {
+            perror("sendmmsg");
+            break;
+        }
+
+        size_t got = 0;
+        while (got < window)
+        {
+            for (size_t i = 0; i < window; ++i)
+            {
+                recvIov[i].iov_base = &in[i * slot];
+                recvIov[i].iov_len = slot;
+                memset(&recvMsgs[i].msg_hdr, 0, sizeof(msghdr));
+                recvMsgs[i].msg_hdr.msg_iov = &recvIov[i];
+                recvMsgs[i].msg_hdr.msg_iovlen = 1;
+                recvMsgs[i].msg_hdr.msg_control = &control[i * controlSpace];
+                recvMsgs[i].msg_hdr.msg_controllen = controlSpace;
+            }
+            int n = ::recvmmsg(fd, recvMsgs.data(), static_cast<unsigned int>(window - got), MSG_WAITFORONE, nullptr);
+            if (n <= 0)
+            {
+                break;      // 超时：剩下的算作丢失
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                got += countSegments(recvMsgs[i].msg_hdr, recvMsgs[i].msg_len);
+            }
+        }
+        *replies += got;
+        *lost += window > got ? window - got : 0;
+    }
+    ::close(fd);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t batch = argc > 1 ? atoi(argv[1]) : 64;
+    bool offload = argc > 2 && strcmp(argv[2], "on") == 0;
+    int numClients = argc > 3 ? atoi(argv[3]) : 2;
+    double seconds = argc > 4 ? atof(argv[4]) : 2.0;
+    size_t payload = argc > 5 ? atoi(argv[5]) : 64;
+    size_t window = argc > 6 ? atoi(argv[6]) : 64;
+    int numThreads = argc > 7 ? atoi(argv[7]) : 1;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+    UdpServer server(&loop, InetAddress(kPort), "UdpBench");
+    server.setThreadNum(numThreads);
+    server.setBatchSize(batch);
+    server.setGso(offload);
+    server.setGro(offload);
+    server.setRecvBuffer(4 * 1024 * 1024);
+    server.setMessageCallback([](UdpChannel* channel, const InetAddress& peer,
+                                 const char* data, size_t len, Timestamp) {
+        channel->send(peer, data, len);
+    });
+    server.start();
+
+    std::thread driver([&]() {
+        usleep(100 * 1000);
+        std::vector<uint64_t> replies(numClients, 0);
+        std::vector<uint64_t> lost(numClients, 0);
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numClients; ++i)
+        {
+            clients.emplace_back(runClient, seconds, payload, window, offload, &replies[i], &lost[i]);
+        }
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+
+        uint64_t total = 0;
+        uint64_t totalLost = 0;
+        for (int i = 0; i < numClients; ++i)
+        {
+            total += replies[i];
+            totalLost += lost[i];
+        }
+        UdpStats stats = server.stats();
+        printf("batch %3zu, offload %s, %d clients, %zu bytes: %8.0f pps, %.1f pkts/recvmmsg, "
+               "%.1f pkts/sendmmsg, lost %llu\n",
+               batch, offload ? "on " : "off", numClients, payload, total / seconds,
+               stats.recvCalls ? (double)stats.receivedPackets / stats.recvCalls : 0.0,
+               stats.sendCalls ? (double)stats.sentPackets / stats.sendCalls : 0.0,
+               (unsigned long long)totalLost);
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <szmuduo/TcpServer.h>
+#include <szmuduo/EventLoop.h>
+#include <szmuduo/InetAddress.h>
+#include <szmuduo/Timestamp.h>
+#include <szmuduo/Logger.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/**************************************************************************************
+ * 同机往返时延：TcpServer 原样返回收到的数据，客户端线程用阻塞 socket 逐个发送固定
+ * 长度的请求，收齐回复后再发下一个。统计每秒往返次数、时延，以及整个进程（客户端和
+ * 服务器）每次往返消耗的 CPU 时间。
+ *     tcp       127.0.0.1
+ *     tcp6      [::1]
+ *     unix      文件系统中的 Unix 域 socket
+ *     abstract  抽象命名空间的 Unix 域 socket
+ *
+ *  ./udsbench [tcp|tcp6|unix|abstract] [客户端数] [秒数] [消息字节数]
+**************************************************************************************/
+
+static const uint16_t kPort = 8050;
+
+static InetAddress serverAddress(const std::string& mode)
+{
+    if (mode == "tcp6")
+    {
+        return InetAddress(kPort, "::1");
+    }
+    if (mode == "unix")
+    {
+        return InetAddress::unixPath("/tmp/szmuduo-udsbench.sock");
+    }
+    if (mode == "abstract")
+    {
+        return InetAddress::unixPath("@szmuduo-udsbench");
+    }
+    return InetAddress(kPort);
+}
+
+static double processCpuSeconds()
+{
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void runClient(const InetAddress& addr, double seconds, size_t size,
+                      std::vector<int64_t>* latencies, std::mutex* mutex)
+{
+    int fd = ::socket(addr.family(), SOCK_STREAM, 0);
+    if (::connect(fd, addr.getSockAddr(), addr.length()) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    if (!addr.isUnix())
+    {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    std::string request(size, 'q');
+    std::vector<char> response(size);
+    std::vector<int64_t> local;
+    int64_t deadline = Timestamp::monotonicMicros() + static_cast<int64_t>(seconds * 1000 * 1000);
+    while (Timestamp::monotonicMicros() < deadline)
+    {
+        int64_t start = Timestamp::monotonicMicros();
+        if (::write(fd, request.data(), request.size()) != (ssize_t)request.size())
+        {
+            break;
+        }
+        size_t got = 0;
+        while (got < size)
+        {
+            ssize_t n = ::read(fd, response.data() + got, size - got);
+            if (n <= 0)
+            {
+                break;
+            }
+            got += n;
+        }
+        if (got < size)
+        {
+            break;
+        }
+        local.push_back(Timestamp::monotonicMicros() - start);
+    }
+    ::close(fd);
+
+    std::lock_guard<std::mutex> lock(*mutex);
+    latencies->insert(latencies->end(), local.begin(), local.end());
+}
+
+int main(int argc, char* argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "tcp";
+    int numClients = argc > 2 ? atoi(argv[2]) : 1;
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+    size_t size = argc > 4 ? atoi(argv[4]) : 64;
+
+    Logger::setLogLevel(FATAL);
+    EventLoop loop;
+    InetAddress addr = serverAddress(mode);
+    TcpServer server(&loop, addr, "UdsBench");
+    server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->setTcpNoDelay(true);      // Unix 域连接上不做任何事
+        }
+    });
+    server.setMessageCalback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        conn->send(buf);
+    });
+    server.setThreadNum(1);
+    server.start();
+
+    std::thread driver([&]() {
+        usleep(100 * 1000);
+        std::vector<int64_t> latencies;
+        std::mutex mutex;
+        double cpuStart = processCpuSeconds();
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numClients; ++i)
+        {
+            clients.emplace_back(runClient, addr, seconds, size, &latencies, &mutex);
+        }
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+        double cpu = processCpuSeconds() - cpuStart;
+
+        std::sort(latencies.begin(), latencies.end());
+        if (latencies.empty())
+        {
+            printf("%s: no response\n", mode.c_str());
+        }
+        else
+        {
+            printf("%-8s %s: %d clients, %zu bytes, %.0f round trips/s, p50 %lld us, p99 %lld us, cpu %.1f us/round trip\n",
+                   mode.c_str(), addr.toIpPort().c_str(), numClients, size, latencies.size() / seconds,
+                   (long long)latencies[latencies.size() / 2],
+                   (long long)latencies[latencies.size() * 99 / 100],
+                   cpu * 1e6 / latencies.size());
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -7,9 +7,9 @@
 #include <errno.h>
 #include <unistd.h>
 
-static int createNonblocking()
+static int createNonblocking(sa_family_t family)
 {
-    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd < 0)
     {
         LOG_FATAL("%s:%s:%d listen socket create error: %d", __FILE__, __FUNCTION__, __LINE__, errno);
@@ -19,12 +19,26 @@ static int createNonblocking()
 
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
     : loop_(loop),
-      acceptSocket_(createNonblocking()),               // socket 创建套接字
+      acceptSocket_(createNonblocking(listenAddr.family())),     // socket 创建套接字
       acceptChannel_(loop, acceptSocket_.fd()),
-      listening_(false)
+      listening_(false),
+      unixDomain_(listenAddr.isUnix())
 {
-    acceptSocket_.setReuseAddr(true);
-    acceptSocket_.setReusePort(true);
+    if (unixDomain_)
+    {
+        // 文件系统中的 Unix 域地址：删除上次运行留下的 socket 文件，退出时删除
+        std::string path = listenAddr.toIP();
+        if (!path.empty() && path[0] != '@')
+        {
+            ::unlink(path.c_str());
+            unixPath_ = path;
+        }
+    }
+    else
+    {
+        acceptSocket_.setReuseAddr(true);
+        acceptSocket_.setReusePort(true);
+    }
     acceptSocket_.bindAddress(listenAddr);              // bind 套接字
 
     // TcpServer start() --> Acceptor.listen --> 新用户连接 --> 回调函数
@@ -35,15 +49,49 @@ Acceptor::~Acceptor()
 {
     acceptChannel_.disableAll();
     acceptChannel_.remove();        // channel 从 loop 中移除
+    if (!unixPath_.empty())
+    {
+        ::unlink(unixPath_.c_str());
+    }
 }
 
 void Acceptor::listen()
 {
     listening_ = true;
-    acceptSocket_.listen();         // listen
+    // DEFER_ACCEPT、FASTOPEN 是 TCP 选项，Unix 域 socket 不设置
+    if (options_.deferAcceptSeconds > 0 && !unixDomain_)
+    {
+        acceptSocket_.setDeferAccept(options_.deferAcceptSeconds);
+    }
+    if (options_.fastOpenQueue > 0 && !unixDomain_)
+    {
+        acceptSocket_.setFastOpen(options_.fastOpenQueue);
+    }
+    if (options_.recvBufferBytes > 0)
+    {
+        // 接收窗口的缩放因子在握手时确定，需要在 listen 之前设置
+        acceptSocket_.setRecvBuffer(options_.recvBufferBytes);
+    }
+    acceptSocket_.listen(options_.listenBacklog);         // listen
     acceptChannel_.enableReading(); // acceptChannel -> Poller
 }
 
+void Acceptor::setAccepting(bool on)
+{
+    if (!listening_ || on == acceptChannel_.isReading())
+    {
+        return;
+    }
+    if (on)
+    {
+        acceptChannel_.enableReading();
+    }
+    else
+    {
+        acceptChannel_.disableReading();
+    }
+}
+
 
 // listenfd 有事件发生，即有新用户连接
 void Acceptor::handleRead()
@@ -3,8 +3,10 @@
 #include "noncopyable.h"
 #include "Socket.h"
 #include "Channel.h"
+#include "SocketOptions.h"
 
 #include <functional>
+#include <string>
 
 class EventLoop;
 class InetAddress;
@@ -23,9 +25,16 @@ public:
         newConnectionCallback_ = cb;
     }
 
+    // 监听 socket 的选项（backlog、DEFER_ACCEPT、FASTOPEN、接收缓冲区），listen 之前设置
+    void setSocketOptions(const SocketOptions& options) {   options_ = options; }
+
     bool listening()  const  {   return listening_;  }
     void listen();
 
+    // 暂停 / 恢复 accept：暂停期间新连接留在内核的 backlog 中，在 loop 线程中调用
+    void setAccepting(bool on);
+    bool accepting() const {    return listening_ && acceptChannel_.isReading();    }
+
 private:
     void handleRead();
     EventLoop* loop_;       // Acceptor 用的是 用户定义的 baseloop，即Mainloop
@@ -34,4 +43,7 @@ private:
 
     NewConnectionCallback newConnectionCallback_;
     bool listening_;
+    SocketOptions options_;
+    bool unixDomain_;
+    std::string unixPath_;      // 监听文件系统中的 Unix 域地址时，析构时删除该文件
 };
\ No newline at end of file
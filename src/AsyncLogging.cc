@@ -0,0 +1,174 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+
+#include <stdio.h>
+#include <chrono>
+
+const size_t AsyncLogging::kBufferSize;
+const size_t AsyncLogging::kMaxPendingBuffers;
+
+AsyncLogging::AsyncLogging(const std::string& basename,
+                           off_t rollSize,
+                           int flushInterval,
+                           int rollInterval)
+    : flushInterval_(flushInterval),
+      basename_(basename),
+      rollSize_(rollSize),
+      rollInterval_(rollInterval),
+      running_(false),
+      thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
+      currentBuffer_(new FixedBuffer),
+      nextBuffer_(new FixedBuffer),
+      flushRequested_(0),
+      flushDone_(0),
+      droppedBytes_(0)
+{
+    buffers_.reserve(16);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if (running_)
+    {
+        stop();
+    }
+}
+
+void AsyncLogging::start()
+{
+    running_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+        cond_.notify_one();
+    }
+    thread_.join();
+}
+
+void AsyncLogging::append(const char* logline, size_t len)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (currentBuffer_->avail() > len)
+    {
+        currentBuffer_->append(logline, len);
+        return;
+    }
+
+    buffers_.push_back(std::move(currentBuffer_));
+    if (nextBuffer_)
+    {
+        currentBuffer_ = std::move(nextBuffer_);
+    }
+    else
+    {
+        currentBuffer_.reset(new FixedBuffer);     // 很少发生：前端写得太快，两块都用完了
+    }
+    currentBuffer_->append(logline, len);
+    cond_.notify_one();
+}
+
+void AsyncLogging::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_)
+    {
+        return;
+    }
+    uint64_t seq = ++flushRequested_;
+    cond_.notify_one();
+    flushed_.wait(lock, [this, seq]() { return flushDone_ >= seq || !running_; });
+}
+
+void AsyncLogging::threadFunc()
+{
+    LogFile output(basename_, rollSize_, rollInterval_);
+    BufferPtr newBuffer1(new FixedBuffer);
+    BufferPtr newBuffer2(new FixedBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(16);
+
+    bool stopping = false;
+    while (!stopping)
+    {
+        uint64_t flushSeq = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (buffers_.empty() && flushRequested_ == flushDone_ && running_)
+            {
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            stopping = !running_;
+            flushSeq = flushRequested_;
+
+            // 当前缓冲区无论是否写满都换出来，锁内只做指针交换
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if (!nextBuffer_)
+            {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+        }
+
+        // 积压过多：只保留前两块，其余丢弃
+        if (buffersToWrite.size() > kMaxPendingBuffers)
+        {
+            size_t dropped = 0;
+            for (size_t i = 2; i < buffersToWrite.size(); ++i)
+            {
+                dropped += buffersToWrite[i]->length();
+            }
+            droppedBytes_ += dropped;
+
+            char buf[256];
+            int n = snprintf(buf, sizeof(buf), "[ERROR]AsyncLogging dropped %zu log buffers (%zu bytes)\n",
+                             buffersToWrite.size() - 2, dropped);
+            fputs(buf, stderr);
+            output.append(buf, n);
+            buffersToWrite.resize(2);
+        }
+
+        for (const BufferPtr& buffer : buffersToWrite)
+        {
+            if (buffer->length() > 0)
+            {
+                output.append(buffer->data(), buffer->length());
+            }
+        }
+
+        // 回收两块缓冲区给下一轮交换使用，其余释放
+        if (buffersToWrite.size() > 2)
+        {
+            buffersToWrite.resize(2);
+        }
+        if (!newBuffer1)
+        {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if (!newBuffer2 && !buffersToWrite.empty())
+        {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+        output.flush();
+
+        if (flushSeq != 0)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            flushDone_ = flushSeq;
+            flushed_.notify_all();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_.notify_all();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <string.h>
+
+/**************************************************************************************
+ * 异步日志后端（双缓冲）：
+ *     前端线程调用 append 只在锁内把日志拷贝到当前缓冲区，缓冲区写满后与备用缓冲区
+ * 交换并通知后端线程；后端线程每 flushInterval 秒或有写满的缓冲区时，把它们整体换出
+ * 锁外写入 LogFile，写完的缓冲区回收复用。后端来不及写、积压超过 kMaxPendingBuffers
+ * 时丢弃多余的缓冲区并记录丢弃数量，保证前端不会因为磁盘慢而阻塞或无限占用内存。
+ *
+ *     AsyncLogging log("server", 500 * 1000 * 1000);
+ *     log.start();
+ *     Logger::instance().setOutput(std::bind(&AsyncLogging::append, &log, _1, _2));
+**************************************************************************************/
+class AsyncLogging : noncopyable
+{
+public:
+    AsyncLogging(const std::string& basename,
+                 off_t rollSize,
+                 int flushInterval = 3,
+                 int rollInterval = 60 * 60 * 24);
+    ~AsyncLogging();
+
+    void append(const char* logline, size_t len);
+
+    void start();
+    void stop();
+
+    // 让后端立即写出已有日志并等待写完（如进程退出前）
+    void flush();
+
+    // 因积压被丢弃的日志字节数
+    size_t droppedBytes() const {   return droppedBytes_;   }
+
+private:
+    static const size_t kBufferSize = 4 * 1024 * 1024;
+    static const size_t kMaxPendingBuffers = 25;
+
+    class FixedBuffer : noncopyable
+    {
+    public:
+        FixedBuffer() : cur_(data_) {}
+
+        void append(const char* buf, size_t len)
+        {
+            memcpy(cur_, buf, len);
+            cur_ += len;
+        }
+        const char* data() const {  return data_;   }
+        size_t length() const { return cur_ - data_;    }
+        size_t avail() const {  return data_ + sizeof(data_) - cur_;    }
+        void reset() {  cur_ = data_;   }
+
+    private:
+        char data_[kBufferSize];
+        char* cur_;
+    };
+
+    using BufferPtr = std::unique_ptr<FixedBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    void threadFunc();
+
+    const int flushInterval_;
+    const std::string basename_;
+    const off_t rollSize_;
+    const int rollInterval_;
+
+    std::atomic_bool running_;
+    Thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;      // 通知后端有写满的缓冲区
+    std::condition_variable flushed_;   // 通知 flush 的调用者
+    BufferPtr currentBuffer_;
+    BufferPtr nextBuffer_;
+    BufferVector buffers_;              // 已写满、等待后端写出的缓冲区
+    uint64_t flushRequested_;           // flush 请求序号
+    uint64_t flushDone_;                // 后端已完成的序号
+
+    std::atomic<size_t> droppedBytes_;
+};
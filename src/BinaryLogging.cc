@@ -0,0 +1,659 @@
+#include "BinaryLogging.h"
+#include "Thread.h"
+#include "CurrentThread.h"
+
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include <ctype.h>
+
+/**************************************************************************************
+ * 文件格式：
+ *     "SZBLOG01" + double ticksPerNs（时钟计数与纳秒的比例）
+ *     之后是若干记录：char type + uint32 len + payload
+ *         'F' 格式：uint32 id, int32 level, int32 line, 再依次是 file / format / types，
+ *             每个字符串为 uint32 长度 + 内容
+ *         'C' 校准点：uint64 ticks, int64 实际时间（纳秒）
+ *         'B' 日志批次：uint32 tid + 若干条日志记录（EntryHeader + 参数）
+ *         'D' 丢弃：uint32 tid, uint64 丢弃条数
+**************************************************************************************/
+
+namespace
+{
+
+const char kMagic[8] = { 'S', 'Z', 'B', 'L', 'O', 'G', '0', '1' };
+const char* const kLevelName[] = { "[DEBUG]", "[INFO]", "[ERROR]", "[FATAL]" };
+
+int64_t realtimeNanos()
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int64_t monotonicNanos()
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+size_t roundUpPowerOfTwo(size_t n)
+{
+    size_t size = 64 * 1024;
+    while (size < n)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+}
+
+const size_t BinaryLogging::kMaxStringLength;
+std::atomic_bool BinaryLogging::active_(false);
+__thread BinaryLogging::StagingBuffer* BinaryLogging::t_buffer_ = nullptr;
+__thread bool BinaryLogging::t_retired_ = false;
+std::mutex BinaryLogging::formatsMutex_;
+std::vector<BinaryLogging::FormatInfo> BinaryLogging::formats_;
+
+// 线程退出时把缓冲区标记为退役，由后台线程写完后释放。之后（其他 thread_local 对象析构时）
+// 的日志不再写入，也不再创建缓冲区
+struct BinaryLogging::BufferRetirer
+{
+    StagingBuffer* buffer = nullptr;
+    ~BufferRetirer()
+    {
+        t_buffer_ = nullptr;
+        t_retired_ = true;
+        if (buffer)
+        {
+            buffer->retire();
+        }
+    }
+};
+
+thread_local BinaryLogging::BufferRetirer BinaryLogging::t_retirer_;
+
+BinaryLogging::StagingBuffer::StagingBuffer(int tid, size_t capacity)
+    : data_(new char[capacity]),
+      capacity_(capacity),
+      tid_(tid),
+      head_(0),
+      cachedTail_(0),
+      tail_(0),
+      dropped_(0),
+      retired_(false)
+{
+}
+
+BinaryLogging::StagingBuffer::~StagingBuffer()
+{
+    delete[] data_;
+}
+
+char* BinaryLogging::StagingBuffer::reserve(size_t n)
+{
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    size_t offset = head & (capacity_ - 1);
+    size_t contiguous = capacity_ - offset;
+    size_t needed = contiguous < n ? contiguous + n : n;     // 尾部放不下时跳过尾部
+
+    if (head + needed - cachedTail_ > capacity_)
+    {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if (head + needed - cachedTail_ > capacity_)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    if (contiguous < n)
+    {
+        // 记录都按 8 字节对齐，尾部至少还有 8 字节放跳转标记
+        uint32_t wrap = 0;
+        memcpy(data_ + offset, &wrap, sizeof(wrap));
+        head_.store(head + contiguous, std::memory_order_release);
+        offset = 0;
+    }
+    return data_ + offset;
+}
+
+BinaryLogging& BinaryLogging::instance()
+{
+    static BinaryLogging logging;
+    return logging;
+}
+
+BinaryLogging::BinaryLogging()
+    : bufferSize_(1024 * 1024),
+      running_(false),
+      fp_(nullptr),
+      formatsWritten_(0),
+      droppedTotal_(0)
+{
+}
+
+BinaryLogging::~BinaryLogging()
+{
+    // 其他线程可能还持有缓冲区指针，进程退出时不释放
+    stop();
+}
+
+bool BinaryLogging::start(const std::string& path, size_t bufferSize)
+{
+    if (thread_)
+    {
+        return false;
+    }
+
+    fp_ = ::fopen(path.c_str(), "we");
+    if (fp_ == nullptr)
+    {
+        fprintf(stderr, "BinaryLogging::start() open %s failed\n", path.c_str());
+        return false;
+    }
+
+    // 校准时钟计数与纳秒的比例
+    double ticksPerNs = 1.0;
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t t0 = ticks();
+    int64_t ns0 = monotonicNanos();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    uint64_t t1 = ticks();
+    int64_t ns1 = monotonicNanos();
+    ticksPerNs = static_cast<double>(t1 - t0) / static_cast<double>(ns1 - ns0);
+#endif
+    ::fwrite(kMagic, 1, sizeof(kMagic), fp_);
+    ::fwrite(&ticksPerNs, 1, sizeof(ticksPerNs), fp_);
+
+    bufferSize_ = roundUpPowerOfTwo(bufferSize);
+    formatsWritten_ = 0;
+    running_ = true;
+    thread_.reset(new Thread(std::bind(&BinaryLogging::threadFunc, this), "BinaryLogging"));
+    thread_->start();
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void BinaryLogging::stop()
+{
+    if (!thread_)
+    {
+        return;
+    }
+    active_.store(false, std::memory_order_release);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        running_ = false;
+        cond_.notify_one();
+    }
+    thread_->join();
+    thread_.reset();
+
+    ::fclose(fp_);
+    fp_ = nullptr;
+}
+
+uint32_t BinaryLogging::registerFormat(std::atomic<uint32_t>* site, int level, const char* file, int line,
+                                       const char* fmt, const std::string& types)
+{
+    std::unique_lock<std::mutex> lock(formatsMutex_);
+    uint32_t id = site->load(std::memory_order_acquire);
+    if (id == 0)
+    {
+        FormatInfo info;
+        info.level = level;
+        info.line = line;
+        info.file = file;
+        info.format = fmt;
+        info.types = types;
+        formats_.push_back(std::move(info));
+        id = static_cast<uint32_t>(formats_.size());
+        site->store(id, std::memory_order_release);
+    }
+    return id;
+}
+
+BinaryLogging::StagingBuffer* BinaryLogging::createThreadBuffer()
+{
+    if (t_retired_)
+    {
+        return nullptr;
+    }
+    BinaryLogging& logging = instance();
+    StagingBuffer* buffer = new StagingBuffer(CurrentThread::tid(), logging.bufferSize_);
+    {
+        std::unique_lock<std::mutex> lock(logging.buffersMutex_);
+        logging.buffers_.push_back(buffer);
+    }
+    t_buffer_ = buffer;
+    t_retirer_.buffer = buffer;
+    return buffer;
+}
+
+void BinaryLogging::threadFunc()
+{
+    for (;;)
+    {
+        bool wrote = drain();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            break;
+        }
+        if (!wrote)
+        {
+            // 生产者不通知后台线程（避免在调用点做系统调用），空闲时每毫秒检查一次
+            cond_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    drain();
+    ::fflush(fp_);
+}
+
+void BinaryLogging::writeRecord(char type, const void* data, size_t len)
+{
+    uint32_t len32 = static_cast<uint32_t>(len);
+    ::fwrite_unlocked(&type, 1, 1, fp_);
+    ::fwrite_unlocked(&len32, 1, sizeof(len32), fp_);
+    ::fwrite_unlocked(data, 1, len, fp_);
+}
+
+bool BinaryLogging::drain()
+{
+    std::vector<StagingBuffer*> buffers;
+    {
+        std::unique_lock<std::mutex> lock(buffersMutex_);
+        buffers = buffers_;
+    }
+
+    // 先读各缓冲区的 head，再写格式表：head 之前的记录用到的格式一定已经登记
+    std::vector<bool> retired(buffers.size());
+    std::vector<uint64_t> heads(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        retired[i] = buffers[i]->retired_.load(std::memory_order_acquire);
+        heads[i] = buffers[i]->head_.load(std::memory_order_acquire);
+    }
+
+    bool wrote = false;
+    {
+        std::unique_lock<std::mutex> lock(formatsMutex_);
+        for (; formatsWritten_ < formats_.size(); ++formatsWritten_)
+        {
+            const FormatInfo& info = formats_[formatsWritten_];
+            std::string payload;
+            uint32_t id = static_cast<uint32_t>(formatsWritten_ + 1);
+            int32_t level = info.level;
+            int32_t line = info.line;
+            payload.append(reinterpret_cast<const char*>(&id), 4);
+            payload.append(reinterpret_cast<const char*>(&level), 4);
+            payload.append(reinterpret_cast<const char*>(&line), 4);
+            for (const std::string* s : { &info.file, &info.format, &info.types })
+            {
+                uint32_t len = static_cast<uint32_t>(s->size());
+                payload.append(reinterpret_cast<const char*>(&len), 4);
+                payload.append(*s);
+            }
+            writeRecord('F', payload.data(), payload.size());
+            wrote = true;
+        }
+    }
+
+    bool checkpointWritten = false;
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        StagingBuffer* buffer = buffers[i];
+        uint64_t head = heads[i];
+        uint64_t tail = buffer->tail_.load(std::memory_order_relaxed);
+
+        if (tail != head && !checkpointWritten)
+        {
+            // 每一批日志之前写一个校准点，解码时把时钟计数换算成实际时间
+            char payload[16];
+            uint64_t t = ticks();
+            int64_t ns = realtimeNanos();
+            memcpy(payload, &t, 8);
+            memcpy(payload + 8, &ns, 8);
+            writeRecord('C', payload, sizeof(payload));
+            checkpointWritten = true;
+        }
+
+        // 找出连续的记录段整体写出，遇到跳转标记换到缓冲区开头
+        size_t mask = buffer->capacity_ - 1;
+        uint64_t pos = tail;
+        size_t runStart = pos & mask;
+        size_t runLen = 0;
+        uint32_t tid = static_cast<uint32_t>(buffer->tid());
+        while (pos <= head)
+        {
+            bool wrap = false;
+            if (pos < head && runLen > 0 && (pos & mask) == 0)
+            {
+                wrap = true;        // 记录恰好写到缓冲区末尾，下一条从开头开始
+            }
+            else if (pos < head)
+            {
+                uint32_t formatId;
+                memcpy(&formatId, buffer->data_ + (pos & mask), sizeof(formatId));
+                if (formatId != 0)
+                {
+                    uint32_t size;
+                    memcpy(&size, buffer->data_ + (pos & mask) + 4, sizeof(size));
+                    runLen += size;
+                    pos += size;
+                    continue;
+                }
+                wrap = true;
+            }
+
+            if (runLen > 0)
+            {
+                uint32_t len = static_cast<uint32_t>(sizeof(tid) + runLen);
+                char type = 'B';
+                ::fwrite_unlocked(&type, 1, 1, fp_);
+                ::fwrite_unlocked(&len, 1, sizeof(len), fp_);
+                ::fwrite_unlocked(&tid, 1, sizeof(tid), fp_);
+                ::fwrite_unlocked(buffer->data_ + runStart, 1, runLen, fp_);
+                wrote = true;
+            }
+            if (!wrap)
+            {
+                break;
+            }
+            if ((pos & mask) != 0)
+            {
+                pos += buffer->capacity_ - (pos & mask);
+            }
+            runStart = 0;
+            runLen = 0;
+        }
+        buffer->tail_.store(head, std::memory_order_release);
+
+        uint64_t dropped = buffer->dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            char payload[12];
+            memcpy(payload, &tid, 4);
+            memcpy(payload + 4, &dropped, 8);
+            writeRecord('D', payload, sizeof(payload));
+            droppedTotal_ += dropped;
+            wrote = true;
+        }
+
+        if (retired[i])
+        {
+            std::unique_lock<std::mutex> lock(buffersMutex_);
+            for (std::vector<StagingBuffer*>::iterator it = buffers_.begin(); it != buffers_.end(); ++it)
+            {
+                if (*it == buffer)
+                {
+                    buffers_.erase(it);
+                    break;
+                }
+            }
+            delete buffer;
+        }
+    }
+
+    if (wrote)
+    {
+        ::fflush(fp_);
+    }
+    return wrote;
+}
+
+namespace
+{
+
+// 按参数类型格式化一个转换说明，spec 为去掉长度修饰符后的 "%[flags][width][.precision]"
+void formatArg(std::string& out, std::string spec, char conv, char type, const char*& arg)
+{
+    char buf[2048];
+    if (spec.find('*') != std::string::npos)
+    {
+        spec = "%";         // 宽度 / 精度来自参数的写法不支持，按默认格式输出
+    }
+
+    switch (type)
+    {
+    case 'i':
+    case 'l':
+    {
+        int64_t v;
+        memcpy(&v, arg, 8);
+        arg += 8;
+        if (conv == 'c')
+            snprintf(buf, sizeof(buf), (spec + "c").c_str(), static_cast<int>(v));
+        else if (conv && strchr("diouxX", conv))
+            snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), static_cast<long long>(v));
+        else
+            snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+        break;
+    }
+    case 'u':
+    case 'U':
+    {
+        uint64_t v;
+        memcpy(&v, arg, 8);
+        arg += 8;
+        if (conv == 'c')
+            snprintf(buf, sizeof(buf), (spec + "c").c_str(), static_cast<int>(v));
+        else if (conv && strchr("diouxX", conv))
+            snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), static_cast<unsigned long long>(v));
+        else
+            snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+        break;
+    }
+    case 'd':
+    {
+        double v;
+        memcpy(&v, arg, 8);
+        arg += 8;
+        if (conv && strchr("fFeEgGaA", conv))
+            snprintf(buf, sizeof(buf), (spec + conv).c_str(), v);
+        else
+            snprintf(buf, sizeof(buf), "%g", v);
+        break;
+    }
+    case 's':
+    {
+        uint32_t len;
+        memcpy(&len, arg, 4);
+        std::string s(arg + 4, len);
+        arg += 4 + len;
+        if (conv == 's')
+            snprintf(buf, sizeof(buf), (spec + "s").c_str(), s.c_str());
+        else
+            snprintf(buf, sizeof(buf), "%s", s.c_str());
+        break;
+    }
+    case 'p':
+    {
+        uint64_t v;
+        memcpy(&v, arg, 8);
+        arg += 8;
+        if (conv == 'p')
+            snprintf(buf, sizeof(buf), (spec + "p").c_str(), reinterpret_cast<void*>(static_cast<uintptr_t>(v)));
+        else
+            snprintf(buf, sizeof(buf), "0x%llx", static_cast<unsigned long long>(v));
+        break;
+    }
+    default:
+        buf[0] = '\0';
+        break;
+    }
+    out += buf;
+}
+
+// 按 printf 格式串逐个转换说明还原日志消息
+void formatMessage(std::string& out, const std::string& format, const std::string& types, const char* arg)
+{
+    const char* f = format.c_str();
+    size_t argIndex = 0;
+    while (*f)
+    {
+        if (*f != '%')
+        {
+            out += *f++;
+            continue;
+        }
+        if (f[1] == '%')
+        {
+            out += '%';
+            f += 2;
+            continue;
+        }
+
+        const char* specStart = f++;
+        while (*f && strchr("-+ #0'", *f))
+            ++f;
+        while (*f && (isdigit(*f) || *f == '*'))
+            ++f;
+        if (*f == '.')
+        {
+            ++f;
+            while (*f && (isdigit(*f) || *f == '*'))
+                ++f;
+        }
+        std::string spec(specStart, f);
+        while (*f && strchr("hlLqjzt", *f))
+            ++f;
+        char conv = *f;
+        if (conv)
+        {
+            ++f;
+        }
+
+        if (argIndex >= types.size())
+        {
+            out.append(specStart, f);       // 参数不够，原样输出
+            continue;
+        }
+        formatArg(out, spec, conv, types[argIndex++], arg);
+    }
+}
+
+bool readFull(FILE* in, void* data, size_t len)
+{
+    return ::fread(data, 1, len, in) == len;
+}
+
+}
+
+bool BinaryLogging::decode(FILE* in, FILE* out)
+{
+    char magic[sizeof(kMagic)];
+    double ticksPerNs = 1.0;
+    if (!readFull(in, magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0
+        || !readFull(in, &ticksPerNs, sizeof(ticksPerNs)))
+    {
+        fprintf(stderr, "BinaryLogging::decode() bad file header\n");
+        return false;
+    }
+
+    std::unordered_map<uint32_t, FormatInfo> formats;
+    uint64_t checkpointTicks = 0;
+    int64_t checkpointNs = 0;
+    std::vector<char> payload;
+    std::string line;
+
+    char type;
+    uint32_t len;
+    while (readFull(in, &type, 1) && readFull(in, &len, sizeof(len)))
+    {
+        payload.resize(len);
+        if (len > 0 && !readFull(in, payload.data(), len))
+        {
+            fprintf(stderr, "BinaryLogging::decode() truncated record\n");
+            return false;
+        }
+        const char* p = payload.data();
+
+        if (type == 'F')
+        {
+            uint32_t id;
+            FormatInfo info;
+            memcpy(&id, p, 4);
+            memcpy(&info.level, p + 4, 4);
+            memcpy(&info.line, p + 8, 4);
+            p += 12;
+            for (std::string* s : { &info.file, &info.format, &info.types })
+            {
+                uint32_t n;
+                memcpy(&n, p, 4);
+                s->assign(p + 4, n);
+                p += 4 + n;
+            }
+            formats[id] = std::move(info);
+        }
+        else if (type == 'C')
+        {
+            memcpy(&checkpointTicks, p, 8);
+            memcpy(&checkpointNs, p + 8, 8);
+        }
+        else if (type == 'D')
+        {
+            uint32_t tid;
+            uint64_t dropped;
+            memcpy(&tid, p, 4);
+            memcpy(&dropped, p + 4, 8);
+            fprintf(out, "[ERROR] binary log dropped %llu entries in thread %u\n",
+                    static_cast<unsigned long long>(dropped), tid);
+        }
+        else if (type == 'B')
+        {
+            uint32_t tid;
+            memcpy(&tid, p, 4);
+            const char* end = p + len;
+            p += 4;
+            while (p + sizeof(EntryHeader) <= end)
+            {
+                EntryHeader header;
+                memcpy(&header, p, sizeof(header));
+                if (header.size < sizeof(header) || p + header.size > end)
+                {
+                    break;
+                }
+
+                int64_t deltaNs = static_cast<int64_t>(static_cast<double>(
+                                      static_cast<int64_t>(header.ticks - checkpointTicks)) / ticksPerNs);
+                int64_t ns = checkpointNs + deltaNs;
+                time_t seconds = static_cast<time_t>(ns / 1000000000);
+                tm tm_time;
+                localtime_r(&seconds, &tm_time);
+
+                std::unordered_map<uint32_t, FormatInfo>::const_iterator it = formats.find(header.formatId);
+                const char* levelName = "";
+                line.clear();
+                if (it != formats.end())
+                {
+                    if (it->second.level >= 0 && it->second.level <= 3)
+                    {
+                        levelName = kLevelName[it->second.level];
+                    }
+                    formatMessage(line, it->second.format, it->second.types, p + sizeof(header));
+                }
+                else
+                {
+                    line = "<unknown format " + std::to_string(header.formatId) + ">";
+                }
+                if (line.empty() || line.back() != '\n')
+                {
+                    line += '\n';
+                }
+
+                fprintf(out, "%s%4d/%02d/%02d %02d:%02d:%02d.%06d %u : %s",
+                        levelName,
+                        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec,
+                        static_cast<int>(ns % 1000000000 / 1000), tid, line.c_str());
+                p += header.size;
+            }
+        }
+        // 未知类型的记录直接跳过
+    }
+    return true;
+}
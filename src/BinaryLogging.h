@@ -0,0 +1,274 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+class Thread;
+
+/**************************************************************************************
+ * 二进制日志：调用点只写入格式编号和原始参数，格式化推迟到离线解码。
+ *     start() 之后 LOG_DEBUG / LOG_INFO / LOG_ERROR 自动走二进制路径（LOG_FATAL 仍然
+ * 输出文本并退出）：每个调用点第一次执行时登记格式串和参数类型得到编号，之后每次
+ * 只把 {编号, 长度, 时钟计数} 和参数拷贝进本线程的单生产者单消费者环形缓冲区，
+ * 不加锁、不格式化。环形缓冲区写满时丢弃并计数，不阻塞调用者。
+ *     后台线程定期把各线程缓冲区中的记录连同格式表、时钟校准点原样写入文件，
+ * 用 BinaryLogging::decode（example/blogdecode）还原为文本。
+ *
+ *     参数支持整数、枚举、浮点数、C 字符串（最长 kMaxStringLength）和指针。
+**************************************************************************************/
+class BinaryLogging : noncopyable
+{
+public:
+    static BinaryLogging& instance();
+
+    // 开始写入 path，bufferSize 为每个线程环形缓冲区的大小（向上取 2 的幂）
+    bool start(const std::string& path, size_t bufferSize = 1024 * 1024);
+    // 写出剩余的记录并关闭文件，之后日志回到文本输出
+    void stop();
+
+    static bool active() {  return active_.load(std::memory_order_relaxed); }
+
+    // 因环形缓冲区满被丢弃的记录数
+    uint64_t droppedEntries() const {   return droppedTotal_;   }
+
+    // 把二进制日志解码为文本，格式与 Logger 一致，另外带有微秒和线程号
+    static bool decode(FILE* in, FILE* out);
+
+    template<typename... Args>
+    static void log(std::atomic<uint32_t>* site, int level, const char* file, int line,
+                    const char* fmt, Args... args);
+
+    static const size_t kMaxStringLength = 1024;
+
+    // 记录头，记录整体按 8 字节对齐；formatId 为 0 表示跳到缓冲区开头
+    struct EntryHeader
+    {
+        uint32_t formatId;
+        uint32_t size;          // 含记录头和对齐填充
+        uint64_t ticks;
+    };
+
+    // 每个线程一个，线程写 head_，后台线程写 tail_
+    class StagingBuffer : noncopyable
+    {
+    public:
+        StagingBuffer(int tid, size_t capacity);
+        ~StagingBuffer();
+
+        // 预留 n 字节连续空间，空间不足返回 nullptr
+        char* reserve(size_t n);
+        void commit(size_t n) { head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+        int tid() const {   return tid_;    }
+        // 线程退出时调用，后台线程写完剩余记录后释放缓冲区
+        void retire() { retired_.store(true, std::memory_order_release);    }
+
+    private:
+        friend class BinaryLogging;
+
+        char* data_;
+        const size_t capacity_;
+        const int tid_;
+
+        // C++11 的 new 不保证 alignas(64)，用填充把生产者和消费者的字段隔开
+        char pad0_[64];
+        std::atomic<uint64_t> head_;    // 生产者
+        uint64_t cachedTail_;
+        char pad1_[64];
+        std::atomic<uint64_t> tail_;    // 消费者
+        std::atomic<uint64_t> dropped_;
+        std::atomic_bool retired_;                  // 线程已退出
+    };
+
+    // 时钟计数：x86 上为 TSC，其他平台为单调时钟纳秒
+    static uint64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+#else
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    }
+
+private:
+    BinaryLogging();
+    ~BinaryLogging();
+
+    struct FormatInfo
+    {
+        int level;
+        int line;
+        std::string file;
+        std::string format;
+        std::string types;
+    };
+
+    static uint32_t registerFormat(std::atomic<uint32_t>* site, int level, const char* file, int line,
+                                   const char* fmt, const std::string& types);
+    // 线程退出时退役本线程的缓冲区
+    struct BufferRetirer;
+
+    // 线程退出过程中（缓冲区已退役）返回 nullptr
+    static StagingBuffer* threadBuffer()
+    {
+        return t_buffer_ ? t_buffer_ : createThreadBuffer();
+    }
+    static StagingBuffer* createThreadBuffer();
+
+    void threadFunc();
+    bool drain();
+    void writeRecord(char type, const void* data, size_t len);
+
+    // ---------- 参数类型与编码 ----------
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value, char>::type argType(T)
+    {
+        return sizeof(T) <= 4 ? (std::is_signed<T>::value ? 'i' : 'u')
+                              : (std::is_signed<T>::value ? 'l' : 'U');
+    }
+    template<typename T>
+    static typename std::enable_if<std::is_enum<T>::value, char>::type argType(T) { return 'i';    }
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, char>::type argType(T) {  return 'd'; }
+    static char argType(const char*) {  return 's'; }
+    static char argType(char*) {    return 's'; }
+    static char argType(const void*) {  return 'p'; }
+
+    template<typename T>
+    static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, size_t>::type
+    argSize(T) {    return 8;   }
+    static size_t argSize(const char* s)   {   return 4 + stringLength(s); }
+    static size_t argSize(char* s)   {   return 4 + stringLength(s); }
+    static size_t argSize(const void*)  {   return 8;   }
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value, void>::type encode(char*& p, T v)
+    {
+        if (std::is_signed<T>::value) { int64_t x = static_cast<int64_t>(v); memcpy(p, &x, 8);    }
+        else {  uint64_t x = static_cast<uint64_t>(v); memcpy(p, &x, 8);  }
+        p += 8;
+    }
+    template<typename T>
+    static typename std::enable_if<std::is_enum<T>::value, void>::type encode(char*& p, T v)
+    {
+        int64_t x = static_cast<int64_t>(v);
+        memcpy(p, &x, 8);
+        p += 8;
+    }
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, void>::type encode(char*& p, T v)
+    {
+        double x = static_cast<double>(v);
+        memcpy(p, &x, 8);
+        p += 8;
+    }
+    static void encode(char*& p, const char* s)
+    {
+        uint32_t len = static_cast<uint32_t>(stringLength(s));
+        memcpy(p, &len, 4);
+        memcpy(p + 4, s ? s : "(null)", len);
+        p += 4 + len;
+    }
+    static void encode(char*& p, char* s) { encode(p, static_cast<const char*>(s));  }
+    static void encode(char*& p, const void* v)
+    {
+        uint64_t x = reinterpret_cast<uintptr_t>(v);
+        memcpy(p, &x, 8);
+        p += 8;
+    }
+
+    static size_t stringLength(const char* s)
+    {
+        if (s == nullptr)
+        {
+            return 6;       // "(null)"
+        }
+        size_t len = strnlen(s, kMaxStringLength);
+        return len;
+    }
+
+    static void appendTypes(std::string&) {}
+    template<typename T, typename... Rest>
+    static void appendTypes(std::string& types, T v, Rest... rest)
+    {
+        types += argType(v);
+        appendTypes(types, rest...);
+    }
+
+    static size_t argsSize() {  return 0;   }
+    template<typename T, typename... Rest>
+    static size_t argsSize(T v, Rest... rest) { return argSize(v) + argsSize(rest...);  }
+
+    static void encodeArgs(char*) {}
+    template<typename T, typename... Rest>
+    static void encodeArgs(char* p, T v, Rest... rest)
+    {
+        encode(p, v);
+        encodeArgs(p, rest...);
+    }
+
+    static std::atomic_bool active_;
+    static __thread StagingBuffer* t_buffer_;
+    static __thread bool t_retired_;
+    static thread_local BufferRetirer t_retirer_;
+
+    // 格式表，编号从 1 开始，只增不减
+    static std::mutex formatsMutex_;
+    static std::vector<FormatInfo> formats_;
+
+    // 所有线程的缓冲区
+    std::mutex buffersMutex_;
+    std::vector<StagingBuffer*> buffers_;
+    size_t bufferSize_;
+
+    std::unique_ptr<Thread> thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool running_;
+
+    FILE* fp_;
+    size_t formatsWritten_;
+    std::atomic<uint64_t> droppedTotal_;
+};
+
+template<typename... Args>
+void BinaryLogging::log(std::atomic<uint32_t>* site, int level, const char* file, int line,
+                        const char* fmt, Args... args)
+{
+    uint32_t id = site->load(std::memory_order_acquire);
+    if (__builtin_expect(id == 0, 0))
+    {
+        std::string types;
+        appendTypes(types, args...);
+        id = registerFormat(site, level, file, line, fmt, types);
+    }
+
+    size_t size = (sizeof(EntryHeader) + argsSize(args...) + 7) & ~static_cast<size_t>(7);
+    StagingBuffer* buffer = threadBuffer();
+    char* p = buffer ? buffer->reserve(size) : nullptr;
+    if (p == nullptr)
+    {
+        return;
+    }
+
+    EntryHeader header;
+    header.formatId = id;
+    header.size = static_cast<uint32_t>(size);
+    header.ticks = ticks();
+    memcpy(p, &header, sizeof(header));
+    encodeArgs(p + sizeof(header), args...);
+    buffer->commit(size);
+}
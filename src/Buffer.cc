@@ -1,6 +1,8 @@
 #include "Buffer.h"
 
+#include <algorithm>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
@@ -11,30 +13,35 @@
  */
 ssize_t Buffer::readFd(int fd, int* savedErrno)
 {
-    char extrabuf[65536] = {0};     // 栈空间, 64K 
+    return readFd(fd, savedErrno, SIZE_MAX);
+}
+
+ssize_t Buffer::readFd(int fd, int* savedErrno, size_t maxBytes)
+{
+    char extrabuf[65536];           // 栈空间, 64K，readv 直接写入，不需要清零
     struct iovec vec[2];
 
-    const size_t writeable = wirterableBytes();
+    const size_t writeable = std::min(wirterableBytes(), maxBytes);
     vec[0].iov_base = begin() + writerIndex_;
     vec[0].iov_len = writeable;
 
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
+    vec[1].iov_len = std::min(sizeof(extrabuf), maxBytes - writeable);
 
     // 一次最多读 64K数据，如果 writeable < 64K ,使用栈空间，否则不使用
-    const int iovcnt = (writeable < sizeof(extrabuf)) ? 2 : 1;
+    const int iovcnt = (writeable < sizeof(extrabuf) && vec[1].iov_len > 0) ? 2 : 1;
     const ssize_t n= ::readv(fd, vec, iovcnt);
     if (n < 0)
     {
         *savedErrno = errno;
     }
-    else if (n <= writeable)   // extra 没有写入数据
+    else if (static_cast<size_t>(n) <= writeable)   // extra 没有写入数据
     {
         writerIndex_ += n;
     }   
     else        // extra 写入数据
     {
-        writerIndex_ = buffer_.size();
+        writerIndex_ += writeable;
         append(extrabuf, n - writeable);
     }
 
@@ -3,6 +3,33 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
+/**************************************************************************************
+ * 内存统计计数器：Buffer 容量变化时更新，可以串联（连接 -> 服务器），
+ * 一次更新会累加到整条链上。
+**************************************************************************************/
+struct MemoryCounter
+{
+    explicit MemoryCounter(MemoryCounter* parentArg = nullptr)
+        : bytes(0), parent(parentArg)
+    {
+    }
+
+    void add(int64_t delta)
+    {
+        for (MemoryCounter* c = this; c != nullptr; c = c->parent)
+        {
+            c->bytes.fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    int64_t get() const {   return bytes.load(std::memory_order_relaxed);  }
+
+    std::atomic<int64_t> bytes;
+    MemoryCounter* parent;
+};
 
 /**************************************************************************************
  * SZMuduo 网络库底层缓冲器类型
@@ -13,12 +40,74 @@ public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
 
+    // initialSize 为 0 时不预先分配内存，第一次写入时再分配
     explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + kInitialSize),
+        : buffer_(initialSize == 0 ? 0 : kCheapPrepend + initialSize),
           readerIndex_(kCheapPrepend),
-          writerIndex_(kCheapPrepend)
+          writerIndex_(kCheapPrepend),
+          memoryCounter_(nullptr),
+          accountedBytes_(0)
+        {
+        }
+
+    // 拷贝出的 Buffer 不参与原来的内存统计
+    Buffer(const Buffer& other)
+        : buffer_(other.buffer_),
+          readerIndex_(other.readerIndex_),
+          writerIndex_(other.writerIndex_),
+          memoryCounter_(nullptr),
+          accountedBytes_(0)
+    {
+    }
+
+    Buffer& operator=(const Buffer& other)
+    {
+        buffer_ = other.buffer_;
+        readerIndex_ = other.readerIndex_;
+        writerIndex_ = other.writerIndex_;
+        updateMemory();
+        return *this;
+    }
+
+    ~Buffer()
+    {
+        if (memoryCounter_)
         {
+            memoryCounter_->add(-static_cast<int64_t>(accountedBytes_));
         }
+    }
+
+    // 设置内存统计计数器，之后容量的增长和释放都会累加到计数器上
+    void setMemoryCounter(MemoryCounter* counter)
+    {
+        if (memoryCounter_)
+        {
+            memoryCounter_->add(-static_cast<int64_t>(accountedBytes_));
+        }
+        memoryCounter_ = counter;
+        accountedBytes_ = 0;
+        updateMemory();
+    }
+
+    size_t capacity() const {   return buffer_.capacity();  }
+
+    // 释放多余的内存，只保留可读数据和 reserve 字节的可写空间；没有数据时全部释放
+    void shrink(size_t reserve)
+    {
+        if (readableBytes() == 0 && reserve == 0)
+        {
+            std::vector<char>().swap(buffer_);
+        }
+        else
+        {
+            std::vector<char> buf(kCheapPrepend + readableBytes() + reserve);
+            std::copy(peek(), peek() + readableBytes(), buf.begin() + kCheapPrepend);
+            buf.swap(buffer_);
+        }
+        writerIndex_ = kCheapPrepend + readableBytes();
+        readerIndex_ = kCheapPrepend;
+        updateMemory();
+    }
 
     size_t readableBytes() const 
     {
@@ -27,7 +116,7 @@ public:
 
     size_t wirterableBytes() const 
     {
-        return buffer_.size() - writerIndex_;
+        return buffer_.size() > writerIndex_ ? buffer_.size() - writerIndex_ : 0;
     }
 
     size_t prependableBytes() const
@@ -54,6 +143,19 @@ public:
         }
     }
 
+    // 撤销最后写入、尚未读取的 len 字节
+    void unwrite(size_t len)
+    {
+        if (len < readableBytes())
+        {
+            writerIndex_ -= len;
+        }
+        else
+        {
+            retrieveAll();
+        }
+    }
+
     void retrieveAll()
     {
         readerIndex_ = kCheapPrepend;
@@ -100,17 +202,19 @@ public:
     }
 
     ssize_t readFd(int fd, int* savedErrno);
+    // 最多读取 maxBytes 字节，其余数据留在内核缓冲区中
+    ssize_t readFd(int fd, int* savedErrno, size_t maxBytes);
     ssize_t writeFd(int fd, int* savedErrno);
     
 private:
     char* begin()
     {
-        return &*buffer_.begin();
+        return buffer_.data();
     }
 
     const char* begin() const
     {
-        return &*buffer_.begin();
+        return buffer_.data();
     }
 
     void makeSpace(size_t len)
@@ -118,6 +222,7 @@ private:
         if (wirterableBytes() + (prependableBytes() - kCheapPrepend) < len)
         {
             buffer_.resize(writerIndex_ + len);
+            updateMemory();
         }
         else
         {
@@ -130,7 +235,19 @@ private:
         }
     }
 
+    void updateMemory()
+    {
+        if (memoryCounter_ && buffer_.capacity() != accountedBytes_)
+        {
+            memoryCounter_->add(static_cast<int64_t>(buffer_.capacity()) - static_cast<int64_t>(accountedBytes_));
+            accountedBytes_ = buffer_.capacity();
+        }
+    }
+
     std::vector<char> buffer_;
     size_t readerIndex_;
     size_t writerIndex_;
+
+    MemoryCounter* memoryCounter_;
+    size_t accountedBytes_;     // 已经计入 memoryCounter_ 的字节数
 };
\ No newline at end of file
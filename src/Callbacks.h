@@ -2,16 +2,38 @@
 
 #include <memory>
 #include <functional>
+#include <stdint.h>
+#include <string>
 
 class Buffer;
 class TcpConnection;
 class Timestamp;
 
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+using TcpConnectionWeakPtr = std::weak_ptr<TcpConnection>;
+
+// 连接在所属 TcpServer 内的唯一编号
+using ConnectionId = uint64_t;
 
 using ConnectionCallback = std::function<void (const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void (const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void (const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void (const TcpConnectionPtr&,
                                     Buffer*, Timestamp)>;
-using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
\ No newline at end of file
+using HighWaterMarkCallback = std::function<void (const TcpConnectionPtr&, size_t)>;
+
+/**************************************************************************************
+ * 一组连接回调：同一个 TcpServer 的所有连接共享同一份（shared_ptr），
+ * 建立连接时不再逐个拷贝 std::function。
+**************************************************************************************/
+struct ConnectionCallbacks
+{
+    std::string namePrefix;     // 连接名前缀，连接名 = namePrefix + 连接编号
+
+    ConnectionCallback connectionCallback;
+    MessageCallback messageCallback;
+    WriteCompleteCallback writeCompleteCallback;
+    HighWaterMarkCallback highWaterMarkCallback;
+    CloseCallback closeCallback;
+};
+using ConnectionCallbacksPtr = std::shared_ptr<ConnectionCallbacks>;
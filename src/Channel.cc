@@ -10,7 +10,7 @@ const int Channel::kWriteEvent = EPOLLOUT;
 
 
 Channel::Channel(EventLoop* loop, int fd) 
-    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), tied_(false)
+    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), edgeTriggered_(false), tied_(false)
 {
 
 }
@@ -29,6 +29,20 @@ void Channel::tie(const std::shared_ptr<void>& obj)
     tied_ = true;
 }
 
+int Channel::events() const
+{
+    return events_ == kNoneEvent || !edgeTriggered_ ? events_ : events_ | EPOLLET;
+}
+
+void Channel::setEdgeTriggered(bool on)
+{
+    edgeTriggered_ = on;
+    if (!isNoneEvent())
+    {
+        update();
+    }
+}
+
 /********************************************************************************************
  * 用于在改变 channel 所表示的 fd 的events事件后，update 负责在poller 中更改fd 相应的事件 epoll_ctl
 **********************************************************************************************/
@@ -64,7 +78,7 @@ void Channel::handleEvent(Timestamp receiveTime)
 **********************************************************************************************/
 void Channel::handleEventWithGuard(Timestamp receiveTime)
 {
-    LOG_INFO("Channel handleEvent revents: %d \n", revents_);
+    LOG_DEBUG("Channel handleEvent revents: %d \n", revents_);
 
     if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)){
         if (closeCallback_){
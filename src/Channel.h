@@ -35,7 +35,8 @@ public:
     void tie(const std::shared_ptr<void>& );
 
     int fd() const {return fd_; }
-    int events() const {return events_; }
+    // 交给 poller 的事件，边沿触发时带上 EPOLLET
+    int events() const;
     void set_revents(int revt)   {revents_ = revt;    }
 
     // 返回fd 当前的事件状态
@@ -50,6 +51,10 @@ public:
     void disableWriting()   {events_ &= ~kWriteEvent; update(); }
     void disableAll()       {events_ = kNoneEvent;  update();   }
 
+    // 边沿触发：读写事件只在状态变化时通知一次，回调需要读到 EAGAIN 或自行安排下次读取
+    void setEdgeTriggered(bool on);
+    bool edgeTriggered() const {    return edgeTriggered_;  }
+
     int index() {return index_;}
     void set_index(int idx){ index_ = idx;};
 
@@ -73,6 +78,7 @@ private:
     int events_;        // fd 监听的事件
     int revents_;       // Poller 返回具体的发生的事件
     int index_;         
+    bool edgeTriggered_;
 
     /* 
     *   跨线程生存状态监听：保证在手动释放 channel 后，防止继续使用。
@@ -0,0 +1,254 @@
+#include "ComputePool.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Thread.h"
+#include "Logger.h"
+
+// 一个计算任务，提交时分配，done 执行后释放
+struct ComputeJob
+{
+    ComputePool::Task work;
+    ComputePool::Task done;
+    ComputePool::ConnectionTask connectionDone;     // 有序提交的 done
+    EventLoop* loop;
+    TcpConnectionPtr conn;      // 有序提交时非空
+    uint64_t seq;
+};
+
+ComputePool::ComputePool(const std::string& name)
+    : name_(name),
+      next_(0),
+      sleeping_(0),
+      queued_(0),
+      running_(false),
+      submitted_(0),
+      executed_(0),
+      stolen_(0)
+{
+}
+
+ComputePool::~ComputePool()
+{
+    stop();
+}
+
+void ComputePool::start(int numThreads, const ThreadInitCallback& cb)
+{
+    if (running_ || numThreads <= 0)
+    {
+        return;
+    }
+    running_ = true;
+    for (int i = 0; i < numThreads; ++i)
+    {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker));
+    }
+    // 所有队列创建完之后再启动线程，偷取时 workers_ 不再变化
+    for (int i = 0; i < numThreads; ++i)
+    {
+        std::string name = name_ + std::to_string(i);
+        workers_[i]->thread.reset(new Thread(std::bind(&ComputePool::runWorker, this, i, cb), name));
+        workers_[i]->thread->start();
+    }
+}
+
+void ComputePool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    cond_.notify_all();
+    for (std::unique_ptr<Worker>& worker : workers_)
+    {
+        worker->thread->join();
+    }
+    // 队列都已经取空，之后可以再次 start
+    workers_.clear();
+}
+
+void ComputePool::submit(EventLoop* loop, Task work, Task done)
+{
+    ComputeJob* job = new ComputeJob;
+    job->work = std::move(work);
+    if (loop != nullptr)
+    {
+        job->done = std::move(done);
+    }
+    job->loop = loop;
+    job->seq = 0;
+    push(job);
+}
+
+void ComputePool::submit(const TcpConnectionPtr& conn, Task work, ConnectionTask done)
+{
+    ComputeJob* job = new ComputeJob;
+    job->work = std::move(work);
+    job->connectionDone = std::move(done);
+    job->loop = conn->getLoop();
+    job->conn = conn;
+    job->seq = conn->computeOrder()->nextSeq++;
+    if (job->work)
+    {
+        push(job);
+    }
+    else
+    {
+        complete(job);
+    }
+}
+
+void ComputePool::push(ComputeJob* job)
+{
+    if (!running_)
+    {
+        // 没有工作线程：在提交的线程中执行，有序任务的序号不会出现空缺
+        LOG_ERROR("ComputePool::submit [%s] - pool is not running, run in caller thread\n", name_.c_str());
+        run(job);
+        return;
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    Worker* worker = workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()].get();
+    {
+        // 在任务可见之前计数，否则偷取的线程可能先减，queued_ 回绕
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        // 与 runWorker 中的 sleeping_ / queued_ 检查配对：先写 queued_ 再读 sleeping_，
+        // 对方先写 sleeping_ 再读 queued_，至少一方看到另一方
+        queued_.fetch_add(1, std::memory_order_seq_cst);
+        worker->jobs.push_back(job);
+    }
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_one();
+    }
+}
+
+ComputeJob* ComputePool::take(size_t index)
+{
+    {
+        Worker* self = workers_[index].get();
+        std::lock_guard<std::mutex> lock(self->mutex);
+        if (!self->jobs.empty())
+        {
+            ComputeJob* job = self->jobs.front();
+            self->jobs.pop_front();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+        Worker* victim = workers_[(index + i) % workers_.size()].get();
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if (!victim->jobs.empty())
+        {
+            ComputeJob* job = victim->jobs.back();
+            victim->jobs.pop_back();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void ComputePool::runWorker(size_t index, const ThreadInitCallback& cb)
+{
+    if (cb)
+    {
+        cb(static_cast<int>(index));
+    }
+    while (true)
+    {
+        ComputeJob* job = take(index);
+        if (job != nullptr)
+        {
+            run(job);
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_ && queued_.load() == 0)
+        {
+            break;      // 已提交的任务都执行完了
+        }
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        cond_.wait(lock, [this]() {
+            return queued_.load(std::memory_order_seq_cst) > 0 || !running_;
+        });
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void ComputePool::run(ComputeJob* job)
+{
+    if (job->work)
+    {
+        job->work();
+    }
+    if (job->loop != nullptr)
+    {
+        // 只传递任务指针
+        job->loop->runInLoop([job]() { ComputePool::complete(job); });
+    }
+    else
+    {
+        delete job;
+    }
+}
+
+void ComputePool::complete(ComputeJob* job)
+{
+    if (!job->conn)
+    {
+        if (job->done)
+        {
+            job->done();
+        }
+        delete job;
+        return;
+    }
+
+    ComputeOrder* order = job->conn->computeOrder();
+    if (job->seq != order->nextDone)
+    {
+        order->finished[job->seq] = job;    // 等前面的任务完成
+        return;
+    }
+    // 连接由第一个任务保持到最后：后面的任务释放连接时 order 仍然有效
+    TcpConnectionPtr conn(std::move(job->conn));
+    while (true)
+    {
+        // 先推进序号：done 中再提交的任务可能立即完成
+        ++order->nextDone;
+        if (job->connectionDone)
+        {
+            job->connectionDone(conn);
+        }
+        delete job;
+
+        std::map<uint64_t, ComputeJob*>::iterator it = order->finished.begin();
+        if (it == order->finished.end() || it->first != order->nextDone)
+        {
+            break;
+        }
+        job = it->second;
+        order->finished.erase(it);
+    }
+}
+
+ComputePoolStats ComputePool::stats() const
+{
+    ComputePoolStats stats;
+    stats.submitted = submitted_.load(std::memory_order_relaxed);
+    stats.executed = executed_.load(std::memory_order_relaxed);
+    stats.stolen = stolen_.load(std::memory_order_relaxed);
+    stats.queued = queued_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class EventLoop;
+class Thread;
+struct ComputeJob;
+
+// 计算池统计，任意线程可读
+struct ComputePoolStats
+{
+    uint64_t submitted;     // 提交的任务数
+    uint64_t executed;      // 执行完的任务数
+    uint64_t stolen;        // 从其他工作线程的队列中取走的任务数
+    size_t queued;          // 当前排队（还没开始执行）的任务数
+};
+
+// 一个连接上有序提交的任务的顺序，只在连接的 loop 线程中访问，由 TcpConnection 持有
+struct ComputeOrder
+{
+    ComputeOrder() : nextSeq(0), nextDone(0) {}
+
+    uint64_t nextSeq;                           // 下一个提交的任务的序号
+    uint64_t nextDone;                          // 下一个应该回调 done 的序号
+    std::map<uint64_t, ComputeJob*> finished;   // 已经完成、等待前面的任务的 done
+};
+
+/**************************************************************************************
+ * 计算线程池：把 CPU 密集的处理（压缩、加密、编码）从 IO loop 中移出去，避免一个请求
+ * 卡住同一个 loop 上的其他连接。与 EventLoopThreadPool 无关，工作线程不跑事件循环。
+ *     每个工作线程一个任务队列：loop 线程提交的任务轮流放进各个队列，工作线程先取自己
+ * 队列的队头，自己的队列空了再从其他队列的队尾偷取，一个线程被长任务占住时，它队列中
+ * 的任务由空闲的线程执行。所有队列都空时工作线程睡眠，提交时只有存在睡眠的线程才唤醒。
+ *     work 在工作线程中执行，完成后 done 经 runInLoop 回到指定的 loop 中执行。任务对象
+ * 在提交时分配一次，在线程之间只传递指针，往返不再拷贝 std::function 和 shared_ptr。
+ *
+ *     submit(conn, work, done)：在连接的 loop 线程中调用（通常在 onMessage 中），
+ * 同一连接的 done 按提交顺序执行，先完成的任务等待前面的任务，流水线请求的响应顺序
+ * 不变。任务持有连接，done 的参数就是该连接（不必在 done 中再捕获一份），连接在 done
+ * 执行之前不会析构（done 中可检查 connected()）。廉价的请求可以不带 work 提交，前面
+ * 没有未完成的任务时 done 立即执行，否则排在它们之后。
+ *
+ *     pool.start(4);
+ *     server.setMessageCalback([&pool](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+ *         std::shared_ptr<std::string> data = std::make_shared<std::string>(buf->retrieveAllAsString());
+ *         pool.submit(conn, [data]() { compress(data.get()); },
+ *                           [data](const TcpConnectionPtr& c) { c->send(*data); });
+ *     });
+ *
+ * stop（或析构）时执行完已提交的任务再退出工作线程，之后可以再次 start；start 之前或
+ * stop 之后提交的任务在调用线程中执行。
+**************************************************************************************/
+class ComputePool : noncopyable
+{
+public:
+    using Task = std::function<void()>;
+    using ConnectionTask = std::function<void (const TcpConnectionPtr&)>;
+    // 工作线程开始时调用，参数为线程编号（设置 CPU 亲和性、调度优先级等）
+    using ThreadInitCallback = std::function<void (int index)>;
+
+    explicit ComputePool(const std::string& name = std::string("ComputePool"));
+    ~ComputePool();
+
+    void start(int numThreads, const ThreadInitCallback& cb = ThreadInitCallback());
+    void stop();
+
+    // 无序提交：任意线程调用，done 在 loop 中执行（loop 为空或 done 为空时不回调）
+    void submit(EventLoop* loop, Task work, Task done);
+    // 有序提交：在 conn 的 loop 线程中调用，work 为空时不经过工作线程，只排在前面的任务之后
+    void submit(const TcpConnectionPtr& conn, Task work, ConnectionTask done);
+
+    const std::string& name() const {   return name_;   }
+    int numThreads() const {    return static_cast<int>(workers_.size());   }
+    ComputePoolStats stats() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<ComputeJob*> jobs;
+        std::unique_ptr<Thread> thread;
+    };
+
+    void push(ComputeJob* job);
+    // 先取自己的队头，再从其他队列的队尾偷取
+    ComputeJob* take(size_t index);
+    void runWorker(size_t index, const ThreadInitCallback& cb);
+    // 执行 work，把任务交回 loop
+    static void run(ComputeJob* job);
+    // 在 loop 线程中执行 done，有序任务按序号排队
+    static void complete(ComputeJob* job);
+
+    const std::string name_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_;          // 轮流选择队列
+
+    std::mutex mutex_;                  // 保护 cond_ 上的睡眠和唤醒
+    std::condition_variable cond_;
+    std::atomic<int> sleeping_;         // 正在睡眠的工作线程数
+    std::atomic<size_t> queued_;        // 所有队列中的任务数
+    std::atomic<bool> running_;
+
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> executed_;
+    std::atomic<uint64_t> stolen_;
+};
@@ -0,0 +1,333 @@
+#include "ConnectionPool.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Socket.h"
+#include "Logger.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+const size_t ConnectionPool::kDefaultMinIdle;
+const size_t ConnectionPool::kDefaultMaxConnections;
+
+// 淘汰空闲连接、检查排队超时的间隔
+static const double kMaintainInterval = 0.1;
+
+ConnectionPool::ConnectionPool(EventLoop* loop, const InetAddress& backendAddr, const std::string& name)
+    : loop_(loop),
+      backendAddr_(backendAddr),
+      name_(name),
+      callbacks_(std::make_shared<ConnectionCallbacks>()),
+      minIdle_(kDefaultMinIdle),
+      maxConnections_(kDefaultMaxConnections),
+      idleTimeout_(60.0),
+      checkoutTimeout_(1.0),
+      initialRetryMs_(Connector::kDefaultInitialRetryMs),
+      maxRetryMs_(Connector::kDefaultMaxRetryMs),
+      started_(false),
+      nextConnId_(1),
+      reopenAfterMicros_(0),
+      reopenDelayMs_(Connector::kDefaultInitialRetryMs),
+      created_(0),
+      reused_(0),
+      evicted_(0),
+      connectFailures_(0),
+      checkoutTimeouts_(0)
+{
+    callbacks_->namePrefix = name_ + "-" + backendAddr_.toIpPort() + "#";
+    callbacks_->messageCallback = std::bind(&ConnectionPool::onMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    callbacks_->closeCallback = std::bind(&ConnectionPool::onClose, this, std::placeholders::_1);
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    if (started_)
+    {
+        loop_->cancel(maintainTimer_);
+    }
+    for (const ConnectorPtr& connector : connectors_)
+    {
+        connector->stop();
+    }
+
+    // 回调引用了 this：换成只销毁连接的回调再关闭
+    EventLoop* loop = loop_;
+    callbacks_->messageCallback = nullptr;
+    callbacks_->closeCallback = [loop](const TcpConnectionPtr& conn) {
+        loop->queueInLoop(std::bind(&TcpConnection::connectDistroyed, conn));
+    };
+    for (auto& item : members_)
+    {
+        item.second.conn->forceClose();
+    }
+}
+
+void ConnectionPool::start()
+{
+    loop_->runInLoop(std::bind(&ConnectionPool::startInLoop, this));
+}
+
+void ConnectionPool::startInLoop()
+{
+    if (started_)
+    {
+        return;
+    }
+    started_ = true;
+    reopenDelayMs_ = initialRetryMs_;
+    maintainTimer_ = loop_->runEvery(kMaintainInterval, std::bind(&ConnectionPool::maintain, this));
+    replenish();
+}
+
+void ConnectionPool::openConnection()
+{
+    ConnectorPtr connector = std::make_shared<Connector>(loop_, backendAddr_);
+    connector->setRetryDelay(initialRetryMs_, maxRetryMs_);
+    connector->setNewConnectionCallback(
+        std::bind(&ConnectionPool::newConnection, this, connector.get(), std::placeholders::_1));
+    connector->setErrorCallback(std::bind(&ConnectionPool::onConnectError, this, std::placeholders::_1));
+    connector->setGiveUpCallback(
+        std::bind(&ConnectionPool::onConnectGiveUp, this, connector.get(), std::placeholders::_1));
+    connectors_.push_back(connector);
+    connector->start();
+}
+
+// 保持 minIdle 个可用（空闲或正在建立）的连接，并为每个排队的 checkout 准备一个
+void ConnectionPool::replenish()
+{
+    size_t total = members_.size() + connectors_.size();
+    size_t available = idle_.size() + connectors_.size();
+    size_t wanted = minIdle_ + waiters_.size();
+    // Connector 放弃后的等待期内不建立连接，由 maintain 定时检查（connect 可能同步失败，每次都要检查）
+    while (available < wanted && total < maxConnections_
+           && Timestamp::monotonicMicros() >= reopenAfterMicros_)
+    {
+        openConnection();
+        ++available;
+        ++total;
+    }
+}
+
+void ConnectionPool::removeConnector(Connector* connector)
+{
+    for (size_t i = 0; i < connectors_.size(); ++i)
+    {
+        if (connectors_[i].get() == connector)
+        {
+            // 正在 connector 的回调中，延后释放
+            ConnectorPtr done(connectors_[i]);
+            connectors_[i] = connectors_.back();
+            connectors_.pop_back();
+            loop_->queueInLoop([done]() {});
+            break;
+        }
+    }
+}
+
+void ConnectionPool::newConnection(Connector* connector, int sockfd)
+{
+    removeConnector(connector);
+    reopenDelayMs_ = initialRetryMs_;
+
+    TcpConnectionPtr conn = std::make_shared<TcpConnection>(
+        loop_, sockfd, Socket::localAddress(sockfd), backendAddr_, nextConnId_++, callbacks_);
+    conn->setTcpNoDelay(true);
+    members_[conn->id()] = Member{ conn, false };
+    ++created_;
+    conn->connectEstablished();
+
+    if (conn->connected())
+    {
+        park(conn);
+    }
+}
+
+void ConnectionPool::onConnectError(int err)
+{
+    ++connectFailures_;
+    LOG_ERROR("ConnectionPool [%s] connect %s errno %d\n", name_.c_str(), backendAddr_.toIpPort().c_str(), err);
+}
+
+// Connector 不再重试：从池中移除，等待一段时间后由 maintain 中的 replenish 建立新的
+void ConnectionPool::onConnectGiveUp(Connector* connector, int err)
+{
+    removeConnector(connector);
+    reopenAfterMicros_ = Timestamp::monotonicMicros() + static_cast<int64_t>(reopenDelayMs_) * 1000;
+    LOG_ERROR("ConnectionPool [%s] connector to %s gave up (errno %d), reopen in %d ms\n",
+        name_.c_str(), backendAddr_.toIpPort().c_str(), err, reopenDelayMs_);
+    reopenDelayMs_ = reopenDelayMs_ * 2 < maxRetryMs_ ? reopenDelayMs_ * 2 : maxRetryMs_;
+}
+
+// 连接可用：先交给排队最久的 checkout，没有排队的则放入空闲列表
+void ConnectionPool::park(const TcpConnectionPtr& conn)
+{
+    Member& member = members_[conn->id()];
+    if (!waiters_.empty())
+    {
+        CheckoutCallback callback(std::move(waiters_.front().callback));
+        waiters_.pop_front();
+        member.idle = false;
+        callback(conn);
+        return;
+    }
+    member.idle = true;
+    idle_.push_back(IdleEntry{ conn, Timestamp::monotonicMicros() });
+}
+
+TcpConnectionPtr ConnectionPool::tryCheckout()
+{
+    TcpConnectionPtr conn;
+    while (!idle_.empty())
+    {
+        TcpConnectionPtr candidate(std::move(idle_.back().conn));
+        idle_.pop_back();
+        if (candidate->connected())
+        {
+            members_[candidate->id()].idle = false;
+            ++reused_;
+            conn.swap(candidate);
+            break;
+        }
+    }
+    replenish();
+    return conn;
+}
+
+void ConnectionPool::checkout(const CheckoutCallback& cb)
+{
+    TcpConnectionPtr conn = tryCheckout();
+    if (conn)
+    {
+        cb(conn);
+        return;
+    }
+    int64_t timeout = static_cast<int64_t>(checkoutTimeout_ * 1000 * 1000);
+    waiters_.push_back(Waiter{ cb, Timestamp::monotonicMicros() + timeout });
+    replenish();
+}
+
+void ConnectionPool::checkin(const TcpConnectionPtr& conn, bool reusable)
+{
+    auto it = members_.find(conn->id());
+    if (it == members_.end() || it->second.conn != conn || it->second.idle)
+    {
+        return;
+    }
+    if (!reusable || !conn->connected())
+    {
+        evict(conn);
+        return;
+    }
+    if (!waiters_.empty())
+    {
+        ++reused_;
+    }
+    park(conn);
+}
+
+void ConnectionPool::evict(const TcpConnectionPtr& conn)
+{
+    ++evicted_;
+    conn->forceClose();
+}
+
+void ConnectionPool::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+{
+    auto it = members_.find(conn->id());
+    if (it != members_.end() && it->second.idle)
+    {
+        // 空闲连接上不应有数据，之后的响应无法对应到请求
+        LOG_ERROR("ConnectionPool [%s] unexpected data on idle connection %s\n",
+            name_.c_str(), conn->name().c_str());
+        buf->retrieveAll();
+        evict(conn);
+        return;
+    }
+    if (messageCallback_)
+    {
+        messageCallback_(conn, buf, receiveTime);
+    }
+    else
+    {
+        buf->retrieveAll();
+    }
+}
+
+void ConnectionPool::onClose(const TcpConnectionPtr& conn)
+{
+    auto it = members_.find(conn->id());
+    if (it != members_.end())
+    {
+        bool idle = it->second.idle;
+        members_.erase(it);
+        if (idle)
+        {
+            for (auto entry = idle_.begin(); entry != idle_.end(); ++entry)
+            {
+                if (entry->conn == conn)
+                {
+                    idle_.erase(entry);
+                    break;
+                }
+            }
+        }
+        else if (connectionCallback_)
+        {
+            connectionCallback_(conn);
+        }
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDistroyed, conn));
+
+    if (started_)
+    {
+        replenish();
+    }
+}
+
+void ConnectionPool::maintain()
+{
+    int64_t now = Timestamp::monotonicMicros();
+
+    // 超时时间相同，排在前面的先到期
+    while (!waiters_.empty() && waiters_.front().deadline <= now)
+    {
+        CheckoutCallback callback(std::move(waiters_.front().callback));
+        waiters_.pop_front();
+        ++checkoutTimeouts_;
+        callback(TcpConnectionPtr());
+    }
+
+    // 超过 minIdle 的部分从最久未用的开始关闭
+    int64_t idleTimeout = static_cast<int64_t>(idleTimeout_ * 1000 * 1000);
+    while (idle_.size() > minIdle_ && now - idle_.front().since > idleTimeout)
+    {
+        TcpConnectionPtr conn(std::move(idle_.front().conn));
+        idle_.pop_front();
+        evict(conn);
+    }
+
+    replenish();
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const
+{
+    Stats stats;
+    stats.idle = 0;
+    for (const auto& item : members_)
+    {
+        if (item.second.idle)
+        {
+            ++stats.idle;
+        }
+    }
+    stats.busy = members_.size() - stats.idle;
+    stats.connecting = connectors_.size();
+    stats.waiters = waiters_.size();
+    stats.created = created_;
+    stats.reused = reused_;
+    stats.evicted = evicted_;
+    stats.connectFailures = connectFailures_;
+    stats.checkoutTimeouts = checkoutTimeouts_;
+    return stats;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "Connector.h"
+#include "InetAddress.h"
+#include "Timer.h"
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class EventLoop;
+
+/**************************************************************************************
+ * 到一个后端地址的出站连接池，每个 loop 一个（通常在 TcpServer 的 ThreadInitCallback
+ * 中为每个 IO loop 创建）。池中所有状态只在所属 loop 线程中访问，借出、归还都不加锁。
+ *     start 后预先建立 minIdle 个连接；借出一个空闲连接后立即补充，保持 minIdle 个连接
+ * 处于空闲可用状态（连接总数不超过 maxConnections）。最近归还的连接优先借出；没有空闲
+ * 连接时 checkout 排队等待新连接或其他连接归还，超过 checkoutTimeout 以空指针回调。
+ *     以下连接被淘汰（关闭）：对端关闭或出错、空闲时收到数据（协议已经错乱）、归还时
+ * 标记为不可复用、超过 minIdle 的部分空闲超过 idleTimeout。连接失败由 Connector 按指数
+ * 退避重试；Connector 遇到不可重试的错误放弃时从池中移除，同样按指数退避再建立新的。
+ *     借出的连接的消息和断开通知转给 setMessageCallback / setConnectionCallback 设置的回调，
+ * 应用一般用 TcpConnection::setContext 记录连接当前服务的请求。
+ *
+ *     ConnectionPool pool(ioLoop, InetAddress(6379), "redis");
+ *     pool.setMinIdle(8);
+ *     pool.setMessageCallback(onBackendMessage);
+ *     pool.start();
+ *     ...
+ *     pool.checkout([](const TcpConnectionPtr& backend) {     // ioLoop 线程中
+ *         if (backend) backend->send(request);
+ *     });
+ *     ...
+ *     pool.checkin(backend);                                 // 收到完整响应后归还
+**************************************************************************************/
+class ConnectionPool : noncopyable
+{
+public:
+    using CheckoutCallback = std::function<void (const TcpConnectionPtr&)>;
+
+    static const size_t kDefaultMinIdle = 4;
+    static const size_t kDefaultMaxConnections = 256;
+
+    ConnectionPool(EventLoop* loop, const InetAddress& backendAddr, const std::string& name);
+    // 在 loop 线程中（或 loop 退出之后）析构：关闭所有连接，排队的 checkout 不再回调
+    ~ConnectionPool();
+
+    // 以下设置在 start 之前调用
+    void setMinIdle(size_t n) { minIdle_ = n;   }
+    void setMaxConnections(size_t n) {  maxConnections_ = n;    }
+    void setIdleTimeout(double seconds) {   idleTimeout_ = seconds; }
+    void setCheckoutTimeout(double seconds) {   checkoutTimeout_ = seconds; }
+    void setRetryDelay(int initialMs, int maxMs)
+    {
+        initialRetryMs_ = initialMs;
+        maxRetryMs_ = maxMs;
+    }
+    // 借出的连接断开时回调
+    void setConnectionCallback(const ConnectionCallback& cb) {  connectionCallback_ = cb;   }
+    // 借出的连接收到数据时回调
+    void setMessageCallback(const MessageCallback& cb) {    messageCallback_ = cb;  }
+
+    // 任意线程可调用：开始预热连接
+    void start();
+
+    // 以下在 loop 线程中调用
+    // 有空闲连接时立即借出，否则返回空（并在未达上限时开始建立新连接）
+    TcpConnectionPtr tryCheckout();
+    // 有空闲连接时立即回调，否则排队，超时以空指针回调
+    void checkout(const CheckoutCallback& cb);
+    // 归还借出的连接，reusable 为 false 时（如响应不完整、出错）关闭连接
+    void checkin(const TcpConnectionPtr& conn, bool reusable = true);
+
+    struct Stats
+    {
+        size_t idle;
+        size_t busy;
+        size_t connecting;
+        size_t waiters;
+        uint64_t created;           // 建立的连接数
+        uint64_t reused;            // 借出空闲连接的次数
+        uint64_t evicted;           // 淘汰的连接数
+        uint64_t connectFailures;
+        uint64_t checkoutTimeouts;
+    };
+    Stats stats() const;
+
+    EventLoop* getLoop() const {    return loop_;   }
+
+private:
+    struct Member
+    {
+        TcpConnectionPtr conn;
+        bool idle;
+    };
+    struct IdleEntry
+    {
+        TcpConnectionPtr conn;
+        int64_t since;              // 开始空闲的时间（monotonicMicros）
+    };
+    struct Waiter
+    {
+        CheckoutCallback callback;
+        int64_t deadline;
+    };
+
+    void startInLoop();
+    void openConnection();
+    void replenish();
+    void newConnection(Connector* connector, int sockfd);
+    void onConnectError(int err);
+    void onConnectGiveUp(Connector* connector, int err);
+    void removeConnector(Connector* connector);
+    void park(const TcpConnectionPtr& conn);
+    void evict(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+    void onClose(const TcpConnectionPtr& conn);
+    void maintain();
+
+    EventLoop* loop_;
+    const InetAddress backendAddr_;
+    const std::string name_;
+    ConnectionCallbacksPtr callbacks_;
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+
+    size_t minIdle_;
+    size_t maxConnections_;
+    double idleTimeout_;
+    double checkoutTimeout_;
+    int initialRetryMs_;
+    int maxRetryMs_;
+
+    bool started_;
+    TimerId maintainTimer_;
+    ConnectionId nextConnId_;
+    std::vector<ConnectorPtr> connectors_;                  // 正在建立的连接
+    int64_t reopenAfterMicros_;                             // Connector 放弃后，到这个时间（monotonicMicros）之前不再建立连接
+    int reopenDelayMs_;                                     // 下次放弃后的等待时间，指数退避
+    std::unordered_map<ConnectionId, Member> members_;      // 已建立的全部连接
+    std::deque<IdleEntry> idle_;                            // 尾部是最近归还的
+    std::deque<Waiter> waiters_;
+
+    uint64_t created_;
+    uint64_t reused_;
+    uint64_t evicted_;
+    uint64_t connectFailures_;
+    uint64_t checkoutTimeouts_;
+};
@@ -0,0 +1,72 @@
+#include "ConnectionRegistry.h"
+#include "TcpConnection.h"
+
+ConnectionRegistry::ConnectionRegistry()
+    : size_(0)
+{
+    for (Shard& shard : shards_)
+    {
+        pthread_rwlock_init(&shard.lock, nullptr);
+    }
+}
+
+ConnectionRegistry::~ConnectionRegistry()
+{
+    for (Shard& shard : shards_)
+    {
+        pthread_rwlock_destroy(&shard.lock);
+    }
+}
+
+void ConnectionRegistry::add(ConnectionId id, const TcpConnectionPtr& conn)
+{
+    Shard& shard = shardOf(id);
+
+    pthread_rwlock_wrlock(&shard.lock);
+    bool inserted = shard.connections.emplace(id, conn).second;
+    pthread_rwlock_unlock(&shard.lock);
+
+    if (inserted)
+    {
+        ++size_;
+    }
+}
+
+void ConnectionRegistry::remove(ConnectionId id)
+{
+    Shard& shard = shardOf(id);
+
+    pthread_rwlock_wrlock(&shard.lock);
+    size_t n = shard.connections.erase(id);
+    pthread_rwlock_unlock(&shard.lock);
+
+    size_ -= n;
+}
+
+TcpConnectionPtr ConnectionRegistry::find(ConnectionId id) const
+{
+    const Shard& shard = shardOf(id);
+    TcpConnectionPtr conn;
+
+    pthread_rwlock_rdlock(&shard.lock);
+    auto it = shard.connections.find(id);
+    if (it != shard.connections.end())
+    {
+        conn = it->second.lock();      // 提升失败表示连接已经析构
+    }
+    pthread_rwlock_unlock(&shard.lock);
+
+    return conn;
+}
+
+bool ConnectionRegistry::send(ConnectionId id, const std::string& msg) const
+{
+    // 锁外发送：send 可能跨线程投递到连接所在 loop
+    TcpConnectionPtr conn = find(id);
+    if (conn && conn->connected())
+    {
+        conn->send(msg);
+        return true;
+    }
+    return false;
+}
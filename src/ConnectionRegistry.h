@@ -0,0 +1,49 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+
+#include <string>
+#include <atomic>
+#include <unordered_map>
+#include <pthread.h>
+
+/**************************************************************************************
+ * 连接注册表：ConnectionId --> TcpConnection 弱引用
+ *     TcpServer::connections_ 只能在 baseloop 中访问，业务线程需要按连接编号推送数据时，
+ * 通过注册表查找连接。注册表按编号分片，每个分片一把读写锁，查找只加所在分片的读锁，
+ * 不存在全局锁。保存 weak_ptr，不延长连接的生命周期；连接在 connectDistroyed 时注销。
+**************************************************************************************/
+class ConnectionRegistry : noncopyable
+{
+public:
+    ConnectionRegistry();
+    ~ConnectionRegistry();
+
+    void add(ConnectionId id, const TcpConnectionPtr& conn);
+    void remove(ConnectionId id);
+
+    // 查找连接，连接不存在或已经销毁时返回空指针
+    TcpConnectionPtr find(ConnectionId id) const;
+
+    // 任意线程调用：找到连接并发送，连接不存在返回 false
+    bool send(ConnectionId id, const std::string& msg) const;
+
+    size_t size() const {   return size_.load(std::memory_order_relaxed);    }
+
+private:
+    static const int kNumShards = 16;
+
+    // 每个分片独占缓存行，避免不同分片的锁互相干扰
+    struct alignas(64) Shard
+    {
+        mutable pthread_rwlock_t lock;
+        std::unordered_map<ConnectionId, TcpConnectionWeakPtr> connections;
+    };
+
+    Shard& shardOf(ConnectionId id)   {   return shards_[id % kNumShards];    }
+    const Shard& shardOf(ConnectionId id) const {   return shards_[id % kNumShards];    }
+
+    Shard shards_[kNumShards];
+    std::atomic<size_t> size_;
+};
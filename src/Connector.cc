@@ -0,0 +1,237 @@
+#include "Connector.h"
+#include "Channel.h"
+#include "Socket.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+const int Connector::kDefaultInitialRetryMs;
+const int Connector::kDefaultMaxRetryMs;
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
+    : loop_(loop),
+      serverAddr_(serverAddr),
+      connect_(false),
+      state_(kDisconnected),
+      initialRetryDelayMs_(kDefaultInitialRetryMs),
+      maxRetryDelayMs_(kDefaultMaxRetryMs),
+      retryDelayMs_(kDefaultInitialRetryMs)
+{
+}
+
+Connector::~Connector()
+{
+    if (channel_)
+    {
+        LOG_ERROR("Connector::dtor[%s] destroyed while connecting\n", serverAddr_.toIpPort().c_str());
+    }
+}
+
+void Connector::start()
+{
+    connect_ = true;
+    ConnectorPtr self(shared_from_this());
+    loop_->runInLoop([self]() { self->startInLoop(); });
+}
+
+void Connector::startInLoop()
+{
+    if (connect_ && state_ == kDisconnected)
+    {
+        connect();
+    }
+}
+
+void Connector::restart()
+{
+    state_ = kDisconnected;
+    retryDelayMs_ = initialRetryDelayMs_;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::stop()
+{
+    connect_ = false;
+    ConnectorPtr self(shared_from_this());
+    loop_->queueInLoop([self]() { self->stopInLoop(); });
+}
+
+void Connector::stopInLoop()
+{
+    loop_->cancel(retryTimer_);
+    if (state_ == kConnecting)
+    {
+        state_ = kDisconnected;
+        ::close(removeAndResetChannel());
+    }
+}
+
+void Connector::connect()
+{
+    int sockfd = ::socket(serverAddr_.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0)
+    {
+        LOG_ERROR("Connector::connect [%s] socket errno %d\n", serverAddr_.toIpPort().c_str(), errno);
+        retry(-1, errno);
+        return;
+    }
+
+    int ret = ::connect(sockfd, serverAddr_.getSockAddr(), serverAddr_.length());
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno)
+    {
+    case 0:
+    case EINPROGRESS:
+    case EINTR:
+    case EISCONN:
+        connecting(sockfd);         // 等待 socket 可写
+        break;
+
+    case EAGAIN:                    // 本地临时端口用完
+    case EADDRINUSE:
+    case EADDRNOTAVAIL:
+    case ECONNREFUSED:
+    case ENETUNREACH:
+    case EHOSTUNREACH:
+    case ETIMEDOUT:
+        retry(sockfd, savedErrno);
+        break;
+
+    case ENOENT:                    // unix 域 socket 文件还没创建（服务端尚未启动）
+        if (serverAddr_.isUnix())
+        {
+            retry(sockfd, savedErrno);
+            break;
+        }
+        // fallthrough
+    default:                        // 地址、权限等错误，重试也不会成功
+        LOG_ERROR("Connector::connect [%s] errno %d, give up\n", serverAddr_.toIpPort().c_str(), savedErrno);
+        ::close(sockfd);
+        if (!connect_)
+        {
+            break;
+        }
+        connect_ = false;
+        if (errorCallback_)
+        {
+            errorCallback_(savedErrno);
+        }
+        if (giveUpCallback_)
+        {
+            giveUpCallback_(savedErrno);
+        }
+        break;
+    }
+}
+
+void Connector::connecting(int sockfd)
+{
+    state_ = kConnecting;
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    channel_->setErrorCallback(std::bind(&Connector::handleError, this));
+    channel_->enableWriting();
+}
+
+// channel 正在执行回调，不能在这里析构，放到本轮事件处理完之后
+int Connector::removeAndResetChannel()
+{
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    Channel* channel = channel_.release();
+    loop_->queueInLoop([channel]() { delete channel; });
+    return sockfd;
+}
+
+static bool isSelfConnect(int sockfd, const InetAddress& serverAddr)
+{
+    if (serverAddr.isUnix())
+    {
+        return false;
+    }
+    InetAddress local = Socket::localAddress(sockfd);
+    return local.toPort() != 0 && local == Socket::peerAddress(sockfd);
+}
+
+void Connector::handleWrite()
+{
+    if (state_ != kConnecting)
+    {
+        return;
+    }
+    int sockfd = removeAndResetChannel();
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+    {
+        err = errno;
+    }
+    if (err == 0 && isSelfConnect(sockfd, serverAddr_))
+    {
+        // 目标端口没有监听、恰好分到相同的临时端口时会连上自己
+        err = ECONNREFUSED;
+    }
+    if (err != 0)
+    {
+        retry(sockfd, err);
+        return;
+    }
+
+    state_ = kConnected;
+    if (connect_ && newConnectionCallback_)
+    {
+        newConnectionCallback_(sockfd);
+    }
+    else
+    {
+        ::close(sockfd);
+    }
+}
+
+void Connector::handleError()
+{
+    if (state_ == kConnecting)
+    {
+        int sockfd = removeAndResetChannel();
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len);
+        retry(sockfd, err);
+    }
+}
+
+void Connector::retry(int sockfd, int err)
+{
+    if (sockfd >= 0)
+    {
+        ::close(sockfd);
+    }
+    state_ = kDisconnected;
+    if (!connect_)
+    {
+        return;     // 已经 stop，回调的对象可能已经析构
+    }
+    if (errorCallback_)
+    {
+        errorCallback_(err);
+    }
+
+    LOG_INFO("Connector::retry [%s] errno %d, retry in %d ms\n",
+        serverAddr_.toIpPort().c_str(), err, retryDelayMs_);
+    std::weak_ptr<Connector> weak(shared_from_this());
+    retryTimer_ = loop_->runAfter(retryDelayMs_ / 1000.0, [weak]() {
+        ConnectorPtr self = weak.lock();
+        if (self)
+        {
+            self->startInLoop();
+        }
+    });
+    retryDelayMs_ = retryDelayMs_ * 2 < maxRetryDelayMs_ ? retryDelayMs_ * 2 : maxRetryDelayMs_;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "Timer.h"
+
+#include <functional>
+#include <memory>
+
+class Channel;
+class EventLoop;
+
+/**************************************************************************************
+ * 主动发起连接，对应服务端的 Acceptor：在 loop 中非阻塞地 connect，socket 可写后检查
+ * SO_ERROR，连接成功时把 sockfd 交给 NewConnectionCallback（之后由调用方创建
+ * TcpConnection）；失败时按指数退避重试，重试间隔从 initialRetryDelay 开始每次翻倍，
+ * 不超过 maxRetryDelay。
+ *     Connector 用 shared_ptr 管理，重试定时器只持有弱引用，stop 之后不再回调。
+ * start / stop / restart 任意线程可调用，回调在 loop 线程中执行。
+**************************************************************************************/
+class Connector : noncopyable,
+                  public std::enable_shared_from_this<Connector>
+{
+public:
+    using NewConnectionCallback = std::function<void (int sockfd)>;
+    // 每次连接失败时回调（之后仍会重试），errno 为失败原因
+    using ErrorCallback = std::function<void (int err)>;
+    // 遇到重试也不会成功的错误（地址、权限等）而放弃时回调，之后不再重试
+    using GiveUpCallback = std::function<void (int err)>;
+
+    static const int kDefaultInitialRetryMs = 500;
+    static const int kDefaultMaxRetryMs = 30 * 1000;
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb) {    newConnectionCallback_ = cb;    }
+    void setErrorCallback(const ErrorCallback& cb) {    errorCallback_ = cb;    }
+    void setGiveUpCallback(const GiveUpCallback& cb) {  giveUpCallback_ = cb;   }
+    // 重试间隔（毫秒），start 之前设置
+    void setRetryDelay(int initialMs, int maxMs)
+    {
+        initialRetryDelayMs_ = initialMs;
+        maxRetryDelayMs_ = maxMs;
+        retryDelayMs_ = initialMs;
+    }
+
+    const InetAddress& serverAddress() const {  return serverAddr_; }
+
+    void start();
+    // 重新开始连接，重试间隔恢复为初始值，在 loop 线程中调用（如连接断开之后）
+    void restart();
+    // stop 之后（在 loop 线程中）不再调用任何回调，回调引用的对象可以随即析构
+    void stop();
+
+private:
+    enum State
+    {
+        kDisconnected,
+        kConnecting,
+        kConnected,
+    };
+
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void retry(int sockfd, int err);
+    int removeAndResetChannel();
+
+    EventLoop* loop_;
+    InetAddress serverAddr_;
+    bool connect_;
+    State state_;
+    std::unique_ptr<Channel> channel_;      // 正在连接的 socket，连接成功或失败后移除
+    NewConnectionCallback newConnectionCallback_;
+    ErrorCallback errorCallback_;
+    GiveUpCallback giveUpCallback_;
+    int initialRetryDelayMs_;
+    int maxRetryDelayMs_;
+    int retryDelayMs_;
+    TimerId retryTimer_;
+};
+
+using ConnectorPtr = std::shared_ptr<Connector>;
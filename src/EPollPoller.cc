@@ -34,7 +34,7 @@ EPollPoller::~EPollPoller()
 **********************************************************************************************/
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
 {
-    LOG_INFO("func = %s => fd total count: %ld\n", __FUNCTION__, channels_.size());
+    LOG_DEBUG("func = %s => fd total count: %ld\n", __FUNCTION__, channels_.size());
 
     int numEvents = ::epoll_wait(epollfd_, 
                                 &*events_.begin(), 
@@ -46,7 +46,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
 
     if (numEvents > 0)
     {
-        LOG_INFO("%d events happened\n", numEvents);
+        LOG_DEBUG("%d events happened\n", numEvents);
         fillActiveChannels(numEvents, activeChannels);
 
         // LT 模式
@@ -57,7 +57,7 @@ Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
     }
     else if (numEvents == 0)
     {
-        LOG_INFO("%s timeout, nothing happened!", __FUNCTION__);
+        LOG_RATELIMIT(INFO, 1, "%s timeout, nothing happened!", __FUNCTION__);
     }
     else
     {
@@ -85,7 +85,7 @@ void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
 void EPollPoller::updateChannel(Channel* channel)
 {
     const int index = channel->index();
-    LOG_INFO("func = %s => fd = %d, events = %d, index = %d \n", 
+    LOG_DEBUG("func = %s => fd = %d, events = %d, index = %d \n", 
             __FUNCTION__, channel->fd(), channel->events(), index);
 
     // channel 未添加，或者添加后删除
@@ -122,7 +122,7 @@ void EPollPoller::removeChannel(Channel* channel)
     int fd = channel->fd();
     channels_.erase(fd);     // Poller 中 channelMap 中删除
 
-    LOG_INFO("func = %s => fd = %d\n", 
+    LOG_DEBUG("func = %s => fd = %d\n", 
             __FUNCTION__, channel->fd());
 
     const int index = channel->index();
@@ -141,8 +141,7 @@ void EPollPoller::update(int operation, Channel* channel)
 
     int fd = channel->fd();
     event.events = channel->events();
-    event.data.ptr = channel;
-    event.data.fd = fd;
+    event.data.ptr = channel;       // data 是 union，只能保存 channel 指针
 
     if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
     {
@@ -2,11 +2,13 @@
 #include "Logger.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <error.h>
+#include <signal.h>
 #include <memory>
 
 
@@ -15,6 +17,17 @@
 __thread EventLoop* t_loopInThisThread = nullptr;
 
 
+// 对端关闭后继续 write 会收到 SIGPIPE，默认动作是终止进程，网络库统一忽略
+class IgnoreSigPipe
+{
+public:
+    IgnoreSigPipe()
+    {
+        ::signal(SIGPIPE, SIG_IGN);
+    }
+};
+IgnoreSigPipe initObj;
+
 // 默认的 Poller IO复用接口的超时时间，10s
 const int kPollTimeMs = 10000;
 
@@ -34,9 +47,16 @@ EventLoop::EventLoop()
       quit_(false),
       callingPendingFunctors_(false),
       threadId_(CurrentThread::tid()),
+      pollReturnTime_(Timestamp::now()),
+      pollReturnMonotonic_(Timestamp::monotonicMicros()),
+      iteration_(0),
       poller_(Poller::newDefaultPoller(this)),
       wakeupFd_(createEventfd()),
-      wakeupChannel_(new Channel(this, wakeupFd_))
+      wakeupChannel_(new Channel(this, wakeupFd_)),
+      timerQueue_(new TimerQueue(this)),
+      pendingSince_(0),
+      queueDelay_(0),
+      lagMicros_(0)
 {
     LOG_DEBUG("EventLoop created %p in thread %d", this, threadId_);
     if (t_loopInThisThread)
@@ -85,13 +105,21 @@ void EventLoop::loop()
     {
         activeChannels_.clear();
         // 监听两类fd 1. client fd 2. wakeup fd
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        // 还有上一轮用完预算的连接等待处理时不阻塞
+        pollReturnTime_ = poller_->poll(readyFunctors_.empty() ? kPollTimeMs : 0, &activeChannels_);
+        pollReturnMonotonic_ = Timestamp::monotonicMicros();
+        ++iteration_;
+        // 只执行上一轮登记的 cb，本轮处理 channel 时登记的留到下一轮
+        std::vector<Functor> readyFunctors;
+        readyFunctors.swap(readyFunctors_);
 
         for (Channel* channel : activeChannels_)
         {
             // Poller 监听哪些 channel 发生事件，然后通知 EventLoop ，通知channel处理相应的事件
             channel->handleEvent(pollReturnTime_);
         }
+        // 上一轮用完读取预算的连接排在本轮所有活跃 channel 之后
+        doReadyFunctors(readyFunctors);
 
         // 执行当前 EventLoop 事件循环需要处理的回调操作
         /**
@@ -101,6 +129,18 @@ void EventLoop::loop()
          * 唤醒 subReactor 后，执行回调方法，即MainLoop 注册的回调函数
          */
         doPendingFunctors();
+
+        // 合并写：本轮所有事件和回调产生的 send 在这里统一写出；
+        // 写出时又产生的回调（如 writeComplete）也在本轮执行，不必等下一次 poll
+        while (!afterEventsFunctors_.empty())
+        {
+            doAfterEventsFunctors();
+            doPendingFunctors();
+        }
+
+        int64_t busy = Timestamp::monotonicMicros() - pollReturnMonotonic_;
+        updateLag(busy > queueDelay_ ? busy : queueDelay_);
+        queueDelay_ = 0;
     }
 
     LOG_INFO("EventLoop %p stop looping. \n", this);
@@ -137,6 +177,10 @@ void EventLoop::queueInLoop(Functor cb)
 {
     {
         std::unique_lock<std::mutex> lock(mutex_);
+        if (pendingFunctors_.empty())
+        {
+            pendingSince_ = Timestamp::monotonicMicros();
+        }
         pendingFunctors_.emplace_back(cb);
     }
 
@@ -148,6 +192,16 @@ void EventLoop::queueInLoop(Functor cb)
     }
 }
 
+void EventLoop::queueAfterEvents(Functor cb)
+{
+    afterEventsFunctors_.push_back(std::move(cb));
+}
+
+void EventLoop::queueReady(Functor cb)
+{
+    readyFunctors_.push_back(std::move(cb));
+}
+
 void EventLoop::wakeup()
 {
     uint64_t one = 1;
@@ -159,6 +213,23 @@ void EventLoop::wakeup()
     }
 }
 
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+    int64_t when = Timestamp::monotonicMicros() + static_cast<int64_t>(delay * 1000 * 1000);
+    return timerQueue_->addTimer(std::move(cb), when, 0);
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    int64_t micros = static_cast<int64_t>(interval * 1000 * 1000);
+    return timerQueue_->addTimer(std::move(cb), Timestamp::monotonicMicros() + micros, micros);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
+}
+
 void EventLoop::updateChannel(Channel* channel)
 {
     poller_->updateChannel(channel);
@@ -179,14 +250,49 @@ void EventLoop::doPendingFunctors()
     std::vector<Functor> functors;
     callingPendingFunctors_ = true;
 
+    int64_t since;
     {
         std::unique_lock<std::mutex> lock(mutex_);
         functors.swap(pendingFunctors_);
+        since = pendingSince_;
     }
 
+    if (!functors.empty())
+    {
+        int64_t delay = Timestamp::monotonicMicros() - since;
+        if (delay > queueDelay_)
+        {
+            queueDelay_ = delay;
+        }
+    }
     for (const Functor& functor : functors)
     {
         functor();
     }
     callingPendingFunctors_ = false;
 }
+
+void EventLoop::updateLag(int64_t sample)
+{
+    int64_t lag = lagMicros_.load(std::memory_order_relaxed);
+    lagMicros_.store(sample > lag ? sample : lag - lag / 8, std::memory_order_relaxed);
+}
+
+void EventLoop::doAfterEventsFunctors()
+{
+    std::vector<Functor> functors;
+    functors.swap(afterEventsFunctors_);
+    for (const Functor& functor : functors)
+    {
+        functor();
+    }
+}
+
+void EventLoop::doReadyFunctors(const std::vector<Functor>& functors)
+{
+    // 执行中重新登记的 cb 在 readyFunctors_ 中，留到下一轮
+    for (const Functor& functor : functors)
+    {
+        functor();
+    }
+}
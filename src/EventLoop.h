@@ -3,6 +3,7 @@
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Timer.h"
 
 #include <functional>
 #include <vector>
@@ -12,6 +13,7 @@
 
 class Channel;
 class Poller;
+class TimerQueue;
 
 /**********************************
  * 事件循环类
@@ -29,12 +31,37 @@ public:
     void quit();
 
     Timestamp pollReturnTime() const {  return pollReturnTime_;}
+    // 每次 poll 返回时缓存的时间，同一轮事件处理中代替 Timestamp::now() 使用
+    Timestamp now() const { return pollReturnTime_; }
+    int64_t nowMonotonic() const {  return pollReturnMonotonic_;    }
     void runInLoop(Functor cb);     // 在当前 loop 中执行
     void queueInLoop(Functor cb);   // 将 cb 放入队列中，唤醒loop所在线程，执行 cb
 
     // 用于唤醒 loop 所在线程
     void wakeup();
 
+    // 只能在 loop 线程调用：cb 在本轮事件和 pendingFunctors 处理完之后执行，
+    // 用于把本轮多次 send 合并为一次写
+    void queueAfterEvents(Functor cb);
+
+    // 只能在 loop 线程调用：cb 在下一轮处理完活跃 channel 之后执行，本轮有待执行的
+    // cb 时 poll 不阻塞。用于用完读取预算、内核中仍有数据的连接（边沿触发不会再通知）
+    void queueReady(Functor cb);
+    // 事件循环的轮次，每次 poll 返回加一
+    uint64_t iteration() const {    return iteration_;  }
+
+    /**
+     * 事件循环延迟（微秒），任意线程可读：取每轮 pendingFunctors 的排队时间
+     * （第一个回调入队到开始执行）和本轮处理事件的总时间中较大的一个，
+     * 突增时立即跟上，之后每轮衰减 1/8。空闲的 loop 不会更新，需要定期投递回调唤醒。
+     */
+    int64_t lagMicros() const { return lagMicros_.load(std::memory_order_relaxed);  }
+
+    // 定时器：任意线程可调用，回调在 loop 线程中执行，时间单位为秒
+    TimerId runAfter(double delay, TimerCallback cb);
+    TimerId runEvery(double interval, TimerCallback cb);
+    void cancel(TimerId timerId);
+
     // Eventloop  => Poller方法
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
@@ -46,6 +73,9 @@ public:
 private:
     void handleRead();      // wakeup
     void doPendingFunctors();
+    void updateLag(int64_t sample);
+    void doAfterEventsFunctors();
+    void doReadyFunctors(const std::vector<Functor>& functors);
     
     using ChannelList = std::vector<Channel*>;
 
@@ -56,6 +86,8 @@ private:
     
     // poller
     Timestamp pollReturnTime_;      // Poller 返回发生事件channels 的事件
+    int64_t pollReturnMonotonic_;   // 同一时刻的单调时钟（微秒）
+    uint64_t iteration_;
     std::unique_ptr<Poller> poller_;// Poller--> EpollPoller
     
     // 当 MainRactor 获取新客户端的 channel，通过轮询算法唤醒一个subreactor
@@ -63,11 +95,19 @@ private:
     int wakeupFd_;    
     std::unique_ptr<Channel> wakeupChannel_;
 
+    std::unique_ptr<TimerQueue> timerQueue_;    // timerfd 实现的定时器
+
     // channel
     ChannelList activeChannels_;      // Eventloop 管理的所有 channel
 
     // 回调
     std::atomic_bool callingPendingFunctors_;   // 标识当前 loop 是否有需要执行的回调操作
     std::vector<Functor> pendingFunctors_;      // 存储 loop 需要执行的回调操作
+    int64_t pendingSince_;                      // pendingFunctors_ 中第一个回调的入队时间
     std::mutex mutex_;                          // 用来保护 vector 容器的线程安全
+    int64_t queueDelay_;                        // 本轮 pendingFunctors 的排队时间，loop 线程访问
+    std::atomic<int64_t> lagMicros_;
+
+    std::vector<Functor> afterEventsFunctors_;  // 本轮结束时执行，只在 loop 线程访问
+    std::vector<Functor> readyFunctors_;        // 下一轮执行，只在 loop 线程访问
 };
\ No newline at end of file
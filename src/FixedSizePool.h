@@ -0,0 +1,80 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+
+/**************************************************************************************
+ * 定长内存块池
+ *     缓存释放的内存块，下次分配直接复用，避免频繁 malloc/free。块大小在第一次分配时
+ * 确定，之后大小不同的请求直接走 operator new。
+ *     分配通常在 baseloop 中，释放在连接所在的 subloop 中，所以用一把互斥锁保护空闲链表。
+**************************************************************************************/
+class FixedSizePool : noncopyable
+{
+public:
+    explicit FixedSizePool(size_t maxFree = 4096);
+    ~FixedSizePool();
+
+    void* allocate(size_t size);
+    void deallocate(void* p, size_t size);
+
+    size_t numFree() const;
+
+private:
+    struct FreeNode
+    {
+        FreeNode* next;
+    };
+
+    mutable std::mutex mutex_;
+    size_t blockSize_;      // 0 表示还未确定
+    FreeNode* freeList_;
+    size_t numFree_;
+    const size_t maxFree_;  // 最多缓存的空闲块数
+};
+
+/**************************************************************************************
+ * 配合 std::allocate_shared 使用的分配器：对象与 shared_ptr 控制块一次分配，
+ * 内存来自 FixedSizePool。分配器持有 pool 的 shared_ptr，对象可以比 pool 的创建者活得更久。
+**************************************************************************************/
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(const std::shared_ptr<FixedSizePool>& pool) : pool_(pool)   {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool_(other.pool())  {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        pool_->deallocate(p, n * sizeof(T));
+    }
+
+    const std::shared_ptr<FixedSizePool>& pool() const {    return pool_;   }
+
+private:
+    std::shared_ptr<FixedSizePool> pool_;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{
+    return lhs.pool() == rhs.pool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{
+    return !(lhs == rhs);
+}
@@ -0,0 +1,387 @@
+#include "HttpContext.h"
+#include "Buffer.h"
+
+#include <string.h>
+
+static const size_t kMaxHeaders = 100;
+static const size_t kMaxChunkLine = 1024;
+
+// 在 [begin, end) 中查找 "\r\n"，返回 '\r' 的位置，没有时返回 nullptr
+static const char* findCRLF(const char* begin, const char* end)
+{
+    const char* p = begin;
+    while (p < end)
+    {
+        const char* cr = static_cast<const char*>(memchr(p, '\r', end - p));
+        if (cr == nullptr || cr + 1 >= end)
+        {
+            return nullptr;
+        }
+        if (cr[1] == '\n')
+        {
+            return cr;
+        }
+        p = cr + 1;
+    }
+    return nullptr;
+}
+
+static HttpRequest::Method parseMethod(const StringPiece& method)
+{
+    switch (method.size())
+    {
+    case 3:
+        if (method == "GET") return HttpRequest::kGet;
+        if (method == "PUT") return HttpRequest::kPut;
+        break;
+    case 4:
+        if (method == "POST") return HttpRequest::kPost;
+        if (method == "HEAD") return HttpRequest::kHead;
+        break;
+    case 5:
+        if (method == "PATCH") return HttpRequest::kPatch;
+        break;
+    case 6:
+        if (method == "DELETE") return HttpRequest::kDelete;
+        break;
+    case 7:
+        if (method == "OPTIONS") return HttpRequest::kOptions;
+        break;
+    }
+    return HttpRequest::kInvalid;
+}
+
+HttpContext::HttpContext(size_t maxHeaderSize, size_t maxBodySize)
+    : maxHeaderSize_(maxHeaderSize),
+      maxBodySize_(maxBodySize),
+      state_(kExpectHeaders),
+      scanned_(0),
+      pos_(0),
+      chunkRemaining_(0),
+      errorStatus_(0),
+      expectContinue_(false),
+      continueSent_(false)
+{
+}
+
+HttpContext::Result HttpContext::fail(int status)
+{
+    errorStatus_ = status;
+    return kError;
+}
+
+HttpContext::Result HttpContext::parse(const Buffer* buf, Timestamp receiveTime)
+{
+    const char* base = buf->peek();
+    size_t readable = buf->readableBytes();
+
+    if (state_ == kExpectHeaders)
+    {
+        // 从上次扫描结束的位置继续找空行，回退 3 字节防止 "\r\n\r\n" 跨两次读取
+        size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+        const void* found = memmem(base + from, readable - from, "\r\n\r\n", 4);
+        if (found == nullptr)
+        {
+            scanned_ = readable;
+            return readable > maxHeaderSize_ ? fail(431) : kIncomplete;
+        }
+        size_t headerEnd = static_cast<const char*>(found) - base + 4;
+        if (headerEnd > maxHeaderSize_)
+        {
+            return fail(431);
+        }
+        if (!parseHeaders(base, headerEnd))
+        {
+            return kError;
+        }
+
+        pos_ = headerEnd;
+        if (request_.chunked_)
+        {
+            state_ = kExpectChunkSize;
+        }
+        else if (request_.contentLength_ > 0)
+        {
+            state_ = kExpectBody;
+        }
+        else
+        {
+            state_ = kGotAll;
+        }
+    }
+
+    if (state_ == kExpectBody)
+    {
+        if (readable - pos_ < request_.contentLength_)
+        {
+            return kIncomplete;
+        }
+        request_.body_ = HttpRequest::Range{pos_, request_.contentLength_};
+        pos_ += request_.contentLength_;
+        state_ = kGotAll;
+    }
+
+    if (state_ != kGotAll)
+    {
+        Result result = parseChunks(base, readable);
+        if (result != kComplete)
+        {
+            return result;
+        }
+    }
+
+    request_.base_ = base;
+    request_.receiveTime_ = receiveTime;
+    return kComplete;
+}
+
+void HttpContext::next(Buffer* buf)
+{
+    buf->retrieve(pos_);
+    state_ = kExpectHeaders;
+    scanned_ = 0;
+    pos_ = 0;
+    chunkRemaining_ = 0;
+    expectContinue_ = false;
+    continueSent_ = false;
+    request_.reset();
+}
+
+bool HttpContext::parseHeaders(const char* base, size_t headerEnd)
+{
+    const char* end = base + headerEnd;
+
+    // 请求行：METHOD SP target SP HTTP/1.x CRLF
+    const char* lineEnd = findCRLF(base, end);
+    const char* space = static_cast<const char*>(memchr(base, ' ', lineEnd - base));
+    if (space == nullptr)
+    {
+        fail(400);
+        return false;
+    }
+    request_.methodRange_ = HttpRequest::Range{0, static_cast<size_t>(space - base)};
+    request_.method_ = parseMethod(StringPiece(base, space - base));
+    if (request_.method_ == HttpRequest::kInvalid)
+    {
+        fail(501);
+        return false;
+    }
+
+    const char* target = space + 1;
+    space = static_cast<const char*>(memchr(target, ' ', lineEnd - target));
+    if (space == nullptr || space == target)
+    {
+        fail(400);
+        return false;
+    }
+    const char* question = static_cast<const char*>(memchr(target, '?', space - target));
+    const char* pathEnd = question ? question : space;
+    request_.path_ = HttpRequest::Range{static_cast<size_t>(target - base), static_cast<size_t>(pathEnd - target)};
+    if (question)
+    {
+        request_.query_ = HttpRequest::Range{static_cast<size_t>(question + 1 - base), static_cast<size_t>(space - question - 1)};
+    }
+
+    StringPiece version(space + 1, lineEnd - space - 1);
+    if (version == "HTTP/1.1")
+    {
+        request_.version_ = HttpRequest::kHttp11;
+        request_.keepAlive_ = true;
+    }
+    else if (version == "HTTP/1.0")
+    {
+        request_.version_ = HttpRequest::kHttp10;
+        request_.keepAlive_ = false;
+    }
+    else
+    {
+        fail(version.size() > 5 && memcmp(version.data(), "HTTP/", 5) == 0 ? 505 : 400);
+        return false;
+    }
+
+    // 头部：Name: OWS value OWS CRLF，直到空行
+    const char* line = lineEnd + 2;
+    while (line < end - 2)
+    {
+        lineEnd = findCRLF(line, end);
+        if (!parseHeader(base, line, lineEnd))
+        {
+            return false;
+        }
+        line = lineEnd + 2;
+    }
+
+    if (request_.chunked_ && request_.hasContentLength_)
+    {
+        // 同时带有两种长度容易被用来走私请求，直接拒绝
+        fail(400);
+        return false;
+    }
+    return true;
+}
+
+bool HttpContext::parseHeader(const char* base, const char* begin, const char* end)
+{
+    const char* colon = static_cast<const char*>(memchr(begin, ':', end - begin));
+    if (colon == nullptr || colon == begin || colon[-1] == ' ' || colon[-1] == '\t')
+    {
+        fail(400);
+        return false;
+    }
+    if (request_.headers_.size() >= kMaxHeaders)
+    {
+        fail(431);
+        return false;
+    }
+
+    const char* value = colon + 1;
+    while (value < end && (*value == ' ' || *value == '\t'))
+    {
+        ++value;
+    }
+    const char* valueEnd = end;
+    while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t'))
+    {
+        --valueEnd;
+    }
+
+    HttpRequest::Header header;
+    header.name = HttpRequest::Range{static_cast<size_t>(begin - base), static_cast<size_t>(colon - begin)};
+    header.value = HttpRequest::Range{static_cast<size_t>(value - base), static_cast<size_t>(valueEnd - value)};
+    request_.headers_.push_back(header);
+
+    // 影响解析和连接管理的几个头部在这里识别
+    StringPiece name(begin, colon - begin);
+    StringPiece val(value, valueEnd - value);
+    if (name.equalsIgnoreCase("Content-Length"))
+    {
+        if (val.empty())
+        {
+            fail(400);
+            return false;
+        }
+        size_t length = 0;
+        for (char c : val)
+        {
+            if (c < '0' || c > '9')
+            {
+                fail(400);
+                return false;
+            }
+            length = length * 10 + (c - '0');
+            if (length > maxBodySize_)
+            {
+                fail(413);
+                return false;
+            }
+        }
+        // 多个 Content-Length 的值不同时无法确定请求边界（包括 0 和非 0）
+        if (request_.hasContentLength_ && request_.contentLength_ != length)
+        {
+            fail(400);
+            return false;
+        }
+        request_.hasContentLength_ = true;
+        request_.contentLength_ = length;
+    }
+    else if (name.equalsIgnoreCase("Transfer-Encoding"))
+    {
+        if (!val.equalsIgnoreCase("chunked"))
+        {
+            fail(501);
+            return false;
+        }
+        request_.chunked_ = true;
+    }
+    else if (name.equalsIgnoreCase("Connection"))
+    {
+        if (val.equalsIgnoreCase("close"))
+        {
+            request_.keepAlive_ = false;
+        }
+        else if (val.equalsIgnoreCase("keep-alive"))
+        {
+            request_.keepAlive_ = true;
+        }
+    }
+    else if (name.equalsIgnoreCase("Expect"))
+    {
+        expectContinue_ = val.equalsIgnoreCase("100-continue");
+    }
+    return true;
+}
+
+// 分块正文：size [;ext] CRLF data CRLF ... 0 CRLF [trailer CRLF]* CRLF
+HttpContext::Result HttpContext::parseChunks(const char* base, size_t readable)
+{
+    const char* end = base + readable;
+    while (state_ != kGotAll)
+    {
+        if (state_ == kExpectChunkData)
+        {
+            if (readable - pos_ < chunkRemaining_ + 2)
+            {
+                return kIncomplete;
+            }
+            const char* data = base + pos_;
+            if (data[chunkRemaining_] != '\r' || data[chunkRemaining_ + 1] != '\n')
+            {
+                return fail(400);
+            }
+            request_.chunkedBody_.append(data, chunkRemaining_);
+            pos_ += chunkRemaining_ + 2;
+            state_ = kExpectChunkSize;
+            continue;
+        }
+
+        const char* line = base + pos_;
+        const char* lineEnd = findCRLF(line, end);
+        if (lineEnd == nullptr)
+        {
+            return static_cast<size_t>(end - line) > kMaxChunkLine ? fail(400) : kIncomplete;
+        }
+
+        if (state_ == kExpectChunkSize)
+        {
+            size_t size = 0;
+            const char* p = line;
+            for (; p < lineEnd; ++p)
+            {
+                char c = *p;
+                int digit;
+                if (c >= '0' && c <= '9')       digit = c - '0';
+                else if (c >= 'a' && c <= 'f')  digit = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')  digit = c - 'A' + 10;
+                else break;
+                size = size * 16 + digit;
+                if (request_.chunkedBody_.size() + size > maxBodySize_)
+                {
+                    return fail(413);
+                }
+            }
+            // 至少一位十六进制数字，后面只能是扩展（;name=value）
+            if (p == line || (p < lineEnd && *p != ';' && *p != ' ' && *p != '\t'))
+            {
+                return fail(400);
+            }
+            pos_ = lineEnd + 2 - base;
+            chunkRemaining_ = size;
+            state_ = size == 0 ? kExpectTrailers : kExpectChunkData;
+            scanned_ = 0;       // 之后用来统计 trailer 的长度
+        }
+        else    // kExpectTrailers：忽略 trailer，空行结束
+        {
+            scanned_ += lineEnd + 2 - line;
+            if (scanned_ > maxHeaderSize_)
+            {
+                return fail(431);
+            }
+            pos_ = lineEnd + 2 - base;
+            if (lineEnd == line)
+            {
+                state_ = kGotAll;
+            }
+        }
+    }
+    return kComplete;
+}
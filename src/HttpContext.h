@@ -0,0 +1,77 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "Timestamp.h"
+
+class Buffer;
+
+/**************************************************************************************
+ * HTTP/1.1 请求解析器，每个连接一个，增量解析：
+ *     parse 不修改 Buffer，数据不完整时返回 kIncomplete，记住已经扫描过的位置，下次收到
+ * 数据后继续；解析出完整请求（含正文）返回 kComplete，请求处理完后调用 next 从 Buffer 中
+ * 移除这个请求。流水线请求在同一个 Buffer 中依次解析，响应按请求顺序生成。
+ *     请求行和头部在整个头部到齐后一次解析，只记录位置；Content-Length 正文直接指向
+ * Buffer；分块正文逐块解码到 HttpRequest 自己的缓冲区。
+**************************************************************************************/
+class HttpContext : noncopyable
+{
+public:
+    enum Result
+    {
+        kIncomplete,
+        kComplete,
+        kError,         // errorStatus() 为应答的状态码，之后应关闭连接
+    };
+
+    static const size_t kDefaultMaxHeaderSize = 64 * 1024;
+    static const size_t kDefaultMaxBodySize = 4 * 1024 * 1024;
+
+    explicit HttpContext(size_t maxHeaderSize = kDefaultMaxHeaderSize,
+                         size_t maxBodySize = kDefaultMaxBodySize);
+
+    Result parse(const Buffer* buf, Timestamp receiveTime);
+    // 当前请求处理完成：从 buf 中移除，开始解析下一个请求
+    void next(Buffer* buf);
+
+    const HttpRequest& request() const {    return request_;    }
+    int errorStatus() const {   return errorStatus_;    }
+
+    // 头部已到齐、带有 "Expect: 100-continue" 并且正文还没收完：应先回复 100 Continue（只回复一次）
+    bool expectContinue() const {   return expectContinue_ && !continueSent_;  }
+    void setContinueSent() {    continueSent_ = true;   }
+
+    // 连接上复用的响应对象
+    HttpResponse* response() {  return &response_;  }
+
+private:
+    enum State
+    {
+        kExpectHeaders,
+        kExpectBody,
+        kExpectChunkSize,
+        kExpectChunkData,
+        kExpectTrailers,
+        kGotAll,
+    };
+
+    // 解析 [base, base + headerEnd) 中的请求行和头部
+    bool parseHeaders(const char* base, size_t headerEnd);
+    bool parseHeader(const char* base, const char* begin, const char* end);
+    Result parseChunks(const char* base, size_t readable);
+    Result fail(int status);
+
+    const size_t maxHeaderSize_;
+    const size_t maxBodySize_;
+
+    State state_;
+    size_t scanned_;            // 查找头部结束标记时已经扫描过的字节数
+    size_t pos_;                // 当前请求已解析的字节数
+    size_t chunkRemaining_;
+    int errorStatus_;
+    bool expectContinue_;
+    bool continueSent_;
+    HttpRequest request_;
+    HttpResponse response_;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <vector>
+#include <string>
+
+/**************************************************************************************
+ * HTTP 请求：由 HttpContext 直接在连接的输入 Buffer 上解析，请求行、头部、正文都只记录
+ * 在 Buffer 中的位置，不为每个头部分配 std::string。返回的 StringPiece 只在 HttpCallback
+ * 执行期间有效，需要保存时用 toString() 拷贝。分块（chunked）的请求正文解码到请求自己的
+ * 缓冲区中。
+**************************************************************************************/
+class HttpRequest
+{
+public:
+    enum Method
+    {
+        kInvalid,
+        kGet,
+        kPost,
+        kHead,
+        kPut,
+        kDelete,
+        kOptions,
+        kPatch,
+    };
+    enum Version
+    {
+        kUnknown,
+        kHttp10,
+        kHttp11,
+    };
+
+    HttpRequest() : base_(nullptr) {  reset();  }
+
+    Method method() const { return method_; }
+    Version version() const {   return version_;    }
+    StringPiece methodString() const {  return piece(methodRange_);   }
+    StringPiece path() const {  return piece(path_);    }
+    StringPiece query() const { return piece(query_);   }
+    StringPiece body() const {  return chunked_ ? StringPiece(chunkedBody_) : piece(body_); }
+    Timestamp receiveTime() const { return receiveTime_;    }
+
+    bool keepAlive() const {    return keepAlive_;  }
+    bool chunked() const {  return chunked_;    }
+
+    // 头部名不区分大小写，没有时返回空
+    StringPiece getHeader(const StringPiece& name) const
+    {
+        for (const Header& header : headers_)
+        {
+            if (piece(header.name).equalsIgnoreCase(name))
+            {
+                return piece(header.value);
+            }
+        }
+        return StringPiece();
+    }
+    size_t headerCount() const {    return headers_.size(); }
+    StringPiece headerName(size_t i) const {    return piece(headers_[i].name); }
+    StringPiece headerValue(size_t i) const {   return piece(headers_[i].value);    }
+
+private:
+    friend class HttpContext;
+
+    // 相对于 Buffer 可读数据起始位置的偏移：Buffer 扩容搬移数据后仍然有效
+    struct Range
+    {
+        size_t offset;
+        size_t len;
+    };
+    struct Header
+    {
+        Range name;
+        Range value;
+    };
+
+    StringPiece piece(const Range& range) const
+    {
+        return range.len == 0 ? StringPiece() : StringPiece(base_ + range.offset, range.len);
+    }
+
+    // 保留 headers_ / chunkedBody_ 的容量，下一个请求复用
+    void reset()
+    {
+        method_ = kInvalid;
+        version_ = kUnknown;
+        methodRange_ = path_ = query_ = body_ = Range{0, 0};
+        headers_.clear();
+        chunkedBody_.clear();
+        keepAlive_ = false;
+        chunked_ = false;
+        hasContentLength_ = false;
+        contentLength_ = 0;
+    }
+
+    const char* base_;          // 解析完成时的 Buffer::peek()
+    Method method_;
+    Version version_;
+    Range methodRange_;
+    Range path_;
+    Range query_;
+    Range body_;
+    std::vector<Header> headers_;
+    std::string chunkedBody_;
+    bool keepAlive_;
+    bool chunked_;
+    bool hasContentLength_;     // 带有 Content-Length 头部（值可以为 0）
+    size_t contentLength_;
+    Timestamp receiveTime_;
+};
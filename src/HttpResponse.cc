@@ -0,0 +1,149 @@
+#include "HttpResponse.h"
+
+#include <stdio.h>
+
+HttpResponse::HttpResponse(bool close)
+    : statusCode_(200),
+      closeConnection_(close),
+      chunked_(false),
+      headOnly_(false),
+      headers_(0),
+      body_(0)
+{
+}
+
+void HttpResponse::addHeader(const StringPiece& name, const StringPiece& value)
+{
+    headers_.append(name.data(), name.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+}
+
+void HttpResponse::setBody(const StringPiece& body)
+{
+    body_.retrieveAll();
+    body_.append(body.data(), body.size());
+}
+
+void HttpResponse::appendBody(const char* data, size_t len)
+{
+    body_.append(data, len);
+}
+
+void HttpResponse::appendToBuffer(Buffer* output) const
+{
+    char line[64];
+    int n = snprintf(line, sizeof(line), "HTTP/1.1 %d ", statusCode_);
+    output->append(line, n);
+    if (statusMessage_.empty())
+    {
+        const char* message = statusMessage(statusCode_);
+        output->append(message, strlen(message));
+    }
+    else
+    {
+        output->append(statusMessage_.data(), statusMessage_.size());
+    }
+    output->append("\r\n", 2);
+
+    // 1xx / 204 / 304 没有正文，不带长度
+    bool hasBody = statusCode_ >= 200 && statusCode_ != 204 && statusCode_ != 304;
+    if (hasBody)
+    {
+        if (bodyPayload_)
+        {
+            n = snprintf(line, sizeof(line), "Content-Length: %zu\r\n", bodyPayload_->size());
+            output->append(line, n);
+        }
+        else if (chunked_)
+        {
+            static const char kChunked[] = "Transfer-Encoding: chunked\r\n";
+            output->append(kChunked, sizeof(kChunked) - 1);
+        }
+        else
+        {
+            n = snprintf(line, sizeof(line), "Content-Length: %zu\r\n", body_.readableBytes());
+            output->append(line, n);
+        }
+    }
+    if (closeConnection_)
+    {
+        static const char kClose[] = "Connection: close\r\n";
+        output->append(kClose, sizeof(kClose) - 1);
+    }
+    output->append(headers_.peek(), headers_.readableBytes());
+    output->append("\r\n", 2);
+
+    if (hasBody && !headOnly_ && !bodyPayload_)
+    {
+        output->append(body_.peek(), body_.readableBytes());
+        if (chunked_)
+        {
+            appendLastChunk(output);
+        }
+    }
+}
+
+void HttpResponse::reset(bool close)
+{
+    statusCode_ = 200;
+    statusMessage_.clear();
+    closeConnection_ = close;
+    chunked_ = false;
+    headOnly_ = false;
+    headers_.retrieveAll();
+    body_.retrieveAll();
+    bodyPayload_.reset();
+    if (body_.capacity() > kMaxRetainedBody)
+    {
+        body_.shrink(0);
+    }
+}
+
+void HttpResponse::appendChunk(Buffer* output, const char* data, size_t len)
+{
+    // 长度为 0 的块表示结束，这里跳过
+    if (len == 0)
+    {
+        return;
+    }
+    char line[32];
+    int n = snprintf(line, sizeof(line), "%zx\r\n", len);
+    output->append(line, n);
+    output->append(data, len);
+    output->append("\r\n", 2);
+}
+
+void HttpResponse::appendLastChunk(Buffer* output)
+{
+    output->append("0\r\n\r\n", 5);
+}
+
+const char* HttpResponse::statusMessage(int code)
+{
+    switch (code)
+    {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 413: return "Payload Too Large";
+    case 416: return "Range Not Satisfiable";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "Unknown";
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Buffer.h"
+#include "StringPiece.h"
+#include "Payload.h"
+
+#include <string>
+
+/**************************************************************************************
+ * HTTP 响应：头部和正文直接追加到内部的 Buffer 中，appendToBuffer 把完整的响应写入
+ * 连接的输出 Buffer（流水线请求的多个响应依次写入，一次发送）。
+ *     同一个连接的所有请求复用一个 HttpResponse，Buffer 的容量保留下来，处理请求时不再分配内存。
+ *     setChunked 后正文按分块编码：appendChunk 每次写入一块，appendToBuffer 补上结束块，
+ * 适合写正文时还不知道总长度的场景。
+ *     正文也可以是共享的 Payload（如缓存的 mmap 文件）：appendToBuffer 只写头部，正文由
+ * HttpServer 通过 TcpConnection::send(Buffer*, PayloadPtr) 紧跟在头部之后发送，不拷贝。
+**************************************************************************************/
+class HttpResponse : noncopyable
+{
+public:
+    explicit HttpResponse(bool close = false);
+
+    void setStatusCode(int code) {  statusCode_ = code; }
+    int statusCode() const {    return statusCode_; }
+    // 不设置时使用状态码对应的标准短语
+    void setStatusMessage(const StringPiece& message) { statusMessage_.assign(message.data(), message.size());  }
+
+    void setCloseConnection(bool on) {  closeConnection_ = on;  }
+    bool closeConnection() const {  return closeConnection_;    }
+
+    void setContentType(const StringPiece& contentType) {   addHeader("Content-Type", contentType); }
+    // Content-Length / Transfer-Encoding / Connection 由 appendToBuffer 生成，不要重复添加
+    void addHeader(const StringPiece& name, const StringPiece& value);
+    // 预先拼好的若干行头部（每行以 "\r\n" 结尾），原样追加
+    void appendRawHeaders(const StringPiece& lines) {   headers_.append(lines.data(), lines.size());   }
+
+    void setBody(const StringPiece& body);
+    void appendBody(const char* data, size_t len);
+    void appendBody(const StringPiece& data) {  appendBody(data.data(), data.size());  }
+    // 共享正文，优先于 setBody / appendBody 的内容
+    void setBody(const PayloadPtr& body) {  bodyPayload_ = body;    }
+    const PayloadPtr& bodyPayload() const { return bodyPayload_;    }
+
+    void setChunked(bool on) {  chunked_ = on;  }
+    bool chunked() const {  return chunked_;    }
+    void appendChunk(const StringPiece& data) { appendChunk(&body_, data.data(), data.size());  }
+
+    // HEAD 请求：保留 Content-Length，不输出正文
+    void setHeadOnly(bool on) { headOnly_ = on; }
+    bool headOnly() const { return headOnly_;   }
+
+    void appendToBuffer(Buffer* output) const;
+
+    // 清空内容，准备处理下一个请求，保留 Buffer 的容量（过大的正文缓冲区释放）
+    void reset(bool close);
+
+    // 分块编码的一块 / 结束块
+    static void appendChunk(Buffer* output, const char* data, size_t len);
+    static void appendLastChunk(Buffer* output);
+    static const char* statusMessage(int code);
+
+private:
+    static const size_t kMaxRetainedBody = 64 * 1024;
+
+    int statusCode_;
+    std::string statusMessage_;
+    bool closeConnection_;
+    bool chunked_;
+    bool headOnly_;
+    Buffer headers_;        // "Name: value\r\n" ...
+    Buffer body_;
+    PayloadPtr bodyPayload_;
+};
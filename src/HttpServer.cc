@@ -0,0 +1,130 @@
+#include "HttpServer.h"
+#include "HttpContext.h"
+#include "Logger.h"
+
+#include <memory>
+
+namespace
+{
+
+void defaultHttpCallback(const HttpRequest&, HttpResponse* resp)
+{
+    resp->setStatusCode(404);
+    resp->setCloseConnection(true);
+}
+
+// 连接的 HTTP 状态：解析器和流水线响应的输出缓冲区，只在连接所属 loop 中访问
+struct HttpConnectionState
+{
+    HttpConnectionState(size_t maxHeaderSize, size_t maxBodySize)
+        : context(maxHeaderSize, maxBodySize),
+          output(0)
+    {
+    }
+
+    HttpContext context;
+    Buffer output;
+};
+
+} // namespace
+
+HttpServer::HttpServer(EventLoop* loop,
+                       const InetAddress& listenAddr,
+                       const std::string& name,
+                       TcpServer::Option option)
+    : server_(loop, listenAddr, name, option),
+      httpCallback_(defaultHttpCallback),
+      maxHeaderSize_(HttpContext::kDefaultMaxHeaderSize),
+      maxBodySize_(HttpContext::kDefaultMaxBodySize)
+{
+    server_.setConnectionCallback(std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
+    server_.setMessageCalback(std::bind(&HttpServer::onMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+void HttpServer::start()
+{
+    LOG_INFO("HttpServer starts listening\n");
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        conn->setContext(std::make_shared<HttpConnectionState>(maxHeaderSize_, maxBodySize_));
+    }
+}
+
+/**
+ * 一次读事件中依次处理 buf 中所有完整的请求：
+ *   每个请求的响应追加到连接的 output 中，全部处理完（或需要关闭连接）后一次发送；
+ * 请求在 next() 之前一直留在 buf 中，HttpRequest 直接引用 buf 中的数据。
+ */
+void HttpServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+{
+    HttpConnectionState* state = static_cast<HttpConnectionState*>(conn->getContext().get());
+    if (state == nullptr || !conn->connected())
+    {
+        // 已经决定关闭的连接，之后收到的数据全部丢弃
+        buf->retrieveAll();
+        return;
+    }
+
+    HttpContext& context = state->context;
+    Buffer& output = state->output;
+    bool close = false;
+    while (!close)
+    {
+        HttpContext::Result result = context.parse(buf, receiveTime);
+        if (result == HttpContext::kIncomplete)
+        {
+            if (context.expectContinue())
+            {
+                static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                output.append(kContinue, sizeof(kContinue) - 1);
+                context.setContinueSent();
+            }
+            break;
+        }
+
+        const HttpRequest& request = context.request();
+        HttpResponse* response = context.response();
+        if (result == HttpContext::kError)
+        {
+            LOG_DEBUG("HttpServer::onMessage [%s] bad request, status %d\n",
+                conn->name().c_str(), context.errorStatus());
+            response->reset(true);
+            response->setStatusCode(context.errorStatus());
+            response->appendToBuffer(&output);
+            close = true;
+            break;
+        }
+
+        response->reset(!request.keepAlive());
+        response->setHeadOnly(request.method() == HttpRequest::kHead);
+        if (request.version() == HttpRequest::kHttp10 && request.keepAlive())
+        {
+            response->addHeader("Connection", "keep-alive");
+        }
+        httpCallback_(request, response);
+        response->appendToBuffer(&output);
+        if (response->bodyPayload() && !response->headOnly())
+        {
+            // 共享正文：连同之前积累的响应一起写出，正文不拷贝
+            conn->send(&output, response->bodyPayload());
+        }
+        close = response->closeConnection();
+        context.next(buf);
+    }
+
+    if (output.readableBytes() > 0)
+    {
+        conn->send(&output);
+    }
+    if (close)
+    {
+        buf->retrieveAll();
+        conn->shutdown();
+    }
+}
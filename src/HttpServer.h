@@ -0,0 +1,54 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TcpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+#include <functional>
+#include <string>
+
+/**************************************************************************************
+ * HTTP/1.1 服务器：在 TcpServer 之上解析请求、调用 HttpCallback、生成响应。
+ *     支持 keep-alive、流水线请求（一次读到的多个请求依次处理，响应按顺序写入同一个
+ * 输出 Buffer，只发送一次）、分块的请求和响应正文、Expect: 100-continue。
+ *     HttpCallback 在连接所属的 IO 线程中同步执行，request 中的数据只在回调期间有效。
+ *
+ *     HttpServer server(&loop, InetAddress(8000), "http");
+ *     server.setHttpCallback([](const HttpRequest& req, HttpResponse* resp) {
+ *         resp->setContentType("text/plain");
+ *         resp->setBody("Hello, World!");
+ *     });
+ *     server.setThreadNum(4);
+ *     server.start();
+**************************************************************************************/
+class HttpServer : noncopyable
+{
+public:
+    using HttpCallback = std::function<void (const HttpRequest&, HttpResponse*)>;
+
+    HttpServer(EventLoop* loop,
+               const InetAddress& listenAddr,
+               const std::string& name,
+               TcpServer::Option option = TcpServer::kNoReusePort);
+
+    // 底层 TcpServer，用于设置连接数上限、socket 选项、背压等，start 之前设置
+    TcpServer& tcpServer() {    return server_; }
+
+    void setHttpCallback(const HttpCallback& cb) {  httpCallback_ = cb; }
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads);   }
+    // 请求头部 / 正文的长度上限，超过时回复 431 / 413 并关闭连接
+    void setMaxHeaderSize(size_t bytes) {   maxHeaderSize_ = bytes; }
+    void setMaxBodySize(size_t bytes) { maxBodySize_ = bytes;   }
+
+    void start();
+
+private:
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    TcpServer server_;
+    HttpCallback httpCallback_;
+    size_t maxHeaderSize_;
+    size_t maxBodySize_;
+};
@@ -1,41 +1,123 @@
 #include "InetAddress.h"
 #include <strings.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdio.h>
 
 InetAddress::InetAddress(uint16_t port, std::string ip){
     bzero(&addr_, sizeof(addr_));
 
-    addr_.sin_family = AF_INET;
-    addr_.sin_port = htons(port);
-    addr_.sin_addr.s_addr = inet_addr(ip.c_str());
+    if (ip.find(':') != std::string::npos)
+    {
+        sockaddr_in6* addr6 = reinterpret_cast<sockaddr_in6*>(&addr_);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        ::inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr);
+        len_ = sizeof(sockaddr_in6);
+        return;
+    }
+
+    sockaddr_in* addr = reinterpret_cast<sockaddr_in*>(&addr_);
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    addr->sin_addr.s_addr = inet_addr(ip.c_str());
+    len_ = sizeof(sockaddr_in);
+}
+
+InetAddress::InetAddress(const sockaddr_in &addr){
+    setSockAddr(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+}
+
+InetAddress::InetAddress(const sockaddr_in6 &addr){
+    setSockAddr(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+}
+
+InetAddress::InetAddress(const sockaddr* addr, socklen_t len){
+    setSockAddr(addr, len);
+}
+
+InetAddress InetAddress::unixPath(const std::string& path){
+    sockaddr_un addr;
+    bzero(&addr, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    // 抽象命名空间：sun_path[0] 为 '\0'，名字不以 '\0' 结尾，长度按实际字节数
+    size_t n = path.size() < sizeof(addr.sun_path) ? path.size() : sizeof(addr.sun_path) - 1;
+    memcpy(addr.sun_path, path.data(), n);
+    socklen_t len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + n);
+    if (n > 0 && path[0] == '@')
+    {
+        addr.sun_path[0] = '\0';
+    }
+    else
+    {
+        len += 1;       // 文件系统路径带上结尾的 '\0'
+    }
+    return InetAddress(reinterpret_cast<const sockaddr*>(&addr), len);
+}
+
+void InetAddress::setSockAddr(const sockaddr* addr, socklen_t len){
+    bzero(&addr_, sizeof(addr_));
+    if (len > sizeof(addr_))
+    {
+        len = sizeof(addr_);
+    }
+    memcpy(&addr_, addr, len);
+    len_ = len;
 }
 
 std::string InetAddress::toIP() const{
-    char buf[64] = {0};
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof(buf));
+    char buf[128] = {0};
+    if (family() == AF_INET6)
+    {
+        ::inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(&addr_)->sin6_addr, buf, sizeof(buf));
+        return buf;
+    }
+    if (family() == AF_UNIX)
+    {
+        const sockaddr_un* addr = reinterpret_cast<const sockaddr_un*>(&addr_);
+        size_t offset = offsetof(sockaddr_un, sun_path);
+        if (len_ <= offset)
+        {
+            return std::string();
+        }
+        if (addr->sun_path[0] == '\0')
+        {
+            return "@" + std::string(addr->sun_path + 1, len_ - offset - 1);
+        }
+        return std::string(addr->sun_path, strnlen(addr->sun_path, len_ - offset));
+    }
+    ::inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(&addr_)->sin_addr, buf, sizeof(buf));
     return buf;
 }
 
 std::string InetAddress::toIpPort() const{
-    char buf[64] = {0};
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof(buf));
-
-    size_t end = strlen(buf);
-    uint16_t port = ntohs(addr_.sin_port);
-
-    sprintf(buf + end, ":%u", port);
+    if (family() == AF_UNIX)
+    {
+        return "unix:" + toIP();
+    }
+    char buf[160] = {0};
+    if (family() == AF_INET6)
+    {
+        snprintf(buf, sizeof(buf), "[%s]:%u", toIP().c_str(), toPort());
+        return buf;
+    }
+    snprintf(buf, sizeof(buf), "%s:%u", toIP().c_str(), toPort());
     return buf;
 }
 
 uint16_t InetAddress::toPort() const{
-    return ntohs(addr_.sin_port);
+    if (family() == AF_INET6)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(&addr_)->sin6_port);
+    }
+    if (family() == AF_INET)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in*>(&addr_)->sin_port);
+    }
+    return 0;
 }
 
-// #include <iostream>
-// int main(){
-//     InetAddress addr(8080);
-
-//     std::cout << addr.toIpPort() <<std::endl;
-
-//     return 0;
-// }
\ No newline at end of file
+bool InetAddress::operator==(const InetAddress& rhs) const{
+    return len_ == rhs.len_ && memcmp(&addr_, &rhs.addr_, len_) == 0;
+}
@@ -2,25 +2,42 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <string>
 
 /**********************************
-    该类用于封装地址类型
+    该类用于封装地址类型：IPv4、IPv6 和 Unix 域（流式）地址。
+    ip 中含有 ':' 时按 IPv6 解析；Unix 域地址用 InetAddress::unixPath 构造，
+    路径以 '@' 开头表示抽象命名空间（不在文件系统中创建文件）。
 **********************************/
 class InetAddress{
 public:
     explicit InetAddress(uint16_t port = 0, std::string ip = "127.0.0.1");
-    explicit InetAddress(const sockaddr_in &addr)
-        : addr_(addr)
-        {}
+    explicit InetAddress(const sockaddr_in &addr);
+    explicit InetAddress(const sockaddr_in6 &addr);
+    // 任意地址族，len 为 accept / getsockname 等返回的地址长度
+    InetAddress(const sockaddr* addr, socklen_t len);
 
+    static InetAddress unixPath(const std::string& path);
+
+    sa_family_t family() const {    return addr_.ss_family; }
+    bool isUnix() const {   return family() == AF_UNIX; }
+    bool isIpv6() const {   return family() == AF_INET6;    }
+
+    // Unix 域地址返回路径（抽象命名空间以 '@' 开头，未绑定的一端为空）
     std::string toIP() const;
     std::string toIpPort() const;
     uint16_t toPort() const;
 
-    const sockaddr_in* getSockAddr() const {return &addr_;}
-    void setSockAddr(const sockaddr_in& addr)   {addr_ = addr;  }
+    const sockaddr* getSockAddr() const {   return reinterpret_cast<const sockaddr*>(&addr_);    }
+    socklen_t length() const {  return len_;    }
+    void setSockAddr(const sockaddr* addr, socklen_t len);
+    void setSockAddr(const sockaddr_in& addr)   {   setSockAddr(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));  }
+
+    bool operator==(const InetAddress& rhs) const;
 
 private:
-    sockaddr_in addr_;
-};
\ No newline at end of file
+    sockaddr_storage addr_;
+    socklen_t len_;
+};
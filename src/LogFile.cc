@@ -0,0 +1,125 @@
+#include "LogFile.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+LogFile::LogFile(const std::string& basename,
+                 off_t rollSize,
+                 int rollInterval,
+                 int checkEveryN)
+    : basename_(basename),
+      rollSize_(rollSize),
+      rollInterval_(rollInterval > 0 ? rollInterval : 60 * 60 * 24),
+      checkEveryN_(checkEveryN > 0 ? checkEveryN : 1),
+      count_(0),
+      startOfPeriod_(0),
+      lastRoll_(0),
+      fp_(nullptr),
+      writtenBytes_(0)
+{
+    rollFile();
+}
+
+LogFile::~LogFile()
+{
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+}
+
+void LogFile::append(const char* logline, size_t len)
+{
+    if (fp_ == nullptr)
+    {
+        return;
+    }
+
+    size_t written = 0;
+    while (written != len)
+    {
+        size_t n = ::fwrite_unlocked(logline + written, 1, len - written, fp_);
+        if (n == 0)
+        {
+            int err = ::ferror(fp_);
+            if (err)
+            {
+                // 不能再写日志报告日志的错误，直接输出到 stderr
+                fprintf(stderr, "LogFile::append() failed %s\n", strerror(err));
+            }
+            break;
+        }
+        written += n;
+    }
+    writtenBytes_ += written;
+
+    if (writtenBytes_ > rollSize_)
+    {
+        rollFile();
+    }
+    else if (++count_ >= checkEveryN_)
+    {
+        count_ = 0;
+        time_t now = ::time(NULL);
+        time_t thisPeriod = now / rollInterval_ * rollInterval_;
+        if (thisPeriod != startOfPeriod_)
+        {
+            rollFile();
+        }
+    }
+}
+
+void LogFile::flush()
+{
+    if (fp_)
+    {
+        ::fflush(fp_);
+    }
+}
+
+bool LogFile::rollFile()
+{
+    time_t now = 0;
+    std::string filename = getLogFileName(basename_, &now);
+
+    // 同一秒内不重复滚动，否则文件名相同
+    if (now <= lastRoll_)
+    {
+        return false;
+    }
+
+    FILE* fp = ::fopen(filename.c_str(), "ae");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "LogFile::rollFile() open %s failed: %s\n", filename.c_str(), strerror(errno));
+        return false;
+    }
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+    fp_ = fp;
+    ::setbuffer(fp_, buffer_, sizeof(buffer_));
+
+    lastRoll_ = now;
+    startOfPeriod_ = now / rollInterval_ * rollInterval_;
+    writtenBytes_ = 0;
+    count_ = 0;
+    return true;
+}
+
+std::string LogFile::getLogFileName(const std::string& basename, time_t* now)
+{
+    std::string filename(basename);
+
+    char timebuf[32];
+    tm tm_time;
+    *now = ::time(NULL);
+    localtime_r(now, &tm_time);
+    strftime(timebuf, sizeof(timebuf), ".%Y%m%d-%H%M%S.", &tm_time);
+    filename += timebuf;
+    filename += std::to_string(::getpid());
+    filename += ".log";
+    return filename;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <time.h>
+#include <stdio.h>
+
+/**************************************************************************************
+ * 日志文件：只在后端线程中使用，不加锁。
+ *     文件名为 basename.YYYYmmdd-HHMMSS.pid.log，写入超过 rollSize 字节或跨过
+ * rollInterval 秒的边界时滚动到新文件；每写 checkEveryN 次检查一次时间。
+**************************************************************************************/
+class LogFile : noncopyable
+{
+public:
+    LogFile(const std::string& basename,
+            off_t rollSize,
+            int rollInterval = 60 * 60 * 24,
+            int checkEveryN = 1024);
+    ~LogFile();
+
+    void append(const char* logline, size_t len);
+    void flush();
+    bool rollFile();
+
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int rollInterval_;
+    const int checkEveryN_;
+
+    int count_;
+    time_t startOfPeriod_;          // 当前文件所在周期的起点
+    time_t lastRoll_;
+
+    FILE* fp_;
+    off_t writtenBytes_;
+    char buffer_[64 * 1024];        // stdio 缓冲区
+};
@@ -1,7 +1,32 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <string>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+namespace
+{
+
+const char* const kLevelName[] = { "[DEBUG]", "[INFO]", "[ERROR]", "[FATAL]" };
+
+// 每个线程缓存当前秒的日期部分，一秒内只调用一次 localtime_r
+__thread time_t t_lastSecond = -1;
+__thread char t_time[32];
+
+void defaultOutput(const char* msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+}
+
+void defaultFlush()
+{
+    ::fflush(stdout);
+}
+
+}
+
+std::atomic_int Logger::logLevel_(INFO);
 
 // 获取唯一日志实例对象
 Logger& Logger::instance(){
@@ -9,29 +34,93 @@ Logger& Logger::instance(){
     return logger;
 }
 
-// 设置日志级别
-void Logger::setLogLevel(int level){
-    logLevel_ = level;
+Logger::Logger()
+    : output_(defaultOutput),
+      flush_(defaultFlush)
+{
 }
 
-// 写日志, 日志格式： [级别信息] time : msg
-void Logger::log(std::string msg){
-    switch(logLevel_)
+// 写日志, 日志格式： [级别信息] time.微秒 : msg
+void Logger::log(int level, const char* fmt, ...){
+    char line[1280];
+    Timestamp now = Timestamp::now();
+    time_t seconds = now.secondsSinceEpoch();
+    if (seconds != t_lastSecond)
+    {
+        t_lastSecond = seconds;
+        tm tm_time;
+        localtime_r(&seconds, &tm_time);
+        strftime(t_time, sizeof(t_time), "%Y/%m/%d %H:%M:%S", &tm_time);
+    }
+
+    int len = snprintf(line, sizeof(line), "%s%s.%06d : ",
+                       level >= DEBUG && level <= FATAL ? kLevelName[level] : "",
+                       t_time,
+                       static_cast<int>(now.microSecondsSinceEpoch() % Timestamp::kMicroSecondsPerSecond));
+    if (len < 0)
     {
-    case INFO:
-        std::cout << "[INFO]";
-        break;
-    case ERROR:
-        std::cout << "[ERROR]";
-        break;
-    case FATAL:
-        std::cout << "[FATAL]";
-        break;
-    case DEBUG:
-        std::cout << "[DEBUG]";
-        break;
+        return;
     }
 
-    // 打印时间
-    std::cout << Timestamp::now().toString() << " : " << msg << std::endl;
-}
\ No newline at end of file
+    va_list args;
+    va_start(args, fmt);
+    int msgLen = vsnprintf(line + len, sizeof(line) - len, fmt, args);
+    va_end(args);
+    if (msgLen < 0)
+    {
+        return;
+    }
+
+    // 截断时保留一个字节给换行
+    size_t n = static_cast<size_t>(len) + msgLen;
+    if (n > sizeof(line) - 2)
+    {
+        n = sizeof(line) - 2;
+    }
+    if (n == 0 || line[n - 1] != '\n')      // 消息末尾没有换行则补上
+    {
+        line[n++] = '\n';
+    }
+
+    output_(line, n);
+    if (level == FATAL)
+    {
+        flush();
+    }
+}
+
+void Logger::flush(){
+    if (flush_)
+    {
+        flush_();
+    }
+}
+
+bool LogRateLimiter::allow(int* suppressed)
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    uint64_t now = static_cast<uint64_t>(ts.tv_sec);
+
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        // 时钟读得早的线程可能落后于别的线程已经进入的窗口，算在新窗口里
+        uint64_t window = state >> 32;
+        bool reset = window < now;
+        int64_t count = reset ? 0 : static_cast<int64_t>(state & 0xffffffff);
+        if (count >= perSecond_)
+        {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            *suppressed = 0;
+            return false;
+        }
+        uint64_t next = ((reset ? now : window) << 32) | static_cast<uint64_t>(count + 1);
+        if (state_.compare_exchange_weak(state, next, std::memory_order_relaxed))
+        {
+            // 进入新窗口：只有完成重置的线程报告上个窗口丢弃的条数
+            *suppressed = reset ? suppressed_.exchange(0, std::memory_order_relaxed) : 0;
+            return true;
+        }
+    }
+}
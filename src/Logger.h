@@ -1,67 +1,146 @@
 #pragma once
 
 #include <string>
+#include <functional>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "noncopyable.h"
+#include "BinaryLogging.h"
+
+enum LogLevel
+{
+    DEBUG,      // 调试信息
+    INFO,       // 普通信息
+    ERROR,      // 错误信息
+    FATAL       // core 信息
+};
+
+/**************************************************************************************
+ * 编译期级别：低于该级别的日志语句被编译器整个删除（参数也不求值）。
+ *     默认定义了 SZDEBUG 时为 DEBUG，否则为 INFO；可以用 -DSZMUDUO_LOG_COMPILE_LEVEL=2
+ * 只保留 ERROR 和 FATAL。
+**************************************************************************************/
+#ifndef SZMUDUO_LOG_COMPILE_LEVEL
+#ifdef SZDEBUG
+#define SZMUDUO_LOG_COMPILE_LEVEL 0
+#else
+#define SZMUDUO_LOG_COMPILE_LEVEL 1
+#endif
+#endif
+
+// 运行期级别在格式化之前检查，未开启的日志只有一次原子读
+#define LOG_ENABLED(level) \
+    ((level) >= SZMUDUO_LOG_COMPILE_LEVEL && (level) >= Logger::logLevel())
+
+// 输出一条日志：BinaryLogging 启动后写二进制记录，否则格式化为文本
+#define LOG_EMIT(level, logmsgFormat, ...) \
+    do{\
+        if (BinaryLogging::active())    \
+        {\
+            static std::atomic<uint32_t> logFormatId(0);    \
+            BinaryLogging::log(&logFormatId, level, __FILE__, __LINE__, logmsgFormat, ##__VA_ARGS__);   \
+        }\
+        else\
+            Logger::instance().log(level, logmsgFormat, ##__VA_ARGS__);  \
+    }while(0)
 
 // LOGINFO("%s %d", arg1, arg2)
 #define LOG_INFO(logmsgFormat, ...) \
     do{\
-        Logger &logger = Logger::instance();    \
-        logger.setLogLevel(INFO);               \
-        char buf[1024] = {0};                \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);   \
-        logger.log(buf);                        \
+        if (LOG_ENABLED(INFO))      \
+            LOG_EMIT(INFO, logmsgFormat, ##__VA_ARGS__);   \
     }while(0)
 
 #define LOG_ERROR(logmsgFormat, ...) \
     do{\
-        Logger &logger = Logger::instance();    \
-        logger.setLogLevel(ERROR);              \
-        char buf[1024] = {0};                \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);   \
-        logger.log(buf);                        \
+        if (LOG_ENABLED(ERROR))     \
+            LOG_EMIT(ERROR, logmsgFormat, ##__VA_ARGS__);  \
     }while(0)
 
+// FATAL 总是输出文本并立即 flush
 #define LOG_FATAL(logmsgFormat, ...) \
     do{\
-        Logger &logger = Logger::instance();    \
-        logger.setLogLevel(FATAL);              \
-        char buf[1024] = {0};                \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);   \
-        logger.log(buf);  \
+        Logger::instance().log(FATAL, logmsgFormat, ##__VA_ARGS__);      \
         exit(-1);                      \
     }while(0)
 
-#ifdef SZDEBUG
 #define LOG_DEBUG(logmsgFormat, ...) \
     do{\
-        Logger &logger = Logger::instance();    \
-        logger.setLogLevel(DEBUG);              \
-        char buf[1024] = {0};                \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__);   \
-        logger.log(buf);                        \
+        if (LOG_ENABLED(DEBUG))     \
+            LOG_EMIT(DEBUG, logmsgFormat, ##__VA_ARGS__);  \
     }while(0)
-#else
-    #define LOG_DEBUG(logmsgFormat, ...)
-#endif
 
-enum LogLevel
-{
-    INFO,       // 普通信息
-    ERROR,      // 错误信息
-    FATAL,      // core 信息
-    DEBUG       // 调试信息
-};
+/**************************************************************************************
+ * 限频日志：每个调用点每秒最多输出 perSecond 条，超出的条数在下一次输出前汇总报告。
+ *     用于可能在热路径上反复出现的消息，如 poll 超时、accept 失败。
+ *
+ *     LOG_RATELIMIT(INFO, 1, "%s timeout", __FUNCTION__);
+**************************************************************************************/
+#define LOG_RATELIMIT(level, perSecond, logmsgFormat, ...) \
+    do{\
+        if (LOG_ENABLED(level))     \
+        {\
+            static LogRateLimiter logRateLimiter(perSecond);  \
+            int suppressed = 0;     \
+            if (logRateLimiter.allow(&suppressed))  \
+            {\
+                if (suppressed > 0) \
+                    LOG_EMIT(level, "%d similar messages suppressed at %s:%d", suppressed, __FILE__, __LINE__); \
+                LOG_EMIT(level, logmsgFormat, ##__VA_ARGS__); \
+            }\
+        }\
+    }while(0)
 
+/**************************************************************************************
+ * 日志前端：格式化一行日志 "[级别]时间 : 消息"，交给输出函数。
+ *     默认输出到 stdout（不逐行 flush）；setOutput 可以改为 AsyncLogging 等后端，
+ * 需要在多线程开始写日志之前设置。
+**************************************************************************************/
 class Logger : noncopyable{
 public:
+    using OutputFunc = std::function<void(const char* msg, size_t len)>;
+    using FlushFunc = std::function<void()>;
+
     // 获取唯一日志实例对象
     static Logger& instance();      
-    // 设置日志级别
-    void setLogLevel(int level);
-    // 写日志
-    void log(std::string msg);
+
+    // 运行期最低级别，任意线程可以修改，默认 INFO
+    static int logLevel() { return logLevel_.load(std::memory_order_relaxed);  }
+    static void setLogLevel(int level) {    logLevel_.store(level, std::memory_order_relaxed);  }
+
+    // 写日志：直接格式化到栈上的一行缓冲区
+    void log(int level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    void setOutput(OutputFunc out) {    output_ = std::move(out);   }
+    void setFlush(FlushFunc flush) {    flush_ = std::move(flush);  }
+    void flush();
+
 private:
-    int logLevel_;
-};
\ No newline at end of file
+    Logger();
+
+    OutputFunc output_;
+    FlushFunc flush_;
+
+    static std::atomic_int logLevel_;
+};
+
+/**************************************************************************************
+ * 每个限频调用点一个实例（函数内 static），按秒划分窗口计数
+**************************************************************************************/
+class LogRateLimiter : noncopyable
+{
+public:
+    explicit LogRateLimiter(int perSecond) : perSecond_(perSecond), state_(0), suppressed_(0) {}
+
+    // 允许输出返回 true，*suppressed 为上个窗口被丢弃的条数
+    bool allow(int* suppressed);
+
+private:
+    const int perSecond_;
+    // 高 32 位为当前窗口（单调时钟的秒数），低 32 位为窗口内已允许的条数，
+    // 一起更新，进入新窗口时不会按旧窗口的计数丢弃
+    std::atomic<uint64_t> state_;
+    std::atomic_int suppressed_;
+};
@@ -0,0 +1,45 @@
+#include "MemoryGovernor.h"
+
+MemoryGovernor::MemoryGovernor(int64_t budget)
+    : budget_(budget)
+{
+}
+
+MemoryGovernor::Level MemoryGovernor::level() const
+{
+    if (budget_ <= 0)
+    {
+        return kNormal;
+    }
+
+    int64_t percent = usage() * 100 / budget_;
+    if (percent >= kRejectNewPercent)
+    {
+        return kRejectNew;
+    }
+    else if (percent >= kPauseReadPercent)
+    {
+        return kPauseRead;
+    }
+    else if (percent >= kShrinkPercent)
+    {
+        return kShrink;
+    }
+    return kNormal;
+}
+
+void MemoryGovernor::addPaused(const TcpConnectionPtr& conn)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    paused_.push_back(conn);
+}
+
+std::vector<TcpConnectionWeakPtr> MemoryGovernor::takePaused()
+{
+    std::vector<TcpConnectionWeakPtr> paused;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        paused.swap(paused_);
+    }
+    return paused;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Buffer.h"
+#include "Callbacks.h"
+
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+
+/**************************************************************************************
+ * 服务器级内存预算：一个 TcpServer 所有连接的 Buffer 容量累加到同一个计数器上，
+ * 根据用量占预算的比例分级处理：
+ *     kShrink      收缩空闲连接的缓冲区
+ *     kPauseRead   暂停占用内存最多的连接的读取
+ *     kRejectNew   拒绝新连接，连接读到数据后也立即暂停读取
+ *     被暂停读取的连接记录在 governor 中，用量降下来后由 TcpServer 统一恢复。
+**************************************************************************************/
+class MemoryGovernor : noncopyable
+{
+public:
+    enum Level
+    {
+        kNormal,
+        kShrink,
+        kPauseRead,
+        kRejectNew,
+    };
+
+    explicit MemoryGovernor(int64_t budget);
+
+    MemoryCounter* counter() {  return &counter_;  }
+
+    int64_t usage() const { return counter_.get();  }
+    int64_t budget() const {    return budget_; }
+    Level level() const;
+
+    // 记录因内存紧张暂停读取的连接，任意线程可调用
+    void addPaused(const TcpConnectionPtr& conn);
+    std::vector<TcpConnectionWeakPtr> takePaused();
+
+    // 各级别触发的比例（百分比）
+    static const int kShrinkPercent = 70;
+    static const int kPauseReadPercent = 85;
+    static const int kRejectNewPercent = 95;
+
+private:
+    const int64_t budget_;
+    MemoryCounter counter_;
+
+    std::mutex mutex_;
+    std::vector<TcpConnectionWeakPtr> paused_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <memory>
+#include <string>
+
+/**************************************************************************************
+ * 不可变的共享消息：创建后内容不再修改，可以同时排在多个连接（多个 loop）的发送队列中，
+ * 各连接只持有引用计数，不拷贝数据。最后一个连接发送完成后释放。
+ *     数据可以放在自己的 std::string 中，也可以是外部内存（如 mmap 的文件），
+ * 由 owner 管理，最后一个引用释放时才释放 owner。
+ *
+ *     PayloadPtr msg = Payload::create(text);
+ *     server.broadcast(msg);
+**************************************************************************************/
+class Payload : noncopyable
+{
+public:
+    explicit Payload(std::string data)
+        : storage_(std::move(data)),
+          data_(storage_.data()),
+          size_(storage_.size())
+    {
+    }
+    Payload(const char* data, size_t len, std::shared_ptr<const void> owner)
+        : data_(data),
+          size_(len),
+          owner_(std::move(owner))
+    {
+    }
+
+    static std::shared_ptr<const Payload> create(std::string data)
+    {
+        return std::make_shared<const Payload>(std::move(data));
+    }
+    static std::shared_ptr<const Payload> create(const void* data, size_t len)
+    {
+        return std::make_shared<const Payload>(std::string(static_cast<const char*>(data), len));
+    }
+    // 引用外部内存，不拷贝
+    static std::shared_ptr<const Payload> wrap(const void* data, size_t len, std::shared_ptr<const void> owner)
+    {
+        return std::make_shared<const Payload>(static_cast<const char*>(data), len, std::move(owner));
+    }
+
+    const char* data() const {  return data_;   }
+    size_t size() const {   return size_;   }
+
+private:
+    const std::string storage_;
+    const char* const data_;
+    const size_t size_;
+    const std::shared_ptr<const void> owner_;
+};
+
+using PayloadPtr = std::shared_ptr<const Payload>;
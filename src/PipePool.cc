@@ -0,0 +1,59 @@
+#include "PipePool.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const size_t PipePool::kMaxIdle;
+const int PipePool::kPipeSize;
+
+PipePool& PipePool::current()
+{
+    static thread_local PipePool pool;
+    return pool;
+}
+
+PipePool::~PipePool()
+{
+    for (const Pipe& pipe : idle_)
+    {
+        ::close(pipe.readFd);
+        ::close(pipe.writeFd);
+    }
+}
+
+bool PipePool::acquire(int fds[2])
+{
+    if (!idle_.empty())
+    {
+        fds[0] = idle_.back().readFd;
+        fds[1] = idle_.back().writeFd;
+        idle_.pop_back();
+        return true;
+    }
+
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+    {
+        LOG_ERROR("PipePool::acquire pipe2 errno %d\n", errno);
+        return false;
+    }
+    // 超过 /proc/sys/fs/pipe-max-size 或用户的管道内存配额时保持默认容量
+    ::fcntl(fds[1], F_SETPIPE_SZ, kPipeSize);
+    return true;
+}
+
+void PipePool::release(int fds[2], bool reusable)
+{
+    if (reusable && idle_.size() < kMaxIdle)
+    {
+        idle_.push_back(Pipe{ fds[0], fds[1] });
+    }
+    else
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+    fds[0] = -1;
+    fds[1] = -1;
+}
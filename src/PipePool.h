@@ -0,0 +1,39 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stddef.h>
+#include <vector>
+
+/**************************************************************************************
+ * 管道池：splice 转发（TcpConnection::relay）用管道在内核中中转数据，每个转发方向
+ * 一个管道。转发结束时空管道放回池中，下次直接复用，不必每次 pipe2 + 设置容量。
+ *     每个线程（即每个 loop）一个池，通过 current() 访问，不加锁；线程退出时关闭池中的管道。
+**************************************************************************************/
+class PipePool : noncopyable
+{
+public:
+    static const size_t kMaxIdle = 64;              // 最多缓存的空闲管道数
+    static const int kPipeSize = 256 * 1024;        // 管道容量，即每个转发方向在内核中最多积压的字节数
+
+    static PipePool& current();
+
+    ~PipePool();
+
+    // 成功时 fds[0] 为读端、fds[1] 为写端，均为非阻塞
+    bool acquire(int fds[2]);
+    // 管道中还有数据时不能复用，reusable 为 false 直接关闭
+    void release(int fds[2], bool reusable);
+
+    size_t numIdle() const {    return idle_.size();    }
+
+private:
+    PipePool() = default;
+
+    struct Pipe
+    {
+        int readFd;
+        int writeFd;
+    };
+    std::vector<Pipe> idle_;
+};
@@ -0,0 +1,150 @@
+#include "RpcClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+RpcClient::RpcClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name)
+    : loop_(loop),
+      client_(loop, serverAddr, name),
+      maxPayload_(RpcCodec::kDefaultMaxPayload),
+      connected_(false),
+      nextRequestId_(1)
+{
+    client_.setConnectionCallback(std::bind(&RpcClient::onConnection, this, std::placeholders::_1));
+    client_.setMessageCallback(std::bind(&RpcClient::onMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+void RpcClient::disconnect()
+{
+    client_.disconnect();       // 不再重连
+    loop_->runInLoop([this]() {
+        if (conn_)
+        {
+            conn_->forceClose();
+        }
+    });
+}
+
+void RpcClient::call(uint32_t methodId, const StringPiece& request, const Callback& done)
+{
+    if (loop_->isInLoopThread())
+    {
+        callInLoop(methodId, request, done);
+    }
+    else
+    {
+        std::string copy = request.toString();
+        loop_->runInLoop([this, methodId, copy, done]() {
+            callInLoop(methodId, copy, done);
+        });
+    }
+}
+
+void RpcClient::callInLoop(uint32_t methodId, const StringPiece& request, const Callback& done)
+{
+    if (!conn_ || !conn_->connected())
+    {
+        done(RpcCodec::kConnectionClosed, StringPiece());
+        return;
+    }
+
+    RpcHeader header;
+    header.requestId = nextRequestId_++;
+    header.methodId = methodId;
+    header.status = RpcCodec::kOk;
+    header.flags = 0;
+    pending_.emplace(header.requestId, done);
+
+    char head[RpcCodec::kHeaderLen];
+    RpcCodec::encodeHeader(head, header, request.size());
+    conn_->sendv({ Slice(head, sizeof(head)), Slice(request.data(), request.size()) });
+}
+
+void RpcClient::onConnection(const TcpConnectionPtr& conn)
+{
+    LOG_INFO("RpcClient [%s] connection %s is %s\n", client_.name().c_str(), conn->name().c_str(),
+        conn->connected() ? "UP" : "DOWN");
+    if (conn->connected())
+    {
+        conn->setTcpNoDelay(true);
+        conn->setWriteCoalescing(true);     // 同一轮事件中发出的请求合并成一次写
+        conn_ = conn;
+        connected_ = true;
+    }
+    else
+    {
+        connected_ = false;
+        if (conn_ == conn)
+        {
+            conn_.reset();
+        }
+        failAll();
+    }
+    if (stateCallback_)
+    {
+        stateCallback_(conn->connected());
+    }
+}
+
+/**
+ * 一次读事件中依次处理 buf 中所有完整的响应，回调直接引用 buf 中的正文，
+ * 全部处理完后一次从 buf 中移除。
+ */
+void RpcClient::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    const char* data = buf->peek();
+    size_t len = buf->readableBytes();
+    size_t consumed = 0;
+    while (conn->connected())
+    {
+        RpcHeader header;
+        StringPiece payload;
+        size_t frameLen = 0;
+        RpcCodec::Result result = RpcCodec::decode(data + consumed, len - consumed, maxPayload_,
+                                                   &header, &payload, &frameLen);
+        if (result == RpcCodec::kIncomplete)
+        {
+            break;
+        }
+        if (result == RpcCodec::kError || !(header.flags & RpcCodec::kResponse))
+        {
+            LOG_ERROR("RpcClient::onMessage [%s] bad frame, close connection\n", conn->name().c_str());
+            buf->retrieveAll();
+            conn->forceClose();
+            return;
+        }
+        consumed += frameLen;
+
+        auto it = pending_.find(header.requestId);
+        if (it == pending_.end())
+        {
+            LOG_ERROR("RpcClient::onMessage [%s] unknown request id %llu\n",
+                conn->name().c_str(), (unsigned long long)header.requestId);
+            continue;
+        }
+        // 先移出再回调：回调中可能继续发起调用
+        Callback done(std::move(it->second));
+        pending_.erase(it);
+        done(header.status, payload);
+    }
+
+    if (conn->connected())
+    {
+        buf->retrieve(consumed);
+    }
+    else
+    {
+        buf->retrieveAll();
+    }
+}
+
+void RpcClient::failAll()
+{
+    std::unordered_map<uint64_t, Callback> pending;
+    pending.swap(pending_);
+    for (auto& item : pending)
+    {
+        item.second(RpcCodec::kConnectionClosed, StringPiece());
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "TcpClient.h"
+#include "RpcCodec.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+class EventLoop;
+
+/**************************************************************************************
+ * RPC 客户端，一个对象对应一个到服务器的连接，帧格式与 RpcServer 相同（见 RpcCodec）。
+ *     call 分配 requestId、登记回调后立即发出请求，不等待之前的调用完成，同一个连接上
+ * 可以同时有任意多个未完成的调用；响应按 requestId 找到回调，到达顺序与请求顺序无关。
+ * 连接开启了合并写，同一轮事件中发出的多个请求一次写出。
+ *     回调在 loop 线程中执行，response 只在回调期间有效；连接断开时所有未完成的调用
+ * 以 kConnectionClosed 结束。
+ *     连接由 TcpClient 在 loop 中非阻塞地建立，连上之前发起的调用以 kConnectionClosed
+ * 结束，可以等 StateCallback 通知连接建立后再发起调用。RpcClient 应在 loop 线程中
+ * （或 loop 退出之后）析构，析构时未完成的调用不再回调。
+ *
+ *     RpcClient client(loop, InetAddress(9000), "rpc");
+ *     client.connect();
+ *     client.call(kEcho, "hello", [](uint16_t status, const StringPiece& response) {
+ *         ...
+ *     });
+**************************************************************************************/
+class RpcClient : noncopyable
+{
+public:
+    using Callback = std::function<void (uint16_t status, const StringPiece& response)>;
+    using StateCallback = std::function<void (bool connected)>;
+
+    RpcClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name);
+
+    // 任意线程可调用，立即返回，连接建立后回调 StateCallback
+    void connect() {    client_.connect();  }
+    // 关闭连接，未完成的调用以 kConnectionClosed 结束，任意线程可调用
+    void disconnect();
+    bool connected() const {    return connected_;  }
+    // 连接断开后按指数退避自动重连，connect 之前设置
+    void enableRetry() {    client_.enableRetry();  }
+
+    // 任意线程可调用：在 loop 线程中调用时直接发送，否则拷贝请求交给 loop 线程
+    void call(uint32_t methodId, const StringPiece& request, const Callback& done);
+
+    // 连接建立、断开时在 loop 线程中回调
+    void setStateCallback(const StateCallback& cb) {    stateCallback_ = cb;    }
+    // 响应正文的长度上限，超过时关闭连接
+    void setMaxPayload(size_t bytes) {  maxPayload_ = bytes;    }
+
+    // loop 线程中调用：未完成的调用数
+    size_t pendingCalls() const {   return pending_.size(); }
+    EventLoop* getLoop() const {    return loop_;   }
+
+private:
+    void callInLoop(uint32_t methodId, const StringPiece& request, const Callback& done);
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+    void failAll();
+
+    EventLoop* loop_;
+    TcpClient client_;
+    StateCallback stateCallback_;
+    size_t maxPayload_;
+    std::atomic<bool> connected_;
+
+    // 以下只在 loop 线程中访问
+    TcpConnectionPtr conn_;
+    uint64_t nextRequestId_;
+    std::unordered_map<uint64_t, Callback> pending_;    // requestId -> 回调
+};
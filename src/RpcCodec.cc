@@ -0,0 +1,59 @@
+#include "RpcCodec.h"
+
+#include <string.h>
+#include <endian.h>
+
+const size_t RpcCodec::kHeaderLen;
+const uint16_t RpcCodec::kResponse;
+
+void RpcCodec::encodeHeader(char* out, const RpcHeader& header, size_t payloadLen)
+{
+    uint32_t length = htobe32(static_cast<uint32_t>(kHeaderLen - 4 + payloadLen));
+    uint64_t requestId = htobe64(header.requestId);
+    uint32_t methodId = htobe32(header.methodId);
+    uint16_t status = htobe16(header.status);
+    uint16_t flags = htobe16(header.flags);
+    memcpy(out, &length, 4);
+    memcpy(out + 4, &requestId, 8);
+    memcpy(out + 12, &methodId, 4);
+    memcpy(out + 16, &status, 2);
+    memcpy(out + 18, &flags, 2);
+}
+
+RpcCodec::Result RpcCodec::decode(const char* data, size_t len, size_t maxPayload,
+                                  RpcHeader* header, StringPiece* payload, size_t* frameLen)
+{
+    if (len < 4)
+    {
+        return kIncomplete;
+    }
+    uint32_t length;
+    memcpy(&length, data, 4);
+    length = be32toh(length);
+    // 先检查长度再等待数据：非法的长度不必等到收满才发现
+    if (length < kHeaderLen - 4 || length - (kHeaderLen - 4) > maxPayload)
+    {
+        return kError;
+    }
+    if (len < 4 + static_cast<size_t>(length))
+    {
+        return kIncomplete;
+    }
+
+    uint64_t requestId;
+    uint32_t methodId;
+    uint16_t status;
+    uint16_t flags;
+    memcpy(&requestId, data + 4, 8);
+    memcpy(&methodId, data + 12, 4);
+    memcpy(&status, data + 16, 2);
+    memcpy(&flags, data + 18, 2);
+    header->requestId = be64toh(requestId);
+    header->methodId = be32toh(methodId);
+    header->status = be16toh(status);
+    header->flags = be16toh(flags);
+
+    *payload = StringPiece(data + kHeaderLen, length - (kHeaderLen - 4));
+    *frameLen = 4 + static_cast<size_t>(length);
+    return kFrame;
+}
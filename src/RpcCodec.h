@@ -0,0 +1,62 @@
+#pragma once
+
+#include "StringPiece.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**************************************************************************************
+ * RPC 帧格式（整数均为网络字节序）：
+ *
+ *     0        4            12         16       18      20
+ *     | length | requestId  | methodId | status | flags | payload ...
+ *
+ *     length 是 length 字段之后的字节数（16 字节头部 + payload）。requestId 由调用方分配，
+ * 响应原样带回，同一个连接上可以同时有任意多个未完成的调用，响应可以乱序到达；
+ * methodId 选择服务端的处理函数；status 只在响应中有意义，0 表示成功；flags 的
+ * kResponse 位区分请求和响应。
+ *     帧的长度无法信任时（超过上限、短于头部）无法再找到下一帧的边界，应关闭连接。
+**************************************************************************************/
+struct RpcHeader
+{
+    uint64_t requestId;
+    uint32_t methodId;
+    uint16_t status;
+    uint16_t flags;
+};
+
+class RpcCodec
+{
+public:
+    static const size_t kHeaderLen = 20;
+    static const size_t kDefaultMaxPayload = 16 * 1024 * 1024;
+
+    // flags
+    static const uint16_t kResponse = 0x1;
+
+    // 响应状态，16 以下保留给框架，应用自定义的错误码从 kUserError 开始
+    enum Status
+    {
+        kOk = 0,
+        kNoSuchMethod = 1,          // 服务端没有注册这个 methodId
+        kConnectionClosed = 2,      // 客户端本地生成：连接断开时未完成的调用
+        kUserError = 16,
+    };
+
+    enum Result
+    {
+        kIncomplete,
+        kFrame,
+        kError,                     // 长度字段非法，之后应关闭连接
+    };
+
+    // 把头部写入 out（至少 kHeaderLen 字节）
+    static void encodeHeader(char* out, const RpcHeader& header, size_t payloadLen);
+
+    /**
+     * 从 [data, data + len) 的开头解析一帧，不拷贝：
+     *   返回 kFrame 时 payload 指向 data 中的正文，frameLen 为整帧的长度（含 length 字段）
+     */
+    static Result decode(const char* data, size_t len, size_t maxPayload,
+                         RpcHeader* header, StringPiece* payload, size_t* frameLen);
+};
@@ -0,0 +1,93 @@
+#include "RpcServer.h"
+#include "TcpConnection.h"
+#include "Logger.h"
+
+void RpcResponder::send(uint16_t status, const StringPiece& payload) const
+{
+    TcpConnectionPtr conn = conn_.lock();
+    if (!conn || !conn->connected())
+    {
+        return;
+    }
+    RpcHeader header;
+    header.requestId = requestId_;
+    header.methodId = methodId_;
+    header.status = status;
+    header.flags = RpcCodec::kResponse;
+    char head[RpcCodec::kHeaderLen];
+    RpcCodec::encodeHeader(head, header, payload.size());
+    conn->sendv({ Slice(head, sizeof(head)), Slice(payload.data(), payload.size()) });
+}
+
+RpcServer::RpcServer(EventLoop* loop,
+                     const InetAddress& listenAddr,
+                     const std::string& name,
+                     TcpServer::Option option)
+    : server_(loop, listenAddr, name, option),
+      maxPayload_(RpcCodec::kDefaultMaxPayload)
+{
+    server_.setMessageCalback(std::bind(&RpcServer::onMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    // 同一轮事件中的多个响应（包括工作线程交回的）合并成一次写
+    server_.setWriteCoalescing(true);
+}
+
+void RpcServer::start()
+{
+    LOG_INFO("RpcServer starts listening\n");
+    server_.start();
+}
+
+/**
+ * 一次读事件中依次分发 buf 中所有完整的帧，处理函数直接引用 buf 中的正文，
+ * 全部分发完后一次从 buf 中移除。
+ */
+void RpcServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+{
+    const char* data = buf->peek();
+    size_t len = buf->readableBytes();
+    size_t consumed = 0;
+    while (conn->connected())
+    {
+        RpcHeader header;
+        RpcRequest request;
+        size_t frameLen = 0;
+        RpcCodec::Result result = RpcCodec::decode(data + consumed, len - consumed, maxPayload_,
+                                                   &header, &request.payload, &frameLen);
+        if (result == RpcCodec::kIncomplete)
+        {
+            break;
+        }
+        if (result == RpcCodec::kError || (header.flags & RpcCodec::kResponse))
+        {
+            LOG_ERROR("RpcServer::onMessage [%s] bad frame, close connection\n", conn->name().c_str());
+            buf->retrieveAll();
+            conn->forceClose();
+            return;
+        }
+        consumed += frameLen;
+
+        request.requestId = header.requestId;
+        request.methodId = header.methodId;
+        request.receiveTime = receiveTime;
+        RpcResponder responder(conn, header.requestId, header.methodId);
+        auto it = handlers_.find(header.methodId);
+        if (it == handlers_.end())
+        {
+            responder.fail(RpcCodec::kNoSuchMethod);
+        }
+        else
+        {
+            it->second(request, responder);
+        }
+    }
+
+    if (conn->connected())
+    {
+        buf->retrieve(consumed);
+    }
+    else
+    {
+        buf->retrieveAll();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TcpServer.h"
+#include "RpcCodec.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/**************************************************************************************
+ * 一次调用的请求：payload 指向连接的输入 Buffer，只在处理函数执行期间有效，
+ * 异步处理时先拷贝需要的数据。
+**************************************************************************************/
+struct RpcRequest
+{
+    uint64_t requestId;
+    uint32_t methodId;
+    StringPiece payload;
+    Timestamp receiveTime;
+};
+
+/**************************************************************************************
+ * 回复一次调用：可以拷贝，可以在任意线程中调用 reply / fail，每次调用只应回复一次。
+ *     只持有连接的弱引用，连接断开后回复被丢弃。在 IO 线程中同步回复时头部和正文直接
+ * 追加到连接的输出缓冲区（连接开启了合并写，同一轮事件中的所有回复一次写出）；在其他
+ * 线程中回复时拷贝一次，交给 IO 线程发送。
+**************************************************************************************/
+class RpcResponder
+{
+public:
+    RpcResponder(const TcpConnectionPtr& conn, uint64_t requestId, uint32_t methodId)
+        : conn_(conn), requestId_(requestId), methodId_(methodId)
+    {}
+
+    uint64_t requestId() const {    return requestId_;  }
+
+    void reply(const StringPiece& response) const { send(RpcCodec::kOk, response);  }
+    // status 不能是 kOk，message 作为响应正文
+    void fail(uint16_t status, const StringPiece& message = StringPiece()) const {  send(status, message);   }
+
+private:
+    void send(uint16_t status, const StringPiece& payload) const;
+
+    TcpConnectionWeakPtr conn_;
+    uint64_t requestId_;
+    uint32_t methodId_;
+};
+
+/**************************************************************************************
+ * 多路复用的二进制 RPC 服务器，帧格式见 RpcCodec。
+ *     一个连接上的请求可以连续发送不等待响应（流水线），一次读事件中收到的所有完整帧
+ * 依次分发给 methodId 对应的处理函数。处理函数在连接所属的 IO 线程中执行，可以立即
+ * 回复，也可以保存 RpcResponder 交给工作线程，之后在任意线程中回复；响应按完成的
+ * 顺序写出，由 requestId 对应到请求。
+ *
+ *     RpcServer server(&loop, InetAddress(9000), "rpc");
+ *     server.registerMethod(kEcho, [](const RpcRequest& req, const RpcResponder& resp) {
+ *         resp.reply(req.payload);
+ *     });
+ *     server.registerMethod(kQuery, [&pool](const RpcRequest& req, const RpcResponder& resp) {
+ *         std::string arg = req.payload.toString();
+ *         pool.run([arg, resp]() { resp.reply(query(arg)); });
+ *     });
+ *     server.setThreadNum(4);
+ *     server.start();
+**************************************************************************************/
+class RpcServer : noncopyable
+{
+public:
+    using Handler = std::function<void (const RpcRequest&, const RpcResponder&)>;
+
+    RpcServer(EventLoop* loop,
+              const InetAddress& listenAddr,
+              const std::string& name,
+              TcpServer::Option option = TcpServer::kNoReusePort);
+
+    // 底层 TcpServer，用于设置连接数上限、socket 选项、背压等，start 之前设置
+    TcpServer& tcpServer() {    return server_; }
+
+    // start 之前注册，同一个 methodId 后注册的覆盖先注册的
+    void registerMethod(uint32_t methodId, const Handler& handler) {    handlers_[methodId] = handler;   }
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads);   }
+    // 请求正文的长度上限，超过时关闭连接
+    void setMaxPayload(size_t bytes) {  maxPayload_ = bytes;    }
+
+    void start();
+
+private:
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    TcpServer server_;
+    std::unordered_map<uint32_t, Handler> handlers_;
+    size_t maxPayload_;
+};
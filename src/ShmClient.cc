@@ -0,0 +1,115 @@
+#include "ShmClient.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+ShmClient::ShmClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name)
+    : loop_(loop),
+      connector_(std::make_shared<Connector>(loop, serverAddr)),
+      name_(name),
+      callbacks_(std::make_shared<ShmCallbacks>()),
+      busyPollMicros_(0),
+      nextConnId_(1)
+{
+    callbacks_->namePrefix = name_ + "-" + serverAddr.toIpPort() + "#";
+    callbacks_->closeCallback = std::bind(&ShmClient::removeConnection, this, std::placeholders::_1);
+    connector_->setNewConnectionCallback(std::bind(&ShmClient::newConnection, this, std::placeholders::_1));
+}
+
+ShmClient::~ShmClient()
+{
+    ShmConnectionPtr conn = connection();
+    if (conn)
+    {
+        // 回调引用了 this：换成只销毁连接的回调，之后不再通知用户
+        EventLoop* loop = loop_;
+        callbacks_->connectionCallback = nullptr;
+        callbacks_->messageCallback = nullptr;
+        callbacks_->writeCompleteCallback = nullptr;
+        callbacks_->closeCallback = [loop](const ShmConnectionPtr& c) {
+            loop->queueInLoop(std::bind(&ShmConnection::connectDestroyed, c));
+        };
+        conn->forceClose();
+    }
+    if (handshakeChannel_)
+    {
+        ::close(handshakeChannel_->fd());
+        removeHandshakeChannel();
+    }
+    connector_->stop();
+}
+
+void ShmClient::connect()
+{
+    LOG_INFO("ShmClient::connect[%s] - connecting to %s\n",
+        name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+    connector_->start();
+}
+
+void ShmClient::disconnect()
+{
+    ShmConnectionPtr conn = connection();
+    if (conn)
+    {
+        conn->shutdown();
+    }
+}
+
+// 连接建立后服务端立即发送握手消息，socket 可读时再读取
+void ShmClient::newConnection(int sockfd)
+{
+    handshakeChannel_.reset(new Channel(loop_, sockfd));
+    handshakeChannel_->setReadCallback([this](Timestamp) { handleHandshake(); });
+    handshakeChannel_->setErrorCallback([this]() { handleHandshake(); });
+    handshakeChannel_->enableReading();
+}
+
+void ShmClient::handleHandshake()
+{
+    int sockfd = handshakeChannel_->fd();
+    ShmSegment segment;
+    if (!ShmSegment::receiveFrom(sockfd, &segment))
+    {
+        if (errno == EAGAIN || errno == EINTR)
+        {
+            return;
+        }
+        LOG_ERROR("ShmClient::handleHandshake[%s] - handshake failed, errno %d\n", name_.c_str(), errno);
+        removeHandshakeChannel();
+        ::close(sockfd);
+        return;
+    }
+    removeHandshakeChannel();
+
+    ShmConnectionPtr conn = std::make_shared<ShmConnection>(loop_, nextConnId_++, sockfd, segment, false, callbacks_);
+    conn->setBusyPoll(busyPollMicros_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+
+void ShmClient::removeHandshakeChannel()
+{
+    // 可能正在处理该 Channel 的事件，延迟删除
+    handshakeChannel_->disableAll();
+    handshakeChannel_->remove();
+    Channel* channel = handshakeChannel_.release();
+    loop_->queueInLoop([channel]() { delete channel; });
+}
+
+void ShmClient::removeConnection(const ShmConnectionPtr& conn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connection_ == conn)
+        {
+            connection_.reset();
+        }
+    }
+    loop_->queueInLoop(std::bind(&ShmConnection::connectDestroyed, conn));
+}
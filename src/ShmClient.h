@@ -0,0 +1,64 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "ShmConnection.h"
+#include "Connector.h"
+#include "InetAddress.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+class Channel;
+class EventLoop;
+
+/**************************************************************************************
+ * 共享内存传输的客户端：用 Connector 连上 ShmServer 的 Unix 域地址，等服务端通过
+ * SCM_RIGHTS 发来共享内存和 eventfd 后创建 ShmConnection，回调的用法与 TcpClient 相同。
+ *     不自动重连（对端是同一台机器上的进程）。ShmClient 应在 loop 线程中（或 loop 退出
+ * 之后）析构，析构时关闭连接，不再回调。
+**************************************************************************************/
+class ShmClient : noncopyable
+{
+public:
+    ShmClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name);
+    ~ShmClient();
+
+    void connect();
+    // 发送完已写入环中的数据后关闭连接
+    void disconnect();
+
+    // 当前连接，还没连上或已断开时为空，任意线程可调用
+    ShmConnectionPtr connection() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const {    return loop_;   }
+    const std::string& name() const {   return name_;   }
+
+    // 回调和选项需要在 connect 之前设置
+    void setConnectionCallback(const ShmConnectionCallback& cb) {   callbacks_->connectionCallback = cb;    }
+    void setMessageCallback(const ShmMessageCallback& cb) { callbacks_->messageCallback = cb;   }
+    void setWriteCompleteCallback(const ShmConnectionCallback& cb) {    callbacks_->writeCompleteCallback = cb; }
+    void setBusyPoll(int micros) {  busyPollMicros_ = micros;   }
+
+private:
+    void newConnection(int sockfd);
+    // 读取服务端发来的 ShmSegment
+    void handleHandshake();
+    void removeHandshakeChannel();
+    void removeConnection(const ShmConnectionPtr& conn);
+
+    EventLoop* loop_;
+    ConnectorPtr connector_;
+    const std::string name_;
+    ShmCallbacksPtr callbacks_;                 // closeCallback 固定为 removeConnection
+    int busyPollMicros_;
+    std::unique_ptr<Channel> handshakeChannel_; // 等待握手消息的 socket
+    uint64_t nextConnId_;                       // 只在 loop 线程中访问
+
+    mutable std::mutex mutex_;
+    ShmConnectionPtr connection_;
+};
@@ -0,0 +1,566 @@
+#include "ShmConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+const size_t ShmConnection::kDefaultRingCapacity;
+const size_t ShmConnection::kMaxReadBytes;
+const int ShmConnection::kMaxReadRounds;
+
+/********************************************************************************************
+ * 握手：共享内存和 eventfd 的创建与传递
+**********************************************************************************************/
+namespace
+{
+// 握手消息，随 SCM_RIGHTS 一起发送：memfd、serverWakeFd、clientWakeFd
+struct ShmHello
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ringCapacity;
+};
+
+const uint32_t kShmMagic = 0x53484d52;      // "SHMR"
+const uint32_t kShmVersion = 1;
+const int kNumShmFds = 3;
+}
+
+bool ShmSegment::create(size_t ringCapacity, ShmSegment* segment)
+{
+    if (ringCapacity > ShmRing::kMaxCapacity)
+    {
+        LOG_ERROR("ShmSegment::create ring capacity %zu too large\n", ringCapacity);
+        errno = EINVAL;
+        return false;
+    }
+    ringCapacity = ShmRing::roundUpCapacity(ringCapacity);
+    size_t ringSize = ShmRing::regionSize(ringCapacity);
+
+    int memfd = ::memfd_create("szmuduo-shm", MFD_CLOEXEC);
+    if (memfd < 0)
+    {
+        LOG_ERROR("ShmSegment::create memfd_create errno %d\n", errno);
+        return false;
+    }
+    if (::ftruncate(memfd, 2 * ringSize) < 0)
+    {
+        LOG_ERROR("ShmSegment::create ftruncate errno %d\n", errno);
+        ::close(memfd);
+        return false;
+    }
+    void* region = ::mmap(nullptr, 2 * ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (region == MAP_FAILED)
+    {
+        LOG_ERROR("ShmSegment::create mmap errno %d\n", errno);
+        ::close(memfd);
+        return false;
+    }
+    // 第一个环服务端写，第二个环客户端写
+    ShmRing ring;
+    ring.attach(region, ringCapacity, true);
+    ring.attach(static_cast<char*>(region) + ringSize, ringCapacity, true);
+    ::munmap(region, 2 * ringSize);
+
+    segment->memfd = memfd;
+    segment->serverWakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    segment->clientWakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    segment->ringCapacity = ringCapacity;
+    if (segment->serverWakeFd < 0 || segment->clientWakeFd < 0)
+    {
+        LOG_ERROR("ShmSegment::create eventfd errno %d\n", errno);
+        segment->close();
+        return false;
+    }
+    return true;
+}
+
+bool ShmSegment::sendTo(int sockfd) const
+{
+    ShmHello hello;
+    hello.magic = kShmMagic;
+    hello.version = kShmVersion;
+    hello.ringCapacity = ringCapacity;
+    iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    char control[CMSG_SPACE(sizeof(int) * kNumShmFds)];
+    memset(control, 0, sizeof(control));
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int) * kNumShmFds);
+    int fds[kNumShmFds] = { memfd, serverWakeFd, clientWakeFd };
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    // 新建立的 socket 发送缓冲区是空的，一次写完
+    ssize_t n = ::sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+    if (n != static_cast<ssize_t>(sizeof(hello)))
+    {
+        LOG_ERROR("ShmSegment::sendTo fd %d sendmsg errno %d\n", sockfd, errno);
+        return false;
+    }
+    return true;
+}
+
+bool ShmSegment::receiveFrom(int sockfd, ShmSegment* segment)
+{
+    ShmHello hello;
+    iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+    char control[CMSG_SPACE(sizeof(int) * kNumShmFds)];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = ::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0)
+    {
+        return false;
+    }
+
+    int fds[kNumShmFds] = { -1, -1, -1 };
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    if (cm != nullptr && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS
+        && cm->cmsg_len == CMSG_LEN(sizeof(int) * kNumShmFds))
+    {
+        memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+    }
+    segment->memfd = fds[0];
+    segment->serverWakeFd = fds[1];
+    segment->clientWakeFd = fds[2];
+    segment->ringCapacity = hello.ringCapacity;
+
+    if (n != static_cast<ssize_t>(sizeof(hello)) || hello.magic != kShmMagic
+        || hello.version != kShmVersion || fds[0] < 0 || (msg.msg_flags & MSG_CTRUNC))
+    {
+        LOG_ERROR("ShmSegment::receiveFrom fd %d bad handshake\n", sockfd);
+        segment->close();
+        errno = EPROTO;
+        return false;
+    }
+
+    // 对方不可信：容量必须是 create 能产生的值，memfd 必须足够大，否则 mmap 之后访问越界会 SIGBUS
+    struct stat st;
+    if (hello.ringCapacity < ShmRing::kCacheLine || hello.ringCapacity > ShmRing::kMaxCapacity
+        || (hello.ringCapacity & (hello.ringCapacity - 1)) != 0
+        || ::fstat(fds[0], &st) < 0
+        || static_cast<uint64_t>(st.st_size) < 2 * ShmRing::regionSize(hello.ringCapacity))
+    {
+        LOG_ERROR("ShmSegment::receiveFrom fd %d bad ring capacity %llu\n",
+            sockfd, (unsigned long long)hello.ringCapacity);
+        segment->close();
+        errno = EPROTO;
+        return false;
+    }
+    return true;
+}
+
+void ShmSegment::close()
+{
+    int* fds[] = { &memfd, &serverWakeFd, &clientWakeFd };
+    for (int* fd : fds)
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+/********************************************************************************************
+ * ShmConnection
+**********************************************************************************************/
+ShmConnection::ShmConnection(EventLoop* loop, uint64_t id, int controlFd, const ShmSegment& segment,
+                             bool isServer, const ShmCallbacksPtr& callbacks)
+    : loop_(loop),
+      id_(id),
+      state_(kConnecting),
+      callbacks_(callbacks ? callbacks : std::make_shared<ShmCallbacks>()),
+      controlSocket_(controlFd),
+      controlChannel_(loop, controlFd),
+      wakeFd_(isServer ? segment.serverWakeFd : segment.clientWakeFd),
+      peerWakeFd_(isServer ? segment.clientWakeFd : segment.serverWakeFd),
+      wakeChannel_(loop, wakeFd_),
+      region_(MAP_FAILED),
+      regionSize_(2 * ShmRing::regionSize(segment.ringCapacity)),
+      inputBuffer_(0),
+      outputBuffer_(0),
+      busyPollMicros_(0),
+      lastDataMicros_(0),
+      pollQueued_(false),
+      wakeupsSent_(0),
+      wakeupsSkipped_(0)
+{
+    region_ = ::mmap(nullptr, regionSize_, PROT_READ | PROT_WRITE, MAP_SHARED, segment.memfd, 0);
+    ::close(segment.memfd);     // 映射之后不再需要
+    if (region_ == MAP_FAILED)
+    {
+        LOG_FATAL("ShmConnection::ctor mmap %zu bytes errno %d\n", regionSize_, errno);
+    }
+    char* first = static_cast<char*>(region_);
+    char* second = first + regionSize_ / 2;
+    tx_.attach(isServer ? first : second, segment.ringCapacity, false);
+    rx_.attach(isServer ? second : first, segment.ringCapacity, false);
+
+    controlChannel_.setReadCallback([this](Timestamp receiveTime) { handleControl(receiveTime); });
+    controlChannel_.setCloseCallback([this]() { handleClose(); });
+    controlChannel_.setErrorCallback([this]() { handleClose(); });
+    wakeChannel_.setReadCallback([this](Timestamp receiveTime) { handleWake(receiveTime); });
+}
+
+ShmConnection::~ShmConnection()
+{
+    LOG_INFO("ShmConnection::dtor[%s] state = %d\n", name().c_str(), state_.load());
+    if (region_ != MAP_FAILED)
+    {
+        ::munmap(region_, regionSize_);
+    }
+    ::close(wakeFd_);
+    ::close(peerWakeFd_);
+}
+
+void ShmConnection::connectEstablished()
+{
+    state_ = kConnected;
+    controlChannel_.tie(shared_from_this());
+    wakeChannel_.tie(shared_from_this());
+    controlChannel_.enableReading();
+    wakeChannel_.enableReading();
+    if (callbacks_->connectionCallback)
+    {
+        callbacks_->connectionCallback(shared_from_this());
+    }
+    // 对方可能已经写入了数据
+    service(loop_->now());
+}
+
+void ShmConnection::connectDestroyed()
+{
+    if (state_ == kConnected)
+    {
+        state_ = kDisconnected;
+        controlChannel_.disableAll();
+        wakeChannel_.disableAll();
+        if (callbacks_->connectionCallback)
+        {
+            callbacks_->connectionCallback(shared_from_this());
+        }
+    }
+    controlChannel_.remove();
+    wakeChannel_.remove();
+}
+
+void ShmConnection::handleWake(Timestamp receiveTime)
+{
+    uint64_t count = 0;
+    ssize_t n = ::read(wakeFd_, &count, sizeof(count));
+    (void)n;
+    service(receiveTime);
+}
+
+void ShmConnection::service(Timestamp receiveTime)
+{
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+    flushOutput();
+    receive(receiveTime, false);
+}
+
+void ShmConnection::pollReady()
+{
+    pollQueued_ = false;
+    service(loop_->now());
+}
+
+/**
+ * 读出环中的数据交给 messageCallback，读空后决定睡眠还是继续轮询。
+ * closing 为 true 时只读出剩余的数据（对方已经关闭）。
+ */
+void ShmConnection::receive(Timestamp receiveTime, bool closing)
+{
+    for (int round = 0; round < kMaxReadRounds; ++round)
+    {
+        size_t n = rx_.readInto(&inputBuffer_, kMaxReadBytes);
+        if (n == 0)
+        {
+            if (closing)
+            {
+                return;
+            }
+            if (busyPollMicros_ > 0 && loop_->nowMonotonic() - lastDataMicros_ < busyPollMicros_)
+            {
+                // 轮询期间不置睡眠标志，对方写入时不会通知
+                if (!pollQueued_)
+                {
+                    pollQueued_ = true;
+                    std::weak_ptr<ShmConnection> weakSelf(shared_from_this());
+                    loop_->queueReady([weakSelf]() {
+                        ShmConnectionPtr self = weakSelf.lock();
+                        if (self)
+                        {
+                            self->pollReady();
+                        }
+                    });
+                }
+                return;
+            }
+            if (rx_.prepareConsumerWait())
+            {
+                return;     // 确实没有数据，等对方写 eventfd
+            }
+            continue;
+        }
+
+        lastDataMicros_ = loop_->nowMonotonic();
+        if (rx_.producerNeedsWakeup())
+        {
+            wakePeer();     // 对方在等待空间
+        }
+        if (callbacks_->messageCallback)
+        {
+            callbacks_->messageCallback(shared_from_this(), &inputBuffer_, receiveTime);
+        }
+        else
+        {
+            inputBuffer_.retrieveAll();
+        }
+        if (state_ == kDisconnected)
+        {
+            return;
+        }
+    }
+
+    // 用完本轮的读取次数，下一轮继续
+    if (!closing && !pollQueued_)
+    {
+        pollQueued_ = true;
+        std::weak_ptr<ShmConnection> weakSelf(shared_from_this());
+        loop_->queueReady([weakSelf]() {
+            ShmConnectionPtr self = weakSelf.lock();
+            if (self)
+            {
+                self->pollReady();
+            }
+        });
+    }
+}
+
+void ShmConnection::notifyPeer()
+{
+    if (tx_.consumerNeedsWakeup())
+    {
+        wakePeer();
+    }
+    else
+    {
+        wakeupsSkipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ShmConnection::wakePeer()
+{
+    uint64_t one = 1;
+    if (::write(peerWakeFd_, &one, sizeof(one)) != sizeof(one))
+    {
+        LOG_ERROR("ShmConnection::wakePeer [%s] write eventfd errno %d\n", name().c_str(), errno);
+    }
+    wakeupsSent_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 把积压的数据写进环，写不下时等对方读出空间后唤醒
+void ShmConnection::flushOutput()
+{
+    if (outputBuffer_.readableBytes() == 0)
+    {
+        return;
+    }
+    while (outputBuffer_.readableBytes() > 0)
+    {
+        size_t n = tx_.write(outputBuffer_.peek(), outputBuffer_.readableBytes());
+        if (n > 0)
+        {
+            outputBuffer_.retrieve(n);
+            notifyPeer();
+        }
+        else if (tx_.prepareProducerWait())
+        {
+            return;
+        }
+    }
+
+    if (callbacks_->writeCompleteCallback)
+    {
+        loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+    }
+    if (state_ == kDisconnecting)
+    {
+        shutdownInLoop();
+    }
+}
+
+void ShmConnection::send(const std::string& message)
+{
+    send(message.data(), message.size());
+}
+
+void ShmConnection::send(const void* data, size_t len)
+{
+    if (state_ != kConnected)
+    {
+        return;
+    }
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(data, len);
+    }
+    else
+    {
+        loop_->runInLoop(std::bind(&ShmConnection::sendCopyInLoop, shared_from_this(),
+                                   std::string(static_cast<const char*>(data), len)));
+    }
+}
+
+void ShmConnection::send(Buffer* buf)
+{
+    if (state_ != kConnected)
+    {
+        return;
+    }
+    if (loop_->isInLoopThread())
+    {
+        sendInLoop(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
+    }
+    else
+    {
+        loop_->runInLoop(std::bind(&ShmConnection::sendCopyInLoop, shared_from_this(), buf->retrieveAllAsString()));
+    }
+}
+
+void ShmConnection::sendCopyInLoop(const std::string& message)
+{
+    sendInLoop(message.data(), message.size());
+}
+
+void ShmConnection::sendInLoop(const void* data, size_t len)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("ShmConnection::sendInLoop [%s] disconnected, give up writing\n", name().c_str());
+        return;
+    }
+    const char* p = static_cast<const char*>(data);
+    size_t written = 0;
+    if (outputBuffer_.readableBytes() == 0)
+    {
+        written = tx_.write(p, len);
+        if (written > 0)
+        {
+            notifyPeer();
+        }
+    }
+    if (written < len)
+    {
+        outputBuffer_.append(p + written, len - written);
+        flushOutput();
+    }
+    else if (callbacks_->writeCompleteCallback)
+    {
+        loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+    }
+}
+
+void ShmConnection::shutdown()
+{
+    int expected = kConnected;
+    if (state_.compare_exchange_strong(expected, kDisconnecting))
+    {
+        loop_->runInLoop(std::bind(&ShmConnection::shutdownInLoop, shared_from_this()));
+    }
+}
+
+void ShmConnection::shutdownInLoop()
+{
+    // 积压的数据写进环之后再通知对方（flushOutput 写完后会再次调用）
+    if (outputBuffer_.readableBytes() == 0)
+    {
+        ::shutdown(controlSocket_.fd(), SHUT_WR);
+    }
+}
+
+void ShmConnection::forceClose()
+{
+    int state = state_;
+    if (state == kConnected || state == kDisconnecting)
+    {
+        state_ = kDisconnecting;
+        loop_->queueInLoop(std::bind(&ShmConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void ShmConnection::forceCloseInLoop()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        handleClose();
+    }
+}
+
+// 控制 socket 上只会读到 EOF（对方关闭或退出）
+void ShmConnection::handleControl(Timestamp receiveTime)
+{
+    char buf[64];
+    ssize_t n = ::read(controlSocket_.fd(), buf, sizeof(buf));
+    if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EINTR)))
+    {
+        return;
+    }
+    // 对方关闭前写入的数据还在环中
+    receive(receiveTime, true);
+    if (state_ != kDisconnected)
+    {
+        handleClose();
+    }
+}
+
+void ShmConnection::handleClose()
+{
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+    state_ = kDisconnected;
+    controlChannel_.disableAll();
+    wakeChannel_.disableAll();
+
+    ShmConnectionPtr guard(shared_from_this());
+    if (callbacks_->connectionCallback)
+    {
+        callbacks_->connectionCallback(guard);
+    }
+    if (callbacks_->closeCallback)
+    {
+        callbacks_->closeCallback(guard);
+    }
+}
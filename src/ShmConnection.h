@@ -0,0 +1,153 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Buffer.h"
+#include "Channel.h"
+#include "Socket.h"
+#include "ShmRing.h"
+#include "Timestamp.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <atomic>
+
+class EventLoop;
+class ShmConnection;
+
+using ShmConnectionPtr = std::shared_ptr<ShmConnection>;
+using ShmConnectionCallback = std::function<void (const ShmConnectionPtr&)>;
+using ShmMessageCallback = std::function<void (const ShmConnectionPtr&, Buffer*, Timestamp)>;
+
+// 与 ConnectionCallbacks 相同：同一个 ShmServer / ShmClient 的连接共享一份
+struct ShmCallbacks
+{
+    std::string namePrefix;
+    ShmConnectionCallback connectionCallback;
+    ShmMessageCallback messageCallback;
+    ShmConnectionCallback writeCompleteCallback;
+    ShmConnectionCallback closeCallback;
+};
+using ShmCallbacksPtr = std::shared_ptr<ShmCallbacks>;
+
+/**************************************************************************************
+ * 一段 memfd 共享内存（两个方向各一个 ShmRing）和两端各自的 eventfd。握手时由服务端
+ * 创建并初始化，通过 Unix 域 socket（SCM_RIGHTS）交给客户端。
+**************************************************************************************/
+struct ShmSegment
+{
+    int memfd;
+    int serverWakeFd;       // 服务端等待的 eventfd，客户端写入唤醒服务端
+    int clientWakeFd;
+    size_t ringCapacity;
+
+    ShmSegment() : memfd(-1), serverWakeFd(-1), clientWakeFd(-1), ringCapacity(0) {}
+
+    static bool create(size_t ringCapacity, ShmSegment* segment);
+    bool sendTo(int sockfd) const;
+    // 返回 false 且 errno 为 EAGAIN 时表示消息还没到
+    static bool receiveFrom(int sockfd, ShmSegment* segment);
+    void close();
+};
+
+/**************************************************************************************
+ * 同一台机器上两个进程之间的共享内存连接，用法与 TcpConnection 相同：
+ * MessageCallback 收到 Buffer，send 任意线程可调用，shutdown 发完数据后关闭。
+ *     发送直接写进对方读取的环，环满时剩余的放在 outputBuffer_ 中，等对方读出空间后
+ * 唤醒再写。读取把环中的数据拷贝进 inputBuffer_ 后回调。对方正在运行（或在轮询）时
+ * 写入不需要通知，只有对方读空、准备回到 epoll 时才写一次 eventfd，见 ShmRing。
+ *     setBusyPoll 后读空时不立即睡眠，在 micros 微秒内每轮事件循环都检查一次（poll
+ * 不阻塞），对方连续发送时完全不需要系统调用，代价是这段时间内占用 CPU。
+ *     握手用的 Unix 域 socket 保留下来，只用来检测关闭：任意一方关闭或进程退出时，
+ * 另一方读到 EOF，读出环中剩余的数据后关闭连接。
+**************************************************************************************/
+class ShmConnection : noncopyable, public std::enable_shared_from_this<ShmConnection>
+{
+public:
+    static const size_t kDefaultRingCapacity = 1024 * 1024;     // 每个方向
+    static const size_t kMaxReadBytes = 256 * 1024;             // 每次回调最多读取的字节数
+    static const int kMaxReadRounds = 16;
+
+    // 连接接管 controlFd 和 segment 中的文件描述符
+    ShmConnection(EventLoop* loop, uint64_t id, int controlFd, const ShmSegment& segment,
+                  bool isServer, const ShmCallbacksPtr& callbacks);
+    ~ShmConnection();
+
+    EventLoop* getLoop() const {    return loop_;   }
+    uint64_t id() const {   return id_; }
+    const std::string name() const {    return callbacks_->namePrefix + std::to_string(id_);    }
+    bool connected() const {    return state_ == kConnected;    }
+    bool disconnected() const { return state_ == kDisconnected; }
+
+    void setContext(const std::shared_ptr<void>& context) { context_ = context; }
+    const std::shared_ptr<void>& getContext() const {  return context_; }
+
+    void send(const std::string& message);
+    void send(const void* data, size_t len);
+    void send(Buffer* buf);
+    void shutdown();
+    void forceClose();
+
+    // 读空后继续轮询的时间（微秒），0 表示读空立即睡眠，在 loop 线程中或建立连接前设置
+    void setBusyPoll(int micros) {  busyPollMicros_ = micros;   }
+
+    // 本端写 eventfd 唤醒对方的次数 / 因对方醒着而省掉的次数，任意线程可读
+    uint64_t wakeupsSent() const {  return wakeupsSent_.load(std::memory_order_relaxed);    }
+    uint64_t wakeupsSkipped() const {   return wakeupsSkipped_.load(std::memory_order_relaxed); }
+
+    // 由 ShmServer / ShmClient 在 loop 线程中调用
+    void connectEstablished();
+    void connectDestroyed();
+
+private:
+    enum State
+    {
+        kDisconnected,
+        kConnecting,
+        kConnected,
+        kDisconnecting,
+    };
+
+    void handleWake(Timestamp receiveTime);
+    void handleControl(Timestamp receiveTime);
+    void handleClose();
+    // 写出积压的数据，读取对方发来的数据
+    void service(Timestamp receiveTime);
+    void pollReady();
+    void receive(Timestamp receiveTime, bool closing);
+    void flushOutput();
+    void notifyPeer();
+    void wakePeer();
+
+    void sendInLoop(const void* data, size_t len);
+    void sendCopyInLoop(const std::string& message);
+    void shutdownInLoop();
+    void forceCloseInLoop();
+
+    EventLoop* loop_;
+    const uint64_t id_;
+    std::atomic<int> state_;
+    ShmCallbacksPtr callbacks_;
+    std::shared_ptr<void> context_;
+
+    Socket controlSocket_;
+    Channel controlChannel_;
+    int wakeFd_;                // 本端等待的 eventfd
+    int peerWakeFd_;
+    Channel wakeChannel_;
+
+    void* region_;
+    size_t regionSize_;
+    ShmRing tx_;                // 本端写、对方读
+    ShmRing rx_;
+
+    Buffer inputBuffer_;
+    Buffer outputBuffer_;       // 环满时积压的数据
+
+    int busyPollMicros_;
+    int64_t lastDataMicros_;
+    bool pollQueued_;
+
+    std::atomic<uint64_t> wakeupsSent_;
+    std::atomic<uint64_t> wakeupsSkipped_;
+};
@@ -0,0 +1,153 @@
+#include "ShmRing.h"
+#include "Buffer.h"
+
+#include <string.h>
+#include <new>
+
+const size_t ShmRing::kCacheLine;
+const size_t ShmRing::kMaxCapacity;
+
+size_t ShmRing::roundUpCapacity(size_t capacity)
+{
+    size_t n = kCacheLine;
+    while (n < capacity)
+    {
+        n <<= 1;
+    }
+    return n;
+}
+
+size_t ShmRing::regionSize(size_t capacity)
+{
+    size_t header = (sizeof(Header) + kCacheLine - 1) / kCacheLine * kCacheLine;
+    return header + roundUpCapacity(capacity);
+}
+
+ShmRing::ShmRing()
+    : header_(nullptr),
+      data_(nullptr),
+      mask_(0),
+      cachedReadPos_(0),
+      cachedWritePos_(0)
+{
+}
+
+void ShmRing::attach(void* region, size_t capacity, bool init)
+{
+    capacity = roundUpCapacity(capacity);
+    header_ = static_cast<Header*>(region);
+    data_ = static_cast<char*>(region) + (regionSize(capacity) - capacity);
+    mask_ = capacity - 1;
+    if (init)
+    {
+        // memfd 的内容初始为 0，atomic 只需要 placement new
+        new (&header_->writePos) std::atomic<uint64_t>(0);
+        new (&header_->readPos) std::atomic<uint64_t>(0);
+        new (&header_->consumerSleeping) std::atomic<uint32_t>(1);     // 对方还没开始读，先通知
+        new (&header_->producerSleeping) std::atomic<uint32_t>(0);
+        header_->capacity = capacity;
+    }
+    cachedReadPos_ = header_->readPos.load(std::memory_order_acquire);
+    cachedWritePos_ = header_->writePos.load(std::memory_order_acquire);
+}
+
+size_t ShmRing::writableBytes() const
+{
+    uint64_t writePos = header_->writePos.load(std::memory_order_relaxed);
+    return capacity() - (writePos - header_->readPos.load(std::memory_order_acquire));
+}
+
+size_t ShmRing::write(const char* data, size_t len)
+{
+    uint64_t writePos = header_->writePos.load(std::memory_order_relaxed);
+    size_t space = capacity() - (writePos - cachedReadPos_);
+    if (space < len)
+    {
+        cachedReadPos_ = header_->readPos.load(std::memory_order_acquire);
+        space = capacity() - (writePos - cachedReadPos_);
+    }
+    size_t n = len < space ? len : space;
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    size_t offset = writePos & mask_;
+    size_t first = capacity() - offset < n ? capacity() - offset : n;
+    memcpy(data_ + offset, data, first);
+    memcpy(data_, data + first, n - first);
+    header_->writePos.store(writePos + n, std::memory_order_seq_cst);
+    return n;
+}
+
+bool ShmRing::consumerNeedsWakeup()
+{
+    if (header_->consumerSleeping.load(std::memory_order_seq_cst) == 0)
+    {
+        return false;
+    }
+    return header_->consumerSleeping.exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+bool ShmRing::prepareProducerWait()
+{
+    header_->producerSleeping.store(1, std::memory_order_seq_cst);
+    // 重新检查也要 seq_cst：acquire 读可以排到前面的标志写入之前，读到旧的 readPos
+    uint64_t writePos = header_->writePos.load(std::memory_order_relaxed);
+    if (writePos - header_->readPos.load(std::memory_order_seq_cst) < capacity())
+    {
+        header_->producerSleeping.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t ShmRing::readableBytes() const
+{
+    return header_->writePos.load(std::memory_order_acquire) - header_->readPos.load(std::memory_order_relaxed);
+}
+
+size_t ShmRing::readInto(Buffer* buf, size_t maxBytes)
+{
+    uint64_t readPos = header_->readPos.load(std::memory_order_relaxed);
+    size_t available = cachedWritePos_ - readPos;
+    if (available < maxBytes)
+    {
+        cachedWritePos_ = header_->writePos.load(std::memory_order_acquire);
+        available = cachedWritePos_ - readPos;
+    }
+    size_t n = available < maxBytes ? available : maxBytes;
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    size_t offset = readPos & mask_;
+    size_t first = capacity() - offset < n ? capacity() - offset : n;
+    buf->append(data_ + offset, first);
+    buf->append(data_, n - first);
+    header_->readPos.store(readPos + n, std::memory_order_seq_cst);
+    return n;
+}
+
+bool ShmRing::producerNeedsWakeup()
+{
+    if (header_->producerSleeping.load(std::memory_order_seq_cst) == 0)
+    {
+        return false;
+    }
+    return header_->producerSleeping.exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+bool ShmRing::prepareConsumerWait()
+{
+    header_->consumerSleeping.store(1, std::memory_order_seq_cst);
+    // 同 prepareProducerWait，writePos 用 seq_cst 读
+    uint64_t readPos = header_->readPos.load(std::memory_order_relaxed);
+    if (header_->writePos.load(std::memory_order_seq_cst) != readPos)
+    {
+        header_->consumerSleeping.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
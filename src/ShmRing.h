@@ -0,0 +1,70 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+class Buffer;
+
+/**************************************************************************************
+ * 共享内存中的单生产者单消费者字节环，两个进程各自 mmap 同一段内存后 attach。
+ *     writePos / readPos 单调递增，位置对容量（2 的幂）取模得到偏移，各占一个 cache line。
+ * 生产者写入数据后发布 writePos，消费者读取后发布 readPos，不加锁。
+ *
+ *     唤醒：消费者读空后先置 consumerSleeping 再检查一次 writePos，确实没有数据才回到
+ * epoll 等待；生产者发布 writePos 后检查 consumerSleeping，只有对方正要睡眠时才需要
+ * 通知（写 eventfd），对方醒着或在轮询时省掉这次系统调用。生产者等待空间时同理
+ * （producerSleeping）。两侧都是“先写自己的标志 / 位置，再读对方的”，用 seq_cst，
+ * 保证至少一方看到另一方，不会丢失唤醒。
+**************************************************************************************/
+class ShmRing : noncopyable
+{
+public:
+    static const size_t kCacheLine = 64;
+    static const size_t kMaxCapacity = 1024 * 1024 * 1024;     // 每个环最大 1GB
+
+    // capacity（不超过 kMaxCapacity）向上取整为 2 的幂，返回 header + 数据区的总字节数
+    static size_t roundUpCapacity(size_t capacity);
+    static size_t regionSize(size_t capacity);
+
+    ShmRing();
+
+    // region 为 regionSize(capacity) 字节的共享内存；创建方 init 为 true，初始化 header
+    void attach(void* region, size_t capacity, bool init);
+    size_t capacity() const {   return mask_ + 1;   }
+
+    // 生产者：写入尽量多的数据，返回写入的字节数
+    size_t write(const char* data, size_t len);
+    size_t writableBytes() const;
+    // 生产者：写入后调用，对方正在睡眠时返回 true（并清除标志），需要通知对方
+    bool consumerNeedsWakeup();
+    // 生产者：环满时调用，返回 true 表示确实没有空间、可以等待对方通知
+    bool prepareProducerWait();
+
+    // 消费者：把可读数据追加到 buf，最多 maxBytes，返回读取的字节数
+    size_t readInto(Buffer* buf, size_t maxBytes);
+    size_t readableBytes() const;
+    // 消费者：读取后调用，对方在等待空间时返回 true（并清除标志）
+    bool producerNeedsWakeup();
+    // 消费者：读空后调用，返回 true 表示确实没有数据、可以等待对方通知
+    bool prepareConsumerWait();
+
+private:
+    struct Header
+    {
+        alignas(kCacheLine) std::atomic<uint64_t> writePos;
+        alignas(kCacheLine) std::atomic<uint64_t> readPos;
+        alignas(kCacheLine) std::atomic<uint32_t> consumerSleeping;
+        alignas(kCacheLine) std::atomic<uint32_t> producerSleeping;
+        uint64_t capacity;
+    };
+
+    Header* header_;
+    char* data_;
+    uint64_t mask_;
+    // 本端缓存的对方位置，只在位置看起来不够时才重新读取共享的 cache line
+    uint64_t cachedReadPos_;
+    uint64_t cachedWritePos_;
+};
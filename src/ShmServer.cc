@@ -0,0 +1,98 @@
+#include "ShmServer.h"
+#include "Acceptor.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logger.h"
+
+#include <unistd.h>
+
+ShmServer::ShmServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name)
+    : loop_(loop),
+      name_(name),
+      acceptor_(new Acceptor(loop, listenAddr, false)),
+      threadPool_(new EventLoopThreadPool(loop, name)),
+      callbacks_(std::make_shared<ShmCallbacks>()),
+      ringCapacity_(ShmConnection::kDefaultRingCapacity),
+      busyPollMicros_(0),
+      started_(0),
+      nextConnId_(1)
+{
+    if (loop == nullptr)
+    {
+        LOG_FATAL("%s:%s:%d MainLoop is NULL!\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    if (!listenAddr.isUnix())
+    {
+        // 需要 SCM_RIGHTS 传递文件描述符
+        LOG_FATAL("ShmServer[%s] requires a unix domain address, got %s\n",
+            name_.c_str(), listenAddr.toIpPort().c_str());
+    }
+    callbacks_->namePrefix = name_ + "-shm#";
+    callbacks_->closeCallback = std::bind(&ShmServer::removeConnection, this, std::placeholders::_1);
+    acceptor_->setNewConnectionCallback(
+        std::bind(&ShmServer::newConnection, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+ShmServer::~ShmServer()
+{
+    for (auto& item : connections_)
+    {
+        ShmConnectionPtr conn(item.second);
+        item.second.reset();
+        conn->getLoop()->runInLoop(std::bind(&ShmConnection::connectDestroyed, conn));
+    }
+}
+
+void ShmServer::setThreadNum(int numThreads)
+{
+    threadPool_->setThreadNum(numThreads);
+}
+
+void ShmServer::start()
+{
+    if (started_++ == 0)
+    {
+        threadPool_->start(threadInitCallback_);
+        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+    }
+}
+
+void ShmServer::newConnection(int sockfd, const InetAddress& peerAddr)
+{
+    ShmSegment segment;
+    if (!ShmSegment::create(ringCapacity_, &segment))
+    {
+        ::close(sockfd);
+        return;
+    }
+    if (!segment.sendTo(sockfd))
+    {
+        segment.close();
+        ::close(sockfd);
+        return;
+    }
+
+    EventLoop* ioLoop = threadPool_->getNextLoop();
+    uint64_t connId = nextConnId_++;
+    LOG_INFO("ShmServer::newConnection [%s] - new connection %llu from %s, ring %zu bytes\n",
+        name_.c_str(), (unsigned long long)connId, peerAddr.toIpPort().c_str(), segment.ringCapacity);
+
+    // 连接接管 sockfd 和 segment 中的文件描述符
+    ShmConnectionPtr conn = std::make_shared<ShmConnection>(ioLoop, connId, sockfd, segment, true, callbacks_);
+    conn->setBusyPoll(busyPollMicros_);
+    connections_[connId] = conn;
+    ioLoop->runInLoop(std::bind(&ShmConnection::connectEstablished, conn));
+}
+
+void ShmServer::removeConnection(const ShmConnectionPtr& conn)
+{
+    loop_->runInLoop(std::bind(&ShmServer::removeConnectionInLoop, this, conn));
+}
+
+void ShmServer::removeConnectionInLoop(const ShmConnectionPtr& conn)
+{
+    LOG_INFO("ShmServer::removeConnectionInLoop [%s] - connection %s\n",
+        name_.c_str(), conn->name().c_str());
+    connections_.erase(conn->id());
+    conn->getLoop()->queueInLoop(std::bind(&ShmConnection::connectDestroyed, conn));
+}
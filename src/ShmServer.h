@@ -0,0 +1,67 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "ShmConnection.h"
+#include "InetAddress.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <unordered_map>
+
+class EventLoop;
+class Acceptor;
+class EventLoopThreadPool;
+
+/**************************************************************************************
+ * 共享内存传输的服务端：在 Unix 域地址上监听，每个新连接创建一段 ShmSegment，通过
+ * SCM_RIGHTS 交给客户端（ShmClient），之后数据只经过共享内存中的两个环，socket 只
+ * 用来检测关闭。连接按轮询分配给 IO loop，回调的用法与 TcpServer 相同。
+ *     回调和选项在 start 之前设置。ShmServer 在 baseloop 线程中析构，析构时销毁所有连接。
+ *
+ *     ShmServer server(&loop, InetAddress::unixPath("@market-data"), "feed");
+ *     server.setMessageCallback([](const ShmConnectionPtr& conn, Buffer* buf, Timestamp) { ... });
+ *     server.setThreadNum(2);
+ *     server.start();
+**************************************************************************************/
+class ShmServer : noncopyable
+{
+public:
+    using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+    ShmServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name);
+    ~ShmServer();
+
+    void setThreadNum(int numThreads);
+    void setThreadInitCallback(const ThreadInitCallback& cb) {  threadInitCallback_ = cb;   }
+    void setConnectionCallback(const ShmConnectionCallback& cb) {   callbacks_->connectionCallback = cb;    }
+    void setMessageCallback(const ShmMessageCallback& cb) { callbacks_->messageCallback = cb;   }
+    void setWriteCompleteCallback(const ShmConnectionCallback& cb) {    callbacks_->writeCompleteCallback = cb; }
+    // 每个方向环的容量，向上取整为 2 的幂
+    void setRingCapacity(size_t bytes) {    ringCapacity_ = bytes;  }
+    // 服务端连接读空后的轮询时间，见 ShmConnection::setBusyPoll
+    void setBusyPoll(int micros) {  busyPollMicros_ = micros;   }
+
+    void start();
+
+    const std::string& name() const {   return name_;   }
+
+private:
+    void newConnection(int sockfd, const InetAddress& peerAddr);
+    void removeConnection(const ShmConnectionPtr& conn);
+    void removeConnectionInLoop(const ShmConnectionPtr& conn);
+
+    EventLoop* loop_;
+    const std::string name_;
+    std::unique_ptr<Acceptor> acceptor_;
+    std::shared_ptr<EventLoopThreadPool> threadPool_;
+    ShmCallbacksPtr callbacks_;         // closeCallback 固定为 removeConnection
+    ThreadInitCallback threadInitCallback_;
+    size_t ringCapacity_;
+    int busyPollMicros_;
+    std::atomic_int started_;
+
+    uint64_t nextConnId_;
+    std::unordered_map<uint64_t, ShmConnectionPtr> connections_;
+};
@@ -8,6 +8,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <strings.h>
+#include <errno.h>
 
 Socket::~Socket()
 {
@@ -16,15 +17,15 @@ Socket::~Socket()
 
 void Socket::bindAddress(const InetAddress& localaddr)
 {
-    if (::bind(sockfd_, (sockaddr*)localaddr.getSockAddr(), sizeof(sockaddr_in)) != 0)
+    if (::bind(sockfd_, localaddr.getSockAddr(), localaddr.length()) != 0)
     {
-        LOG_FATAL("bind sockfd: %d fail \n", sockfd_);
+        LOG_FATAL("bind sockfd: %d %s fail: %d \n", sockfd_, localaddr.toIpPort().c_str(), errno);
     }
 }
 
-void Socket::listen()
+void Socket::listen(int backlog)
 {
-    if (::listen(sockfd_, 1024) != 0)
+    if (::listen(sockfd_, backlog) != 0)
     {
         LOG_FATAL("listen sockfd: %d fail \n", sockfd_);
     }
@@ -32,14 +33,15 @@ void Socket::listen()
 
 int Socket::accept(InetAddress* peeraddr)
 {
-    sockaddr_in addr;
-    socklen_t len;
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
     bzero(&addr, sizeof(addr));
 
-    int connfd = ::accept(sockfd_, (sockaddr*)&addr, &len);
+    // 已连接的 socket 必须是非阻塞的，否则 write 在对端不读时会阻塞整个 loop
+    int connfd = ::accept4(sockfd_, (sockaddr*)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0)
     {
-        peeraddr->setSockAddr(addr);
+        peeraddr->setSockAddr((sockaddr*)&addr, len);
     }
     
     return connfd;
@@ -74,4 +76,76 @@ void Socket::setKeepAlive(bool on)
 {
     int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval)); 
-}
\ No newline at end of file
+}
+
+void Socket::setNotSentLowat(int bytes)
+{
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &bytes, sizeof(bytes)) < 0)
+    {
+        LOG_ERROR("Socket::setNotSentLowat fd %d: %d\n", sockfd_, errno);
+    }
+}
+
+void Socket::setSendBuffer(int bytes)
+{
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0)
+    {
+        LOG_ERROR("Socket::setSendBuffer fd %d: %d\n", sockfd_, errno);
+    }
+}
+
+void Socket::setRecvBuffer(int bytes)
+{
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0)
+    {
+        LOG_ERROR("Socket::setRecvBuffer fd %d: %d\n", sockfd_, errno);
+    }
+}
+
+void Socket::setQuickAck(bool on)
+{
+    int optval = on ? 1 : 0;
+    ::setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK, &optval, sizeof(optval));
+}
+
+void Socket::setDeferAccept(int seconds)
+{
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) < 0)
+    {
+        LOG_ERROR("Socket::setDeferAccept fd %d: %d\n", sockfd_, errno);
+    }
+}
+
+void Socket::setFastOpen(int queueLen)
+{
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_FASTOPEN, &queueLen, sizeof(queueLen)) < 0)
+    {
+        LOG_ERROR("Socket::setFastOpen fd %d: %d\n", sockfd_, errno);
+    }
+}
+
+InetAddress Socket::localAddress(int sockfd)
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    bzero(&addr, sizeof(addr));
+    if (::getsockname(sockfd, (sockaddr*)&addr, &len) < 0)
+    {
+        LOG_ERROR("sockets:getsockname fd %d: %d\n", sockfd, errno);
+        return InetAddress();
+    }
+    return InetAddress((sockaddr*)&addr, len);
+}
+
+InetAddress Socket::peerAddress(int sockfd)
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    bzero(&addr, sizeof(addr));
+    if (::getpeername(sockfd, (sockaddr*)&addr, &len) < 0)
+    {
+        LOG_ERROR("sockets:getpeername fd %d: %d\n", sockfd, errno);
+        return InetAddress();
+    }
+    return InetAddress((sockaddr*)&addr, len);
+}
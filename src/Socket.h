@@ -12,7 +12,7 @@ public:
 
     int fd() const {    return sockfd_; }
     void bindAddress(const InetAddress& localaddr);
-    void listen();
+    void listen(int backlog = 1024);
     int accept(InetAddress* peeraddr);
 
     void shutdownWrite();
@@ -21,6 +21,19 @@ public:
     void setReuseAddr(bool on);
     void setReusePort(bool on);
     void setKeepAlive(bool on);
+    void setSendBuffer(int bytes);
+    void setRecvBuffer(int bytes);
+    void setQuickAck(bool on);
+    // 监听 socket：连接上有数据到达后才 accept，最多等待 seconds 秒
+    void setDeferAccept(int seconds);
+    // 监听 socket：开启 TCP Fast Open，queueLen 为未完成握手的 TFO 请求队列长度
+    void setFastOpen(int queueLen);
+    // 内核中未发送的数据低于 bytes 时才报告可写，0 恢复系统默认
+    void setNotSentLowat(int bytes);
+
+    // 已连接 / 已绑定 socket 的本端、对端地址，失败时返回空地址
+    static InetAddress localAddress(int sockfd);
+    static InetAddress peerAddress(int sockfd);
 private:
     const int sockfd_;
 };
\ No newline at end of file
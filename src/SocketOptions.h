@@ -0,0 +1,51 @@
+#pragma once
+
+/**************************************************************************************
+ * TcpServer 的 socket 选项：监听 socket 在 listen 之前设置，已连接的 socket 在
+ * newConnection 中设置。默认值与原来的行为一致（只开启保活，backlog 1024）。
+ *     latency()    ：关闭 Nagle、每次读取后立即回 ACK、开启 TCP Fast Open，
+ *                    适合小请求 / 小响应
+ *     throughput() ：保留 Nagle 合并小包，加大 backlog，数据到达后才 accept，
+ *                    缓冲区交给内核自动调整（设置 SO_SNDBUF/SO_RCVBUF 会关闭自动调整，
+ *                    且受 net.core.wmem_max / rmem_max 限制）
+**************************************************************************************/
+struct SocketOptions
+{
+    bool tcpNoDelay;            // TCP_NODELAY
+    bool keepAlive;             // SO_KEEPALIVE
+    bool quickAck;              // TCP_QUICKACK，内核会自动退回延迟 ACK，每次读取后重新设置
+    int sendBufferBytes;        // SO_SNDBUF，0 表示使用系统默认（自动调整）
+    int recvBufferBytes;        // SO_RCVBUF，0 表示使用系统默认（自动调整），同时设置在监听 socket 上
+    int deferAcceptSeconds;     // 监听 socket 的 TCP_DEFER_ACCEPT，0 表示关闭
+    int fastOpenQueue;          // 监听 socket 的 TCP_FASTOPEN 队列长度，0 表示关闭
+    int listenBacklog;
+
+    SocketOptions()
+        : tcpNoDelay(false),
+          keepAlive(true),
+          quickAck(false),
+          sendBufferBytes(0),
+          recvBufferBytes(0),
+          deferAcceptSeconds(0),
+          fastOpenQueue(0),
+          listenBacklog(1024)
+    {
+    }
+
+    static SocketOptions latency()
+    {
+        SocketOptions options;
+        options.tcpNoDelay = true;
+        options.quickAck = true;
+        options.fastOpenQueue = 256;
+        return options;
+    }
+
+    static SocketOptions throughput()
+    {
+        SocketOptions options;
+        options.deferAcceptSeconds = 1;
+        options.listenBacklog = 4096;
+        return options;
+    }
+};
@@ -0,0 +1,442 @@
+#include "StaticFileHandler.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+namespace
+{
+
+const uint32_t kWatchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                          | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+int createInotify()
+{
+    int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        LOG_FATAL("inotify_init1 error: %d \n", errno);
+    }
+    return fd;
+}
+
+const char* contentType(const std::string& path)
+{
+    static const struct
+    {
+        const char* ext;
+        const char* type;
+    } kTypes[] = {
+        { ".html", "text/html; charset=utf-8" },
+        { ".htm", "text/html; charset=utf-8" },
+        { ".css", "text/css" },
+        { ".js", "application/javascript" },
+        { ".json", "application/json" },
+        { ".txt", "text/plain; charset=utf-8" },
+        { ".xml", "application/xml" },
+        { ".svg", "image/svg+xml" },
+        { ".png", "image/png" },
+        { ".jpg", "image/jpeg" },
+        { ".jpeg", "image/jpeg" },
+        { ".gif", "image/gif" },
+        { ".webp", "image/webp" },
+        { ".ico", "image/x-icon" },
+        { ".woff", "font/woff" },
+        { ".woff2", "font/woff2" },
+        { ".wasm", "application/wasm" },
+        { ".pdf", "application/pdf" },
+    };
+
+    size_t dot = path.rfind('.');
+    if (dot != std::string::npos && path.find('/', dot) == std::string::npos)
+    {
+        for (const auto& t : kTypes)
+        {
+            if (strcasecmp(path.c_str() + dot, t.ext) == 0)
+            {
+                return t.type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')   return c - '0';
+    if (c >= 'a' && c <= 'f')   return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')   return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+StaticFileHandler::StaticFileHandler(EventLoop* loop, const std::string& root, size_t maxEntries, size_t maxBytes)
+    : loop_(loop),
+      root_(root.size() > 1 && root[root.size() - 1] == '/' ? root.substr(0, root.size() - 1) : root),
+      maxEntries_(maxEntries),
+      maxBytes_(maxBytes),
+      maxFileSize_(maxBytes / 16),
+      inotifyFd_(createInotify()),
+      inotifyChannel_(loop, inotifyFd_),
+      mappedBytes_(0),
+      generation_(0),
+      hits_(0),
+      misses_(0),
+      notModified_(0),
+      invalidations_(0)
+{
+    inotifyChannel_.setReadCallback([this](Timestamp) { handleInotify(); });
+    loop_->runInLoop([this]() { inotifyChannel_.enableReading(); });
+}
+
+// 在 loop 线程中析构
+StaticFileHandler::~StaticFileHandler()
+{
+    inotifyChannel_.disableAll();
+    inotifyChannel_.remove();
+    ::close(inotifyFd_);
+}
+
+void StaticFileHandler::operator()(const HttpRequest& req, HttpResponse* resp)
+{
+    if (!handle(req, resp))
+    {
+        resp->setStatusCode(404);
+    }
+}
+
+bool StaticFileHandler::handle(const HttpRequest& req, HttpResponse* resp)
+{
+    if (req.method() != HttpRequest::kGet && req.method() != HttpRequest::kHead)
+    {
+        resp->setStatusCode(405);
+        resp->addHeader("Allow", "GET, HEAD");
+        return true;
+    }
+
+    // 每个 IO 线程复用一个 key，查找缓存时不分配内存
+    static thread_local std::string key;
+    if (!resolvePath(req.path(), &key))
+    {
+        return false;
+    }
+
+    EntryPtr entry = lookup(key);
+    if (entry)
+    {
+        ++hits_;
+    }
+    else
+    {
+        ++misses_;
+        entry = load(key);
+        if (!entry)
+        {
+            return false;
+        }
+    }
+
+    // If-None-Match 优先于 If-Modified-Since；Last-Modified 按原样比较
+    bool notModified = false;
+    StringPiece ifNoneMatch = req.getHeader("If-None-Match");
+    if (!ifNoneMatch.empty())
+    {
+        notModified = ifNoneMatch == "*"
+            || memmem(ifNoneMatch.data(), ifNoneMatch.size(), entry->etag.data(), entry->etag.size()) != nullptr;
+    }
+    else
+    {
+        StringPiece ifModifiedSince = req.getHeader("If-Modified-Since");
+        notModified = !ifModifiedSince.empty() && ifModifiedSince == entry->lastModified;
+    }
+
+    resp->appendRawHeaders(entry->headers);
+    if (notModified)
+    {
+        ++notModified_;
+        resp->setStatusCode(304);
+    }
+    else if (entry->body)
+    {
+        resp->setBody(entry->body);
+    }
+    return true;
+}
+
+bool StaticFileHandler::resolvePath(const StringPiece& path, std::string* key)
+{
+    key->clear();
+    if (path.empty() || path[0] != '/')
+    {
+        return false;
+    }
+
+    // 百分号解码
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        char c = path[i];
+        if (c == '%')
+        {
+            int hi = i + 2 < path.size() ? hexValue(path[i + 1]) : -1;
+            int lo = hi >= 0 ? hexValue(path[i + 2]) : -1;
+            if (lo < 0)
+            {
+                return false;
+            }
+            c = static_cast<char>(hi * 16 + lo);
+            i += 2;
+        }
+        if (c == '\0')
+        {
+            return false;
+        }
+        key->push_back(c);
+    }
+
+    // 不允许 ".." 段跳出 root
+    size_t pos = 0;
+    while ((pos = key->find("..", pos)) != std::string::npos)
+    {
+        bool segmentStart = (*key)[pos - 1] == '/';
+        bool segmentEnd = pos + 2 == key->size() || (*key)[pos + 2] == '/';
+        if (segmentStart && segmentEnd)
+        {
+            return false;
+        }
+        pos += 2;
+    }
+
+    if ((*key)[key->size() - 1] == '/')
+    {
+        key->append("index.html");
+    }
+    return true;
+}
+
+StaticFileHandler::EntryPtr StaticFileHandler::lookup(const std::string& key)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+    {
+        return EntryPtr();
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.entry;
+}
+
+// 缓存未命中：在调用线程中打开文件并映射，先监视所在目录，再打开文件、读取文件状态
+// （监视之后的替换一定会使这次加载失效）。目录没有监视上时结果只用于本次请求
+StaticFileHandler::EntryPtr StaticFileHandler::load(const std::string& key)
+{
+    uint64_t generation;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        generation = generation_;
+    }
+    bool watched = watchDirectory(key.substr(0, key.rfind('/')));
+
+    std::string path = root_ + key;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return EntryPtr();
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return EntryPtr();
+    }
+
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    entry->size = static_cast<size_t>(st.st_size);
+    if (entry->size > 0)
+    {
+        void* addr = ::mmap(nullptr, entry->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            LOG_ERROR("StaticFileHandler::load mmap %s error: %d\n", path.c_str(), errno);
+            ::close(fd);
+            return EntryPtr();
+        }
+        size_t size = entry->size;
+        std::shared_ptr<const void> mapping(addr, [size](void* p) { ::munmap(p, size); });
+        entry->body = Payload::wrap(addr, size, mapping);
+    }
+    ::close(fd);
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "\"%lx-%zx\"", static_cast<long>(st.st_mtime), entry->size);
+    entry->etag = buf;
+    struct tm tm;
+    ::gmtime_r(&st.st_mtime, &tm);
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    entry->lastModified = buf;
+
+    entry->headers.reserve(128);
+    entry->headers.append("Content-Type: ").append(contentType(key)).append("\r\n");
+    entry->headers.append("ETag: ").append(entry->etag).append("\r\n");
+    entry->headers.append("Last-Modified: ").append(entry->lastModified).append("\r\n");
+
+    if (watched && entry->size <= maxFileSize_)
+    {
+        insert(key, entry, generation);
+    }
+    return entry;
+}
+
+void StaticFileHandler::insert(const std::string& key, const EntryPtr& entry, uint64_t generation)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 加载期间有文件失效，这次的结果可能已经过期，只用于本次请求
+    if (generation != generation_ || entries_.count(key) > 0)
+    {
+        return;
+    }
+
+    lru_.push_front(key);
+    Slot slot;
+    slot.entry = entry;
+    slot.lru = lru_.begin();
+    entries_.emplace(key, std::move(slot));
+    mappedBytes_ += entry->size;
+
+    while (!lru_.empty() && (entries_.size() > maxEntries_ || mappedBytes_ > maxBytes_))
+    {
+        evict(entries_.find(lru_.back()));
+    }
+}
+
+// 调用时已持有 mutex_；正在发送的连接还持有 Payload，映射在发送完成后才解除
+void StaticFileHandler::evict(std::unordered_map<std::string, Slot>::iterator it)
+{
+    mappedBytes_ -= it->second.entry->size;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+}
+
+bool StaticFileHandler::watchDirectory(const std::string& dir)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (watchedDirs_.count(dir) > 0)
+    {
+        return true;
+    }
+    std::string path = dir.empty() ? root_ : root_ + dir;
+    int wd = ::inotify_add_watch(inotifyFd_, path.c_str(), kWatchMask);
+    if (wd < 0)
+    {
+        // 请求不存在的目录是常见的 404，不记录
+        if (errno != ENOENT && errno != ENOTDIR)
+        {
+            LOG_ERROR("StaticFileHandler::watchDirectory %s error: %d\n", path.c_str(), errno);
+        }
+        return false;
+    }
+    watchDirs_[wd] = dir;
+    watchedDirs_[dir] = wd;
+    return true;
+}
+
+void StaticFileHandler::handleInotify()
+{
+    alignas(struct inotify_event) char buf[16 * 1024];
+    ssize_t n;
+    while ((n = ::read(inotifyFd_, buf, sizeof(buf))) > 0)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++generation_;
+        for (char* p = buf; p < buf + n; )
+        {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // 丢失了事件，无法确定哪些文件变化，全部失效
+                invalidations_ += entries_.size();
+                entries_.clear();
+                lru_.clear();
+                mappedBytes_ = 0;
+                continue;
+            }
+            auto dirIt = watchDirs_.find(event->wd);
+            if (dirIt == watchDirs_.end())
+            {
+                continue;
+            }
+            const std::string dir = dirIt->second;
+
+            if (event->len > 0)
+            {
+                std::string key = dir + "/" + event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    invalidatePrefix(key + "/");
+                }
+                else
+                {
+                    invalidate(key);
+                }
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                // 目录本身被删除或移动，之前的路径不再对应这个目录
+                invalidatePrefix(dir + "/");
+                if (!(event->mask & IN_IGNORED))
+                {
+                    ::inotify_rm_watch(inotifyFd_, event->wd);
+                }
+                watchedDirs_.erase(dir);
+                watchDirs_.erase(dirIt);
+            }
+        }
+    }
+}
+
+void StaticFileHandler::invalidate(const std::string& key)
+{
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        LOG_DEBUG("StaticFileHandler::invalidate %s\n", key.c_str());
+        evict(it);
+        ++invalidations_;
+    }
+}
+
+void StaticFileHandler::invalidatePrefix(const std::string& prefix)
+{
+    for (auto it = entries_.begin(); it != entries_.end(); )
+    {
+        auto cur = it++;
+        if (cur->first.compare(0, prefix.size(), prefix) == 0)
+        {
+            evict(cur);
+            ++invalidations_;
+        }
+    }
+}
+
+StaticFileHandler::Stats StaticFileHandler::stats() const
+{
+    Stats stats;
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    stats.notModified = notModified_.load();
+    stats.invalidations = invalidations_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats.entries = entries_.size();
+    stats.mappedBytes = mappedBytes_;
+    return stats;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Channel.h"
+#include "Payload.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+#include <string>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+class EventLoop;
+
+/**************************************************************************************
+ * 静态文件服务：把 URL 路径映射到 root 目录下的文件，缓存最近访问的文件。
+ *     缓存项保存 mmap 的文件内容（Payload，发送时与响应头部一起 writev，不拷贝）和预先
+ * 拼好的 Content-Type / ETag / Last-Modified 头部；命中时不访问磁盘，条件请求
+ * （If-None-Match / If-Modified-Since）直接回复 304。缓存按 LRU 淘汰，条目数和映射的
+ * 总字节数都有上限，超过 maxFileSize 的文件每次单独映射、不进缓存。
+ *     文件所在目录用 inotify 监视，inotify fd 通过 Channel 注册在 loop（通常是 baseloop）上，
+ * 文件被修改、删除、替换时在 loop 线程中使对应缓存项失效。handle 可以在任意 IO 线程中调用。
+ *
+ *     StaticFileHandler files(&loop, "/var/www");
+ *     server.setHttpCallback(std::ref(files));
+**************************************************************************************/
+class StaticFileHandler : noncopyable
+{
+public:
+    static const size_t kDefaultMaxEntries = 4096;
+    static const size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+    StaticFileHandler(EventLoop* loop,
+                      const std::string& root,
+                      size_t maxEntries = kDefaultMaxEntries,
+                      size_t maxBytes = kDefaultMaxBytes);
+    ~StaticFileHandler();
+
+    // 找到文件时生成响应并返回 true；文件不存在返回 false，调用方可以继续路由或回复 404
+    bool handle(const HttpRequest& req, HttpResponse* resp);
+    // 作为 HttpServer::HttpCallback 使用，文件不存在时回复 404
+    void operator()(const HttpRequest& req, HttpResponse* resp);
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t notModified;       // 回复 304 的次数
+        uint64_t invalidations;     // inotify 使缓存项失效的次数
+        size_t entries;
+        size_t mappedBytes;
+    };
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        PayloadPtr body;            // mmap 的文件内容，空文件为 nullptr
+        std::string headers;        // Content-Type / ETag / Last-Modified / Cache-Control 各行
+        std::string etag;
+        std::string lastModified;
+        size_t size;
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+    using LruList = std::list<std::string>;
+    struct Slot
+    {
+        EntryPtr entry;
+        LruList::iterator lru;
+    };
+
+    // 把 URL 路径转换为相对 root 的文件路径（以 '/' 开头），非法路径返回 false
+    static bool resolvePath(const StringPiece& path, std::string* key);
+    EntryPtr lookup(const std::string& key);
+    EntryPtr load(const std::string& key);
+    void insert(const std::string& key, const EntryPtr& entry, uint64_t generation);
+    void evict(std::unordered_map<std::string, Slot>::iterator it);
+    // 已经在监视或监视成功返回 true
+    bool watchDirectory(const std::string& dir);
+
+    // loop 线程：读取 inotify 事件，使对应的缓存项失效
+    void handleInotify();
+    void invalidate(const std::string& key);
+    void invalidatePrefix(const std::string& prefix);
+
+    EventLoop* loop_;
+    const std::string root_;
+    const size_t maxEntries_;
+    const size_t maxBytes_;
+    const size_t maxFileSize_;
+    int inotifyFd_;
+    Channel inotifyChannel_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Slot> entries_;
+    LruList lru_;                   // 头部是最近使用的
+    size_t mappedBytes_;
+    uint64_t generation_;           // 每次失效加一：加载期间发生失效的结果不放进缓存
+    std::unordered_map<int, std::string> watchDirs_;        // wd -> 相对目录
+    std::unordered_map<std::string, int> watchedDirs_;      // 相对目录 -> wd
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> notModified_;
+    std::atomic<uint64_t> invalidations_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include <stddef.h>
+
+/**************************************************************************************
+ * 一段只读字符，不持有内存：指向的数据（通常是 Buffer 中的输入数据）失效后不能再使用。
+ * 需要保存时用 toString() 拷贝。
+**************************************************************************************/
+class StringPiece
+{
+public:
+    StringPiece() : data_(""), size_(0) {}
+    StringPiece(const char* data, size_t size) : data_(data), size_(size) {}
+    StringPiece(const char* str) : data_(str), size_(strlen(str)) {}
+    StringPiece(const std::string& str) : data_(str.data()), size_(str.size()) {}
+
+    const char* data() const {  return data_;   }
+    size_t size() const {   return size_;   }
+    bool empty() const {    return size_ == 0;  }
+    const char* begin() const { return data_;   }
+    const char* end() const {   return data_ + size_;   }
+    char operator[](size_t i) const {   return data_[i];    }
+
+    std::string toString() const {  return std::string(data_, size_);  }
+
+    bool operator==(const StringPiece& other) const
+    {
+        return size_ == other.size_ && memcmp(data_, other.data_, size_) == 0;
+    }
+    bool operator!=(const StringPiece& other) const {   return !(*this == other);   }
+
+    // 忽略大小写比较（HTTP 头部名、Connection 等取值）
+    bool equalsIgnoreCase(const StringPiece& other) const
+    {
+        return size_ == other.size_ && strncasecmp(data_, other.data_, size_) == 0;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
@@ -0,0 +1,96 @@
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Socket.h"
+#include "Logger.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+TcpClient::TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name)
+    : loop_(loop),
+      connector_(std::make_shared<Connector>(loop, serverAddr)),
+      name_(name),
+      callbacks_(std::make_shared<ConnectionCallbacks>()),
+      retry_(false),
+      connect_(false),
+      nextConnId_(1)
+{
+    callbacks_->namePrefix = name_ + "-" + serverAddr.toIpPort() + "#";
+    callbacks_->closeCallback = std::bind(&TcpClient::removeConnection, this, std::placeholders::_1);
+    connector_->setNewConnectionCallback(std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+    LOG_INFO("TcpClient::TcpClient[%s] - connector %p\n", name_.c_str(), connector_.get());
+}
+
+TcpClient::~TcpClient()
+{
+    LOG_INFO("TcpClient::~TcpClient[%s] - connector %p\n", name_.c_str(), connector_.get());
+    TcpConnectionPtr conn = connection();
+    if (conn)
+    {
+        // 回调引用了 this：换成只销毁连接的回调，之后不再通知用户
+        EventLoop* loop = loop_;
+        callbacks_->connectionCallback = nullptr;
+        callbacks_->messageCallback = nullptr;
+        callbacks_->writeCompleteCallback = nullptr;
+        callbacks_->closeCallback = [loop](const TcpConnectionPtr& c) {
+            loop->queueInLoop(std::bind(&TcpConnection::connectDistroyed, c));
+        };
+        conn->forceClose();
+    }
+    connector_->stop();
+}
+
+void TcpClient::connect()
+{
+    LOG_INFO("TcpClient::connect[%s] - connecting to %s\n",
+        name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect()
+{
+    connect_ = false;
+    TcpConnectionPtr conn = connection();
+    if (conn)
+    {
+        conn->shutdown();
+    }
+}
+
+void TcpClient::stop()
+{
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd)
+{
+    TcpConnectionPtr conn = std::make_shared<TcpConnection>(
+        loop_, sockfd, Socket::localAddress(sockfd), Socket::peerAddress(sockfd), nextConnId_++, callbacks_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr& conn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connection_ == conn)
+        {
+            connection_.reset();
+        }
+    }
+
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDistroyed, conn));
+    if (retry_ && connect_)
+    {
+        LOG_INFO("TcpClient::removeConnection[%s] - reconnecting to %s\n",
+            name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
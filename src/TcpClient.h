@@ -0,0 +1,74 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "Connector.h"
+#include "InetAddress.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+class EventLoop;
+
+/**************************************************************************************
+ * TCP 客户端：用 Connector 在 loop 中非阻塞地建立连接，连接成功后创建与服务端相同的
+ * TcpConnection，回调的用法与 TcpServer 一致。
+ *     enableRetry 后连接断开时自动重连（Connector 的指数退避）。connect / disconnect /
+ * stop 任意线程可调用；TcpClient 应在 loop 线程中（或 loop 退出之后）析构，析构时关闭连接，
+ * 不再回调。
+ *
+ *     TcpClient client(&loop, InetAddress(9000), "backend");
+ *     client.setConnectionCallback(onConnection);
+ *     client.setMessageCallback(onMessage);
+ *     client.enableRetry();
+ *     client.connect();
+**************************************************************************************/
+class TcpClient : noncopyable
+{
+public:
+    TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name);
+    ~TcpClient();
+
+    void connect();
+    // 半关闭当前连接（发送完已写入的数据后关闭写端），不再重连
+    void disconnect();
+    // 停止正在进行的连接尝试
+    void stop();
+
+    // 当前连接，还没连上或已断开时为空，任意线程可调用
+    TcpConnectionPtr connection() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const {    return loop_;   }
+    const std::string& name() const {   return name_;   }
+    bool retry() const {    return retry_;  }
+    void enableRetry() {    retry_ = true;  }
+    // 重连间隔（毫秒），见 Connector::setRetryDelay，connect 之前设置
+    void setRetryDelay(int initialMs, int maxMs) {  connector_->setRetryDelay(initialMs, maxMs);    }
+
+    // 回调需要在 connect 之前设置
+    void setConnectionCallback(const ConnectionCallback& cb) {  callbacks_->connectionCallback = cb;    }
+    void setMessageCallback(const MessageCallback& cb) {    callbacks_->messageCallback = cb;   }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb) {    callbacks_->writeCompleteCallback = cb; }
+    // 每次连接失败时回调（开启重试时之后仍会重连），在 loop 线程中执行
+    void setConnectErrorCallback(const Connector::ErrorCallback& cb) {  connector_->setErrorCallback(cb);   }
+
+private:
+    void newConnection(int sockfd);
+    void removeConnection(const TcpConnectionPtr& conn);
+
+    EventLoop* loop_;
+    ConnectorPtr connector_;
+    const std::string name_;
+    ConnectionCallbacksPtr callbacks_;      // 连接的回调，closeCallback 固定为 removeConnection
+    std::atomic<bool> retry_;
+    std::atomic<bool> connect_;
+    ConnectionId nextConnId_;               // 只在 loop 线程中访问
+
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_;
+};
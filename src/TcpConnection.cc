@@ -3,11 +3,23 @@
 #include "Socket.h"
 #include "Channel.h"
 #include "EventLoop.h"
+#include "ConnectionRegistry.h"
+#include "MemoryGovernor.h"
+#include "TokenBucket.h"
+#include "PipePool.h"
+#include "ComputePool.h"
 
 #include <string>
+#include <algorithm>
 #include <functional>
 #include <errno.h>
-#include <string>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 限速时令牌用完后，至少等令牌够写一段数据再写，避免定时器过于频繁
+static const size_t kShapingChunk = 16 * 1024;
+static const int64_t kMinShapingWaitMicros = 1000;
 
 static EventLoop* checkLoopNotNULL(EventLoop* loop)
 {
@@ -19,84 +31,244 @@ static EventLoop* checkLoopNotNULL(EventLoop* loop)
 }
 
 TcpConnection::TcpConnection(EventLoop* loop,
-                const std::string nameArg,
                 int sockfd,
                 const InetAddress& localAddr,
-                const InetAddress& peerAddr)
+                const InetAddress& peerAddr,
+                ConnectionId id,
+                const ConnectionCallbacksPtr& callbacks)
     : loop_(checkLoopNotNULL(loop)),
-      name_(nameArg),
+      id_(id),
       state_(kConnecting),
-      reading_(true),
-      socket_(new Socket(sockfd)),
-      channel_(new Channel(loop, sockfd)),
+      reading_(false),
+      writeCoalescing_(false),
+      flushScheduled_(false),
+      readPauseMask_(0),
+      consumerPauseCount_(0),
+      readBudgetBytes_(0),
+      readBudgetReads_(0),
+      budgetIteration_(0),
+      budgetBytesUsed_(0),
+      budgetReadsUsed_(0),
+      readyQueued_(false),
+      refillScheduled_(false),
+      notSentLowat_(0),
+      quickAck_(false),
+      lastActiveMicros_(Timestamp::monotonicMicros()),
+      shapedBytes_(0),
+      unshapedBytes_(0),
+      socket_(sockfd),
+      channel_(loop, sockfd),
       localAddr_(localAddr),
       peerAddr_(peerAddr),
-      highWaterMark_(64*1024*1024)
+      callbacks_(callbacks ? callbacks : std::make_shared<ConnectionCallbacks>()),
+      highWaterMark_(64*1024*1024),
+      lowWaterMark_(0),
+      backpressure_(false),
+      pauseSelfOnHighWater_(false),
+      aboveHighWater_(false),
+      highWaterEpoch_(0),
+      slowConsumerTimeout_(0),
+      relaySplice_(false),
+      relayReadEof_(false),
+      relayPipeBytes_(0),
+      relayedBytes_(0),
+      inputBuffer_(0),          // 缓冲区在第一次读写时才分配内存
+      outputBuffer_(0),
+      pendingPayloadBytes_(0)
 {
-    channel_->setReadCallback(
-        std::bind(&TcpConnection::handleRead, this, std::placeholders::_1)
-    );
-    channel_->setWriteCallback(
-        std::bind(&TcpConnection::handleWrite, this)
-    );
-    channel_->setCloseCallback(
-        std::bind(&TcpConnection::handleClose, this)
-    );
-    channel_->setErrorCallback(
-        std::bind(&TcpConnection::handleError, this)
-    );
+    // lambda 只捕获 this，可以直接存放在 std::function 内部，不需要额外分配内存
+    channel_.setReadCallback([this](Timestamp receiveTime) { handleRead(receiveTime); });
+    channel_.setWriteCallback([this]() { handleWrite(); });
+    channel_.setCloseCallback([this]() { handleClose(); });
+    channel_.setErrorCallback([this]() { handleError(); });
+    relayPipe_[0] = -1;
+    relayPipe_[1] = -1;
 
-    LOG_INFO("TcpConnection::ctor[%s] at fd %d\n", name_.c_str(), sockfd);
-    socket_->setKeepAlive(true);        // 启动 tcp 保活机制 
+    LOG_INFO("TcpConnection::ctor[%s] at fd %d\n", name().c_str(), sockfd);
+    socket_.setKeepAlive(true);        // 启动 tcp 保活机制 
 }
 
 TcpConnection::~TcpConnection()
 {
     LOG_INFO("TcpConnection::dtor[%s[ at fd = %d state = %d\n",
-        name_.c_str(), channel_->fd(), (int)state_);
-    
+        name().c_str(), channel_.fd(), (int)state_);
+    if (relayPipe_[0] >= 0)     // 没有经过 handleClose 的转发连接
+    {
+        ::close(relayPipe_[0]);
+        ::close(relayPipe_[1]);
+    }
 }
 
-void TcpConnection::handleRead(Timestamp receiveTime)
+ConnectionCallbacks& TcpConnection::ownCallbacks()
 {
-    int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    if (!callbacks_.unique())
+    {
+        callbacks_ = std::make_shared<ConnectionCallbacks>(*callbacks_);
+    }
+    return *callbacks_;
+}
 
-    if (n > 0)  // 有可读事件发生
+void TcpConnection::setSocketOptions(const SocketOptions& options)
+{
+    socket_.setKeepAlive(options.keepAlive);
+    if (!localAddr_.isUnix())       // Unix 域 socket 没有 TCP 层的选项
     {
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        socket_.setTcpNoDelay(options.tcpNoDelay);
     }
-    else if (n == 0)    // 客户端断开
+    if (options.sendBufferBytes > 0)
     {
-        handleClose();
+        socket_.setSendBuffer(options.sendBufferBytes);
+    }
+    if (options.recvBufferBytes > 0)
+    {
+        socket_.setRecvBuffer(options.recvBufferBytes);
+    }
+    quickAck_ = options.quickAck && !localAddr_.isUnix();
+    if (quickAck_)
+    {
+        socket_.setQuickAck(true);
+    }
+}
+
+void TcpConnection::setReadBudget(size_t maxBytes, int maxReads)
+{
+    readBudgetBytes_ = maxBytes;
+    readBudgetReads_ = maxReads;
+}
+
+void TcpConnection::handleRead(Timestamp receiveTime)
+{
+    if (relaySplice_)
+    {
+        spliceReadInLoop();
+        return;
     }
-    else        // 出错
+
+    // 没有预算的水平触发连接每次事件只读一次，由 poller 再次通知
+    const bool drain = readBudgetBytes_ > 0 || readBudgetReads_ > 0 || channel_.edgeTriggered();
+    if (budgetIteration_ != loop_->iteration())
     {
-        errno = savedErrno;
-        LOG_ERROR("TcpConnection::handleRead\n");
-        handleError();
+        budgetIteration_ = loop_->iteration();
+        budgetBytesUsed_ = 0;
+        budgetReadsUsed_ = 0;
     }
 
+    do
+    {
+        const size_t maxBytes = readBudgetBytes_ > 0 ? readBudgetBytes_ - budgetBytesUsed_ : SIZE_MAX;
+        if (maxBytes == 0 || (readBudgetReads_ > 0 && budgetReadsUsed_ >= readBudgetReads_))
+        {
+            // 预算用完：水平触发下一轮 poll 还会通知，边沿触发要自己排到下一轮
+            if (channel_.edgeTriggered() && !readyQueued_)
+            {
+                readyQueued_ = true;
+                TcpConnectionWeakPtr weakConn(shared_from_this());
+                loop_->queueReady([weakConn]() {
+                    TcpConnectionPtr conn = weakConn.lock();
+                    if (conn)
+                    {
+                        conn->handleReadReady();
+                    }
+                });
+            }
+            return;
+        }
+
+        int savedErrno = 0;
+        ssize_t n = inputBuffer_.readFd(channel_.fd(), &savedErrno, maxBytes);
+
+        if (n > 0)  // 有可读事件发生
+        {
+            if (quickAck_)
+            {
+                socket_.setQuickAck(true);
+            }
+            lastActiveMicros_.store(loop_->nowMonotonic(), std::memory_order_relaxed);
+            budgetBytesUsed_ += n;
+            ++budgetReadsUsed_;
+            if (callbacks_->messageCallback)
+            {
+                callbacks_->messageCallback(shared_from_this(), &inputBuffer_, receiveTime);
+            }
+            else
+            {
+                inputBuffer_.retrieveAll();
+            }
+
+            // 服务器内存即将超出预算：不等 TcpServer 定时检查，立即停止读取
+            if (memoryGovernor_ && !(readPauseMask_ & kPauseByMemory)
+                && memoryGovernor_->level() >= MemoryGovernor::kRejectNew)
+            {
+                pauseReadInLoop(kPauseByMemory);
+                memoryGovernor_->addPaused(shared_from_this());
+            }
+        }
+        else if (n == 0)    // 客户端断开
+        {
+            handleClose();
+            return;
+        }
+        else if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK)     // 已读完
+        {
+            return;
+        }
+        else        // 出错
+        {
+            errno = savedErrno;
+            LOG_ERROR("TcpConnection::handleRead\n");
+            handleError();
+            return;
+        }
+    } while (drain && channel_.isReading());   // 回调中可能暂停读取或关闭连接
+}
+
+void TcpConnection::handleReadReady()
+{
+    readyQueued_ = false;
+    if (channel_.isReading())
+    {
+        handleRead(loop_->now());
+    }
 }
 
 void TcpConnection::handleWrite()
 {
-    if (channel_->isWriting())  // 可读
+    if (relaySplice_ && channel_.isWriting() && pendingOutputBytes() == 0)
+    {
+        // 自己的发送队列已空，可写事件用于对端管道中的数据
+        TcpConnectionPtr peer = relayPeer_.lock();
+        if (peer)
+        {
+            peer->spliceOutInLoop();
+        }
+        else
+        {
+            channel_.disableWriting();
+        }
+        return;
+    }
+
+    if (channel_.isWriting() && pacedOutput())
+    {
+        pacedWriteInLoop();
+    }
+    else if (channel_.isWriting())  // 可读
     {
         int saveErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+        ssize_t n = writeOutput(&saveErrno);
 
         if (n > 0)
         {
-            outputBuffer_.retrieve(n);  // 已经读取 n 个数据
-            if (outputBuffer_.readableBytes() == 0)       // 可读数据为0， 设置不可写
+            unshapedBytes_.fetch_add(n, std::memory_order_relaxed);
+            checkLowWater();
+            if (pendingOutputBytes() == 0)       // 可读数据为0， 设置不可写
             {
-                channel_->disableWriting();
-                if (writeCompleteCallback_)
+                channel_.disableWriting();
+                if (callbacks_->writeCompleteCallback)
                 {
                     // 唤醒 loop_ 对应 thread，执行回调
                     loop_->queueInLoop(
-                        std::bind(writeCompleteCallback_, shared_from_this())
+                        std::bind(callbacks_->writeCompleteCallback, shared_from_this())
                     );
                 }
 
@@ -104,6 +276,13 @@ void TcpConnection::handleWrite()
                 {
                     shutdownInLoop();
                 }
+
+                // 转发开始前积压的数据已写完，接着写对端管道中的数据
+                TcpConnectionPtr peer = relaySplice_ ? relayPeer_.lock() : TcpConnectionPtr();
+                if (peer)
+                {
+                    peer->spliceOutInLoop();
+                }
             }
         }
         else
@@ -111,20 +290,34 @@ void TcpConnection::handleWrite()
             LOG_ERROR("TcpConnection::handleWrite\n");
         }
     }
-    else{   // 不可读
-        LOG_ERROR("TcpDConnection fd = %d is down, no more writing\n", channel_->fd());
+    else{   // 不可读：同一轮中已经关闭了 EPOLLOUT（如 discardPendingOutput 清空了队列）
+        LOG_DEBUG("TcpDConnection fd = %d is down, no more writing\n", channel_.fd());
     }
 }
 
 // poller => channel::closeCallback =>TcpConnection：：handleClose
 void TcpConnection::handleClose()
 {
-    LOG_INFO("fd = %d state = %d\n", channel_->fd(), (int)state_);
+    LOG_INFO("fd = %d state = %d\n", channel_.fd(), (int)state_);
     setState(kDisconnected);    
+    channel_.disableAll();      // 不再关注任何事件，否则 LT 模式下会反复触发 close
+    reading_ = false;
+    if (aboveHighWater_)        // 不再有积压，恢复被本连接暂停的上游
+    {
+        aboveHighWater_ = false;
+        notifyProducers(false);
+    }
 
     TcpConnectionPtr connPtr(shared_from_this());
-    connectionCallback_(connPtr);   // 连接关闭的回调
-    closeCallback_(connPtr);        // 关闭连接,TcpServer ::removeConnection 回调
+    stopRelayInLoop();
+    if (callbacks_->connectionCallback)
+    {
+        callbacks_->connectionCallback(connPtr);   // 连接关闭的回调
+    }
+    if (callbacks_->closeCallback)
+    {
+        callbacks_->closeCallback(connPtr);        // 关闭连接,TcpServer ::removeConnection 回调
+    }
 }
 
 void TcpConnection::handleError()
@@ -132,7 +325,7 @@ void TcpConnection::handleError()
     int err = 0; 
     int optval;
     socklen_t optlen = sizeof(optval);
-    if (::getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
+    if (::getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
     {
         err = errno;
     }
@@ -141,7 +334,7 @@ void TcpConnection::handleError()
         err = optval;
     }
 
-    LOG_ERROR("TcpConnection::handleError name: %s -s SO_ERROR: %d\n", name_.c_str(), err);
+    LOG_ERROR("TcpConnection::handleError name: %s -s SO_ERROR: %d\n", name().c_str(), err);
 }
 
 void TcpConnection::send(const std::string& buf)
@@ -154,16 +347,35 @@ void TcpConnection::send(const std::string& buf)
         }
         else
         {
-            loop_->runInLoop(std::bind(
-                &TcpConnection::sendInLoop,
-                this,
-                buf.c_str(),
-                buf.size()
-            ));
+            // 跨线程：拷贝一份数据，并持有连接，防止执行前 buf 或连接已经释放
+            void (TcpConnection::*fp)(const std::string&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), buf));
+        }
+    }
+}
+
+void TcpConnection::send(Buffer* buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        }
+        else
+        {
+            void (TcpConnection::*fp)(const std::string&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), buf->retrieveAllAsString()));
         }
     }
 }
 
+void TcpConnection::sendInLoop(const std::string& message)
+{
+    sendInLoop(message.data(), message.size());
+}
+
 // 发送数据，应用快，内核发送较慢，需要将发送数据写入缓冲区，设置了水位回调
 void TcpConnection::sendInLoop(const void* data, size_t len)
 {
@@ -177,18 +389,46 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         return ;
     }
 
+    // 合并写：先放进缓冲区，本轮结束时统一写出
+    if (writeCoalescing_)
+    {
+        size_t oldLen = pendingOutputBytes();
+        appendOutput(data, len);
+        if (!flushScheduled_ && !channel_.isWriting())
+        {
+            flushScheduled_ = true;
+            loop_->queueAfterEvents(std::bind(&TcpConnection::flushInLoop, shared_from_this()));
+        }
+        checkHighWater(oldLen);
+        return;
+    }
+
+    // 限速或低延迟发送：先放进发送队列，由 pacedWriteInLoop 控制写出的量
+    if (pacedOutput())
+    {
+        size_t oldLen = pendingOutputBytes();
+        appendOutput(data, len);
+        if (!refillScheduled_ && !channel_.isWriting())
+        {
+            pacedWriteInLoop();
+        }
+        checkHighWater(oldLen);
+        return;
+    }
+
     // channel 第一次开始写数据，且缓冲区无发送数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    if (!channel_.isWriting() && pendingOutputBytes() == 0)
     {
-        nwrote = ::write(channel_->fd(), data, len);
+        nwrote = ::write(channel_.fd(), data, len);
         if (nwrote >= 0)
         {
+            unshapedBytes_.fetch_add(nwrote, std::memory_order_relaxed);
             remaining = len - nwrote;
-            if (remaining == 0 && writeCompleteCallback_)
+            if (remaining == 0 && callbacks_->writeCompleteCallback)
             {
                 // 数据全部发送完成，无需给channel 设置 epollout 事件
                 loop_->queueInLoop(std::bind(
-                    writeCompleteCallback_, shared_from_this()
+                    callbacks_->writeCompleteCallback, shared_from_this()
                 ));
             }
         }
@@ -212,67 +452,1281 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     if (!faultError && remaining > 0)   
     {
         // 目前发送缓冲区剩余的待发送数据
-        size_t oldLen = outputBuffer_.readableBytes();
-        if (oldLen + remaining >= highWaterMark_    // 上一次会调用 高水位回调
-            && oldLen < highWaterMark_
-            && highWaterMark_)
+        size_t oldLen = pendingOutputBytes();
+        appendOutput(static_cast<const char*> (data) + nwrote, remaining);
+        if (!channel_.isWriting())
         {
-            loop_->queueInLoop(
-                std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining)
-            );
+            channel_.enableWriting();
         }
+        checkHighWater(oldLen);
+    }
+}
+
+void TcpConnection::sendv(const struct iovec* iov, int iovcnt)
+{
+    if (state_ != kConnected)
+    {
+        return;
+    }
 
-        outputBuffer_.append(static_cast<const char*> (data) + nwrote, remaining);
-        if (!channel_->isWriting())
+    if (loop_->isInLoopThread())
+    {
+        sendvInLoop(iov, iovcnt);
+    }
+    else
+    {
+        std::string message;
+        for (int i = 0; i < iovcnt; ++i)
         {
-            channel_->enableWriting();
+            message.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
         }
+        void (TcpConnection::*fp)(const std::string&) = &TcpConnection::sendInLoop;
+        loop_->runInLoop(std::bind(fp, shared_from_this(), std::move(message)));
     }
 }
 
-// 连接建立
-void TcpConnection::connectEstablished()
+void TcpConnection::sendv(std::initializer_list<Slice> slices)
 {
-    setState(kConnected);
-    channel_->tie(shared_from_this());
-    channel_->enableReading();
+    sendSlices(slices.begin(), slices.size());
+}
 
-    // 新连接建立，执行回调
-    connectionCallback_(shared_from_this());
+void TcpConnection::sendv(const std::vector<Slice>& slices)
+{
+    sendSlices(slices.data(), slices.size());
 }
 
-// 连接销毁
-void TcpConnection::connectDistroyed()
+void TcpConnection::sendSlices(const Slice* slices, size_t count)
 {
-    if (state_ == kConnected)
+    // Slice 与 iovec 布局不同，转换一次（片段数很少，放在栈上）
+    struct iovec stackIov[16];
+    std::vector<struct iovec> heapIov;
+    struct iovec* iov = stackIov;
+    if (count > 16)
     {
-        setState(kDisconnected);
-        channel_->disableAll();
+        heapIov.resize(count);
+        iov = heapIov.data();
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        iov[i].iov_base = const_cast<void*>(slices[i].data);
+        iov[i].iov_len = slices[i].len;
+    }
+    sendv(iov, static_cast<int>(count));
+}
+
+void TcpConnection::sendvInLoop(const struct iovec* iov, int iovcnt)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing\n");
+        return;
+    }
 
-        connectionCallback_(shared_from_this());
+    // 已经有待发送数据、处于合并写模式、限速或低延迟发送：逐段追加，保持顺序
+    if (writeCoalescing_ || channel_.isWriting() || pendingOutputBytes() > 0 || pacedOutput())
+    {
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            sendInLoop(iov[i].iov_base, iov[i].iov_len);
+        }
+        return;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        total += iov[i].iov_len;
+    }
+
+    // 一次 writev 最多 IOV_MAX 段，剩下的段直接进入缓冲区
+    int writeCount = iovcnt < IOV_MAX ? iovcnt : IOV_MAX;
+    ssize_t nwrote = ::writev(channel_.fd(), iov, writeCount);
+    if (nwrote < 0)
+    {
+        nwrote = 0;
+        if (errno != EWOULDBLOCK)
+        {
+            LOG_ERROR("TcpConnection::sendvInLoop\n");
+            if (errno == EPIPE || errno == ECONNRESET)
+            {
+                return;
+            }
+        }
+    }
+    unshapedBytes_.fetch_add(nwrote, std::memory_order_relaxed);
+
+    if (static_cast<size_t>(nwrote) == total)
+    {
+        if (callbacks_->writeCompleteCallback)
+        {
+            loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+        }
+        return;
+    }
+
+    // 跳过已经写出的部分，其余拷贝进发送缓冲区
+    size_t skip = static_cast<size_t>(nwrote);
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        const char* base = static_cast<const char*>(iov[i].iov_base);
+        size_t len = iov[i].iov_len;
+        if (skip >= len)
+        {
+            skip -= len;
+            continue;
+        }
+        appendOutput(base + skip, len - skip);
+        skip = 0;
     }
-    channel_->remove(); // 从 poller 中删除 channel
+    channel_.enableWriting();
+    checkHighWater(0);
 }
 
-// 关闭连接
-void TcpConnection::shutdown()
+void TcpConnection::send(const PayloadPtr& payload)
+{
+    if (state_ == kConnected && payload)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendPayloadInLoop(payload);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&TcpConnection::sendPayloadInLoop, shared_from_this(), payload));
+        }
+    }
+}
+
+void TcpConnection::sendPayloadInLoop(const PayloadPtr& payload)
+{
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing\n");
+        return;
+    }
+
+    size_t oldLen = pendingOutputBytes();
+    size_t nwrote = 0;
+    if (!writeCoalescing_ && !channel_.isWriting() && oldLen == 0 && !pacedOutput())
+    {
+        ssize_t n = ::write(channel_.fd(), payload->data(), payload->size());
+        if (n >= 0)
+        {
+            nwrote = static_cast<size_t>(n);
+            unshapedBytes_.fetch_add(nwrote, std::memory_order_relaxed);
+            if (nwrote == payload->size())
+            {
+                if (callbacks_->writeCompleteCallback)
+                {
+                    loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+                }
+                return;
+            }
+        }
+        else if (errno != EWOULDBLOCK)
+        {
+            LOG_ERROR("TcpConnection::sendPayloadInLoop\n");
+            if (errno == EPIPE || errno == ECONNRESET)
+            {
+                return;
+            }
+        }
+    }
+
+    // 没写完的部分只记录引用和偏移
+    appendOutput(payload, nwrote);
+    scheduleOutput();
+    checkHighWater(oldLen);
+}
+
+void TcpConnection::send(Buffer* buf, const PayloadPtr& payload)
 {
     if (state_ == kConnected)
     {
-        setState(kDisconnecting);
-        loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf->peek(), buf->readableBytes(), payload);
+            buf->retrieveAll();
+        }
+        else
+        {
+            void (TcpConnection::*fp)(const std::string&, const PayloadPtr&) = &TcpConnection::sendInLoop;
+            loop_->runInLoop(std::bind(fp, shared_from_this(), buf->retrieveAllAsString(), payload));
+        }
     }
 }
 
-void TcpConnection::shutdownInLoop()
+void TcpConnection::sendInLoop(const std::string& message, const PayloadPtr& payload)
+{
+    sendInLoop(message.data(), message.size(), payload);
+}
+
+// 头部 + 共享正文：发送队列为空时一次 writev，没写完的头部拷贝进缓冲区，正文只记录引用
+void TcpConnection::sendInLoop(const void* data, size_t len, const PayloadPtr& payload)
+{
+    if (!payload)
+    {
+        sendInLoop(data, len);
+        return;
+    }
+    if (len == 0)
+    {
+        sendPayloadInLoop(payload);
+        return;
+    }
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("disconnected, give up writing\n");
+        return;
+    }
+
+    size_t oldLen = pendingOutputBytes();
+    size_t nwrote = 0;
+    if (!writeCoalescing_ && !channel_.isWriting() && oldLen == 0 && !pacedOutput())
+    {
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(data);
+        iov[0].iov_len = len;
+        iov[1].iov_base = const_cast<char*>(payload->data());
+        iov[1].iov_len = payload->size();
+        ssize_t n = ::writev(channel_.fd(), iov, 2);
+        if (n >= 0)
+        {
+            nwrote = static_cast<size_t>(n);
+            unshapedBytes_.fetch_add(nwrote, std::memory_order_relaxed);
+            if (nwrote == len + payload->size())
+            {
+                if (callbacks_->writeCompleteCallback)
+                {
+                    loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+                }
+                return;
+            }
+        }
+        else if (errno != EWOULDBLOCK)
+        {
+            LOG_ERROR("TcpConnection::sendInLoop\n");
+            if (errno == EPIPE || errno == ECONNRESET)
+            {
+                return;
+            }
+        }
+    }
+
+    if (nwrote < len)
+    {
+        appendOutput(static_cast<const char*>(data) + nwrote, len - nwrote);
+        appendOutput(payload, 0);
+    }
+    else
+    {
+        appendOutput(payload, nwrote - len);
+    }
+    scheduleOutput();
+    checkHighWater(oldLen);
+}
+
+// 数据已经放进发送队列：按合并写 / 限速 / 普通模式安排写出
+void TcpConnection::scheduleOutput()
 {
-    // outputBuffer 中数据全部发送完成
-    if (!channel_->isWriting())
+    if (writeCoalescing_)
+    {
+        if (!flushScheduled_ && !channel_.isWriting())
+        {
+            flushScheduled_ = true;
+            loop_->queueAfterEvents(std::bind(&TcpConnection::flushInLoop, shared_from_this()));
+        }
+    }
+    else if (pacedOutput())
+    {
+        if (!refillScheduled_ && !channel_.isWriting())
+        {
+            pacedWriteInLoop();
+        }
+    }
+    else if (!channel_.isWriting())
     {
-        socket_->shutdownWrite();       // 关闭写端
+        channel_.enableWriting();
     }
 }
 
+void TcpConnection::appendOutput(const void* data, size_t len)
+{
+    outputBuffer_.append(static_cast<const char*>(data), len);
+    if (!outputChunks_.empty() || notSentLowat_ > 0)
+    {
+        // 队列中有共享消息，记录这段数据的位置；低延迟模式下每次 send 单独一段，
+        // 以便 discardPendingOutput 按消息丢弃
+        if (outputChunks_.empty() || outputChunks_.back().payload || notSentLowat_ > 0)
+        {
+            OutputChunk chunk;
+            chunk.offset = 0;
+            chunk.len = len;
+            chunk.started = false;
+            outputChunks_.push_back(chunk);
+        }
+        else
+        {
+            outputChunks_.back().len += len;
+        }
+    }
+}
 
+void TcpConnection::appendOutput(const PayloadPtr& payload, size_t offset)
+{
+    if (outputChunks_.empty() && outputBuffer_.readableBytes() > 0)
+    {
+        // 第一次出现共享消息：缓冲区中已有的数据排在它前面
+        OutputChunk chunk;
+        chunk.offset = 0;
+        chunk.len = outputBuffer_.readableBytes();
+        chunk.started = true;
+        outputChunks_.push_back(chunk);
+    }
 
+    OutputChunk chunk;
+    chunk.payload = payload;
+    chunk.offset = offset;
+    chunk.len = payload->size();
+    chunk.started = offset > 0;
+    outputChunks_.push_back(std::move(chunk));
+    pendingPayloadBytes_ += payload->size() - offset;
+}
 
+ssize_t TcpConnection::writeOutput(int* savedErrno, size_t maxBytes)
+{
+    if (outputChunks_.empty())
+    {
+        ssize_t n;
+        if (maxBytes >= outputBuffer_.readableBytes())
+        {
+            n = outputBuffer_.writeFd(channel_.fd(), savedErrno);
+        }
+        else
+        {
+            n = ::write(channel_.fd(), outputBuffer_.peek(), maxBytes);
+            if (n < 0)
+            {
+                *savedErrno = errno;
+            }
+        }
+        if (n > 0)
+        {
+            outputBuffer_.retrieve(n);
+        }
+        return n;
+    }
+
+    // 按队列顺序组装 iovec，一次 writev 写出缓冲区数据和共享消息
+    static const int kMaxIov = 64;
+    struct iovec iov[kMaxIov];
+    int iovcnt = 0;
+    size_t bufferOffset = 0;
+    for (std::deque<OutputChunk>::const_iterator it = outputChunks_.begin();
+         it != outputChunks_.end() && iovcnt < kMaxIov && maxBytes > 0; ++it)
+    {
+        if (it->payload)
+        {
+            iov[iovcnt].iov_base = const_cast<char*>(it->payload->data()) + it->offset;
+            iov[iovcnt].iov_len = it->len - it->offset;
+        }
+        else
+        {
+            iov[iovcnt].iov_base = const_cast<char*>(outputBuffer_.peek()) + bufferOffset;
+            iov[iovcnt].iov_len = it->len;
+            bufferOffset += it->len;
+        }
+        if (iov[iovcnt].iov_len > maxBytes)
+        {
+            iov[iovcnt].iov_len = maxBytes;
+        }
+        maxBytes -= iov[iovcnt].iov_len;
+        ++iovcnt;
+    }
+
+    ssize_t n = ::writev(channel_.fd(), iov, iovcnt);
+    if (n < 0)
+    {
+        *savedErrno = errno;
+        return n;
+    }
+
+    // 移除已经写出的部分
+    size_t remaining = static_cast<size_t>(n);
+    while (remaining > 0 && !outputChunks_.empty())
+    {
+        OutputChunk& chunk = outputChunks_.front();
+        if (chunk.payload)
+        {
+            size_t left = chunk.len - chunk.offset;
+            size_t used = remaining < left ? remaining : left;
+            chunk.offset += used;
+            chunk.started = true;
+            pendingPayloadBytes_ -= used;
+            remaining -= used;
+            if (chunk.offset == chunk.len)
+            {
+                outputChunks_.pop_front();
+            }
+        }
+        else
+        {
+            size_t used = remaining < chunk.len ? remaining : chunk.len;
+            outputBuffer_.retrieve(used);
+            chunk.len -= used;
+            chunk.started = true;
+            remaining -= used;
+            if (chunk.len == 0)
+            {
+                outputChunks_.pop_front();
+            }
+        }
+    }
+    return n;
+}
+
+// 连接建立
+void TcpConnection::connectEstablished()
+{
+    setState(kConnected);
+    channel_.tie(shared_from_this());
+    updateReadingInLoop();      // 没有暂停读的原因则开始读
+
+    // 新连接建立，执行回调
+    if (callbacks_->connectionCallback)
+    {
+        callbacks_->connectionCallback(shared_from_this());
+    }
+}
+
+// 连接销毁
+void TcpConnection::connectDistroyed()
+{
+    if (state_ == kConnected)
+    {
+        setState(kDisconnected);
+        channel_.disableAll();
+        reading_ = false;
+        if (aboveHighWater_)
+        {
+            aboveHighWater_ = false;
+            notifyProducers(false);
+        }
+
+        if (callbacks_->connectionCallback)
+        {
+            callbacks_->connectionCallback(shared_from_this());
+        }
+    }
+    channel_.remove(); // 从 poller 中删除 channel
+
+    // 注销连接编号，之后业务线程再也查不到该连接
+    std::shared_ptr<ConnectionRegistry> registry = registry_.lock();
+    if (registry)
+    {
+        registry->remove(id_);
+    }
+}
+
+// 关闭连接
+void TcpConnection::shutdown()
+{
+    if (state_ == kConnected)
+    {
+        setState(kDisconnecting);
+        loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
+    }
+}
+
+void TcpConnection::shutdownInLoop()
+{
+    // outputBuffer 中数据全部发送完成（合并写的数据由 flushInLoop 写完后再关闭）
+    if (!channel_.isWriting() && pendingOutputBytes() == 0)
+    {
+        socket_.shutdownWrite();       // 关闭写端
+    }
+}
+
+void TcpConnection::setWriteCoalescing(bool on)
+{
+    writeCoalescing_ = on;
+    if (!on && pendingOutputBytes() > 0)
+    {
+        flushInLoop();
+    }
+}
+
+void TcpConnection::flush()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::flushInLoop, shared_from_this()));
+}
+
+// 把发送缓冲区中合并的数据写出一次，写不完的交给 handleWrite
+void TcpConnection::flushInLoop()
+{
+    flushScheduled_ = false;
+    if (state_ == kDisconnected || channel_.isWriting() || pendingOutputBytes() == 0)
+    {
+        return;
+    }
+    if (pacedOutput())
+    {
+        if (!refillScheduled_)
+        {
+            pacedWriteInLoop();
+        }
+        return;
+    }
+
+    int savedErrno = 0;
+    ssize_t n = writeOutput(&savedErrno);
+    if (n > 0)
+    {
+        unshapedBytes_.fetch_add(n, std::memory_order_relaxed);
+        checkLowWater();
+    }
+    else if (savedErrno != EWOULDBLOCK)
+    {
+        LOG_ERROR("TcpConnection::flushInLoop\n");
+        if (savedErrno == EPIPE || savedErrno == ECONNRESET)
+        {
+            return;     // 连接已断开，由 handleClose 处理
+        }
+    }
+
+    if (pendingOutputBytes() == 0)
+    {
+        if (callbacks_->writeCompleteCallback)
+        {
+            loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+        }
+        if (state_ == kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+    else
+    {
+        channel_.enableWriting();
+    }
+}
+
+bool TcpConnection::shaping() const
+{
+    return (rateLimiter_ && rateLimiter_->limited())
+        || (sharedRateLimiter_ && sharedRateLimiter_->limited());
+}
+
+void TcpConnection::setRateLimit(double bytesPerSecond, size_t burst)
+{
+    loop_->runInLoop(std::bind(&TcpConnection::setRateLimitInLoop, shared_from_this(), bytesPerSecond, burst));
+}
+
+void TcpConnection::setRateLimitInLoop(double bytesPerSecond, size_t burst)
+{
+    if (bytesPerSecond > 0)
+    {
+        if (!rateLimiter_)
+        {
+            rateLimiter_.reset(new TokenBucket);
+        }
+        rateLimiter_->setRate(bytesPerSecond, burst);
+    }
+    else
+    {
+        rateLimiter_.reset();
+    }
+
+    // 按新的速率继续写；取消限速后把积压的数据交回 EPOLLOUT
+    if (state_ != kDisconnected && pendingOutputBytes() > 0 && !refillScheduled_ && !channel_.isWriting())
+    {
+        pacedWriteInLoop();
+    }
+}
+
+void TcpConnection::pacedWriteInLoop()
+{
+    if (state_ == kDisconnected || pendingOutputBytes() == 0)
+    {
+        return;
+    }
+
+    // 低延迟发送：一次最多写 notSentLowat_ 字节，其余留在用户态
+    size_t wanted = pendingOutputBytes();
+    if (notSentLowat_ > 0 && wanted > notSentLowat_)
+    {
+        wanted = notSentLowat_;
+    }
+
+    // 先从连接自己的桶取，再从共享的桶取，多取的令牌还给连接的桶
+    const bool shaped = shaping();
+    int64_t now = Timestamp::monotonicMicros();
+    size_t allowed = wanted;
+    if (rateLimiter_)
+    {
+        allowed = rateLimiter_->take(allowed, now);
+    }
+    if (allowed > 0 && sharedRateLimiter_)
+    {
+        size_t granted = sharedRateLimiter_->take(allowed, now);
+        if (rateLimiter_)
+        {
+            rateLimiter_->refund(allowed - granted);
+        }
+        allowed = granted;
+    }
+
+    size_t nwrote = 0;
+    if (allowed > 0)
+    {
+        int savedErrno = 0;
+        ssize_t n = writeOutput(&savedErrno, allowed);
+        if (n > 0)
+        {
+            nwrote = static_cast<size_t>(n);
+        }
+        else if (n < 0 && savedErrno != EWOULDBLOCK)
+        {
+            LOG_ERROR("TcpConnection::pacedWriteInLoop\n");
+        }
+
+        // 内核没有接收的部分归还令牌
+        if (nwrote < allowed)
+        {
+            if (rateLimiter_)
+            {
+                rateLimiter_->refund(allowed - nwrote);
+            }
+            if (sharedRateLimiter_)
+            {
+                sharedRateLimiter_->refund(allowed - nwrote);
+            }
+        }
+        if (n < 0 && (savedErrno == EPIPE || savedErrno == ECONNRESET))
+        {
+            return;     // 连接已断开，由 handleClose 处理
+        }
+        if (nwrote > 0)
+        {
+            (shaped ? shapedBytes_ : unshapedBytes_).fetch_add(nwrote, std::memory_order_relaxed);
+            checkLowWater();
+        }
+    }
+
+    if (pendingOutputBytes() == 0)
+    {
+        if (channel_.isWriting())
+        {
+            channel_.disableWriting();
+        }
+        if (callbacks_->writeCompleteCallback)
+        {
+            loop_->queueInLoop(std::bind(callbacks_->writeCompleteCallback, shared_from_this()));
+        }
+        if (state_ == kDisconnecting)
+        {
+            shutdownInLoop();
+        }
+    }
+    else if ((allowed > 0 && nwrote < allowed) || allowed == wanted)
+    {
+        // 内核发送缓冲区满，或者低延迟模式写够了上限：等 EPOLLOUT
+        // （设置了 TCP_NOTSENT_LOWAT 时，内核未发送的数据低于上限才通知）
+        if (!channel_.isWriting())
+        {
+            channel_.enableWriting();
+        }
+    }
+    else
+    {
+        // 令牌用完：不关注 EPOLLOUT，等令牌补足一段数据后再写
+        if (channel_.isWriting())
+        {
+            channel_.disableWriting();
+        }
+        size_t want = pendingOutputBytes() < kShapingChunk ? pendingOutputBytes() : kShapingChunk;
+        int64_t wait = 0;
+        if (rateLimiter_)
+        {
+            wait = rateLimiter_->waitMicros(want, now);
+        }
+        if (sharedRateLimiter_)
+        {
+            wait = std::max(wait, sharedRateLimiter_->waitMicros(want, now));
+        }
+        wait = std::max(wait, kMinShapingWaitMicros);
+
+        refillScheduled_ = true;
+        TcpConnectionWeakPtr weakConn(shared_from_this());
+        loop_->runAfter(static_cast<double>(wait) / Timestamp::kMicroSecondsPerSecond, [weakConn]() {
+            TcpConnectionPtr conn = weakConn.lock();
+            if (conn)
+            {
+                conn->refillInLoop();
+            }
+        });
+    }
+}
+
+void TcpConnection::refillInLoop()
+{
+    refillScheduled_ = false;
+    if (!channel_.isWriting())
+    {
+        pacedWriteInLoop();
+    }
+}
+
+void TcpConnection::setLowLatencySend(size_t notSentLowat)
+{
+    loop_->runInLoop(std::bind(&TcpConnection::setLowLatencySendInLoop, shared_from_this(), notSentLowat));
+}
+
+void TcpConnection::setLowLatencySendInLoop(size_t notSentLowat)
+{
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+    if (!localAddr_.isUnix())
+    {
+        socket_.setNotSentLowat(static_cast<int>(notSentLowat));
+    }
+    if (notSentLowat > 0 && notSentLowat_ == 0 && outputChunks_.empty() && outputBuffer_.readableBytes() > 0)
+    {
+        // 已有的待发送数据可能写出了一部分，作为一段整体保留
+        OutputChunk chunk;
+        chunk.offset = 0;
+        chunk.len = outputBuffer_.readableBytes();
+        chunk.started = true;
+        outputChunks_.push_back(chunk);
+    }
+    notSentLowat_ = notSentLowat;
+}
+
+size_t TcpConnection::discardPendingOutput()
+{
+    if (outputChunks_.empty())
+    {
+        // 没有分段记录（未开启低延迟发送且没有共享消息）：分不清消息边界，不丢弃
+        return 0;
+    }
+
+    size_t keepBuffer = 0;      // 保留在 outputBuffer_ 中的字节数
+    size_t discarded = 0;
+    std::deque<OutputChunk>::iterator it = outputChunks_.begin();
+    if (it->started)
+    {
+        if (!it->payload)
+        {
+            keepBuffer = it->len;
+        }
+        ++it;
+    }
+    for (std::deque<OutputChunk>::iterator p = it; p != outputChunks_.end(); ++p)
+    {
+        if (p->payload)
+        {
+            pendingPayloadBytes_ -= p->len - p->offset;
+            discarded += p->len - p->offset;
+        }
+        else
+        {
+            discarded += p->len;
+        }
+    }
+    outputChunks_.erase(it, outputChunks_.end());
+    outputBuffer_.unwrite(outputBuffer_.readableBytes() - keepBuffer);
+
+    if (discarded > 0)
+    {
+        checkLowWater();
+        if (pendingOutputBytes() == 0)
+        {
+            if (channel_.isWriting())
+            {
+                channel_.disableWriting();
+            }
+            if (state_ == kDisconnecting)
+            {
+                shutdownInLoop();
+            }
+        }
+    }
+    return discarded;
+}
+
+void TcpConnection::forceClose()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        handleClose();      // 与对端关闭连接的处理相同
+    }
+}
+
+/********************************************************************************************
+ * 读控制与背压
+ *     暂停读取有多个原因：用户 stopRead、本连接发送积压、下游连接积压（计数），
+ * 任意一个原因存在时 channel 都不关注读事件，全部解除后才恢复读取。
+**********************************************************************************************/
+void TcpConnection::startRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::resumeReadInLoop, shared_from_this(), kPauseByUser));
+}
+
+void TcpConnection::stopRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::pauseReadInLoop, shared_from_this(), kPauseByUser));
+}
+
+void TcpConnection::pauseReadInLoop(int reason)
+{
+    readPauseMask_ |= reason;
+    updateReadingInLoop();
+}
+
+void TcpConnection::resumeReadInLoop(int reason)
+{
+    readPauseMask_ &= ~reason;
+    updateReadingInLoop();
+}
+
+void TcpConnection::consumerPauseInLoop(bool pause)
+{
+    if (pause)
+    {
+        ++consumerPauseCount_;
+    }
+    else if (consumerPauseCount_ > 0)
+    {
+        --consumerPauseCount_;
+    }
+    updateReadingInLoop();
+}
+
+void TcpConnection::updateReadingInLoop()
+{
+    if (state_ != kConnected && state_ != kDisconnecting)
+    {
+        return;
+    }
+
+    bool wantRead = readPauseMask_ == 0 && consumerPauseCount_ == 0;
+    if (wantRead && !reading_)
+    {
+        channel_.enableReading();
+        reading_ = true;
+    }
+    else if (!wantRead && reading_)
+    {
+        channel_.disableReading();
+        reading_ = false;
+    }
+}
+
+void TcpConnection::setWaterMarks(size_t highWaterMark, size_t lowWaterMark, bool pauseSelf)
+{
+    highWaterMark_ = highWaterMark;
+    lowWaterMark_ = lowWaterMark < highWaterMark ? lowWaterMark : highWaterMark / 2;
+    backpressure_ = highWaterMark > 0;
+    pauseSelfOnHighWater_ = pauseSelf;
+}
+
+void TcpConnection::addProducer(const TcpConnectionPtr& producer)
+{
+    producers_.push_back(producer);
+    if (aboveHighWater_)        // 已经积压，新加入的上游也要暂停
+    {
+        producer->getLoop()->runInLoop(
+            std::bind(&TcpConnection::consumerPauseInLoop, producer, true));
+    }
+}
+
+// 待发送数据增加后调用，oldLen 为增加前的长度
+void TcpConnection::checkHighWater(size_t oldLen)
+{
+    size_t newLen = pendingOutputBytes();
+    if (highWaterMark_ == 0 || oldLen >= highWaterMark_ || newLen < highWaterMark_)
+    {
+        return;     // 没有向上越过高水位
+    }
+
+    if (callbacks_->highWaterMarkCallback)
+    {
+        loop_->queueInLoop(
+            std::bind(callbacks_->highWaterMarkCallback, shared_from_this(), newLen)
+        );
+    }
+
+    if (backpressure_ && !aboveHighWater_)
+    {
+        aboveHighWater_ = true;
+        ++highWaterEpoch_;
+        if (pauseSelfOnHighWater_)
+        {
+            pauseReadInLoop(kPauseByHighWater);
+        }
+        notifyProducers(true);
+
+        if (slowConsumerTimeout_ > 0)
+        {
+            TcpConnectionWeakPtr weakConn(shared_from_this());
+            uint64_t epoch = highWaterEpoch_;
+            loop_->runAfter(slowConsumerTimeout_, [weakConn, epoch]() {
+                TcpConnectionPtr conn = weakConn.lock();
+                if (conn)
+                {
+                    conn->checkSlowConsumer(epoch);
+                }
+            });
+        }
+    }
+}
+
+// 待发送数据减少后调用
+void TcpConnection::checkLowWater()
+{
+    if (aboveHighWater_ && pendingOutputBytes() <= lowWaterMark_)
+    {
+        aboveHighWater_ = false;
+        resumeReadInLoop(kPauseByHighWater);
+        notifyProducers(false);
+    }
+}
+
+void TcpConnection::notifyProducers(bool pause)
+{
+    for (size_t i = 0; i < producers_.size(); )
+    {
+        TcpConnectionPtr producer = producers_[i].lock();
+        if (producer)
+        {
+            producer->getLoop()->runInLoop(
+                std::bind(&TcpConnection::consumerPauseInLoop, producer, pause));
+            ++i;
+        }
+        else        // 上游已经销毁
+        {
+            producers_[i] = producers_.back();
+            producers_.pop_back();
+        }
+    }
+}
+
+// 越过高水位 slowConsumerTimeout_ 秒后检查：期间一直没有降到低水位，则关闭连接
+void TcpConnection::checkSlowConsumer(uint64_t epoch)
+{
+    if (aboveHighWater_ && epoch == highWaterEpoch_)
+    {
+        LOG_ERROR("TcpConnection::checkSlowConsumer [%s] %lu bytes pending for %.1f s, force close\n",
+            name().c_str(), pendingOutputBytes(), slowConsumerTimeout_);
+        forceClose();
+    }
+}
+
+void TcpConnection::setMemoryGovernor(const std::shared_ptr<MemoryGovernor>& governor)
+{
+    memoryGovernor_ = governor;
+    memoryCounter_.parent = governor ? governor->counter() : nullptr;
+    inputBuffer_.setMemoryCounter(&memoryCounter_);
+    outputBuffer_.setMemoryCounter(&memoryCounter_);
+}
+
+void TcpConnection::shrinkBuffers()
+{
+    if (inputBuffer_.readableBytes() == 0)
+    {
+        inputBuffer_.shrink(0);
+    }
+    if (outputBuffer_.readableBytes() == 0)
+    {
+        outputBuffer_.shrink(0);
+    }
+}
+
+ComputeOrder* TcpConnection::computeOrder()
+{
+    if (!computeOrder_)
+    {
+        computeOrder_.reset(new ComputeOrder);
+    }
+    return computeOrder_.get();
+}
+
+void TcpConnection::setMemoryPressure(bool paused)
+{
+    if (paused)
+    {
+        loop_->runInLoop(std::bind(&TcpConnection::pauseReadInLoop, shared_from_this(), kPauseByMemory));
+    }
+    else
+    {
+        loop_->runInLoop(std::bind(&TcpConnection::resumeReadInLoop, shared_from_this(), kPauseByMemory));
+    }
+}
+
+/********************************************************************************************
+ * 转发
+ *     splice：每个方向的状态（管道、管道中的字节数、是否读到 EOF）保存在源连接上。
+ * 源连接可读时 socket -> 管道，随即尝试 管道 -> 对端 socket；写不完时暂停读取源连接、
+ * 关注对端的可写事件，对端可写时继续写，管道清空后恢复读取。对端的发送队列中还有
+ * 转发开始前积压的数据时先写发送队列。
+ *     缓冲转发：与应用自己在 messageCallback 中 send 相同，用水位线暂停对方的读取。
+**********************************************************************************************/
+// 每次从 socket 读入管道的最大字节数
+static const size_t kSpliceChunk = PipePool::kPipeSize;
+static const int kSpliceRounds = 8;
+// 缓冲转发时对端发送队列的高低水位
+static const size_t kRelayHighWaterMark = 1024 * 1024;
+static const size_t kRelayLowWaterMark = 256 * 1024;
+
+void TcpConnection::relay(const TcpConnectionPtr& a, const TcpConnectionPtr& b)
+{
+    if (a->getLoop() == b->getLoop())
+    {
+        a->getLoop()->runInLoop([a, b]() {
+            if (a->pacedOutput() || b->pacedOutput())
+            {
+                // 限速 / 低延迟发送要经过发送队列，不能直接 splice
+                a->startBufferedRelayInLoop(b);
+                b->startBufferedRelayInLoop(a);
+                return;
+            }
+            // 两个方向都拿到管道才 splice，一边 splice 一边缓冲时双方的暂停 / 恢复对不上
+            PipePool& pipes = PipePool::current();
+            int pipeA[2];
+            int pipeB[2];
+            if (!pipes.acquire(pipeA))
+            {
+                a->startBufferedRelayInLoop(b);
+                b->startBufferedRelayInLoop(a);
+                return;
+            }
+            if (!pipes.acquire(pipeB))
+            {
+                pipes.release(pipeA, true);
+                a->startBufferedRelayInLoop(b);
+                b->startBufferedRelayInLoop(a);
+                return;
+            }
+            a->startSpliceInLoop(b, pipeA);
+            b->startSpliceInLoop(a, pipeB);
+        });
+    }
+    else
+    {
+        a->getLoop()->runInLoop(std::bind(&TcpConnection::startBufferedRelayInLoop, a, b));
+        b->getLoop()->runInLoop(std::bind(&TcpConnection::startBufferedRelayInLoop, b, a));
+    }
+}
+
+void TcpConnection::startSpliceInLoop(const TcpConnectionPtr& peer, int pipe[2])
+{
+    if (state_ != kConnected)
+    {
+        PipePool::current().release(pipe, true);
+        peer->forceClose();
+        return;
+    }
+
+    relayPipe_[0] = pipe[0];
+    relayPipe_[1] = pipe[1];
+    relayPeer_ = peer;
+    relaySplice_ = true;
+    relayReadEof_ = false;
+    relayPipeBytes_ = 0;
+    // 每次可读事件只 splice 一次，依赖水平触发再次通知
+    channel_.setEdgeTriggered(false);
+    if (inputBuffer_.readableBytes() > 0)
+    {
+        relayedBytes_.fetch_add(inputBuffer_.readableBytes(), std::memory_order_relaxed);
+        peer->send(&inputBuffer_);
+    }
+    updateReadingInLoop();
+}
+
+void TcpConnection::startBufferedRelayInLoop(const TcpConnectionPtr& peer)
+{
+    if (state_ != kConnected)
+    {
+        peer->shutdown();
+        return;
+    }
+
+    relayPeer_ = peer;
+    relaySplice_ = false;
+    TcpConnectionWeakPtr weakPeer(peer);
+    ownCallbacks().messageCallback = [weakPeer](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        TcpConnectionPtr target = weakPeer.lock();
+        if (target)
+        {
+            conn->relayedBytes_.fetch_add(buf->readableBytes(), std::memory_order_relaxed);
+            target->send(buf);
+        }
+        else
+        {
+            buf->retrieveAll();
+        }
+    };
+    // 本连接是对端数据的消费者：发送队列积压时暂停对端的读取
+    setWaterMarks(kRelayHighWaterMark, kRelayLowWaterMark, false);
+    addProducer(peer);
+    if (inputBuffer_.readableBytes() > 0)
+    {
+        relayedBytes_.fetch_add(inputBuffer_.readableBytes(), std::memory_order_relaxed);
+        peer->send(&inputBuffer_);
+    }
+}
+
+void TcpConnection::spliceReadInLoop()
+{
+    TcpConnectionPtr peer = relayPeer_.lock();
+    if (!peer)
+    {
+        handleClose();
+        return;
+    }
+    if (peer->disconnected())       // 对端已关闭，本连接的关闭已经排在队列中
+    {
+        pauseReadInLoop(kPauseByRelay);
+        return;
+    }
+
+    // 管道每次都能清空时连续读，最多 kSpliceRounds 次，不让一个连接长时间占用 loop
+    ssize_t n = 0;
+    for (int round = 0; round < kSpliceRounds; ++round)
+    {
+        n = ::splice(channel_.fd(), nullptr, relayPipe_[1], nullptr, kSpliceChunk,
+                     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n <= 0)
+        {
+            break;
+        }
+        relayPipeBytes_ += n;
+        lastActiveMicros_.store(loop_->nowMonotonic(), std::memory_order_relaxed);
+        spliceOutInLoop();
+        if (relayPipeBytes_ > 0 || !relaySplice_ || peer->disconnected())
+        {
+            return;
+        }
+    }
+
+    if (n > 0)
+    {
+        return;
+    }
+    else if (n == 0)        // 对端不再发送：停止读取，管道中的数据写完后半关闭另一端
+    {
+        relayReadEof_ = true;
+        pauseReadInLoop(kPauseByRelay);
+        if (relayPipeBytes_ == 0)
+        {
+            peer->shutdown();
+            checkRelayFinished(peer);
+        }
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        LOG_ERROR("TcpConnection::spliceReadInLoop [%s] errno %d\n", name().c_str(), errno);
+        handleClose();
+    }
+}
+
+void TcpConnection::spliceOutInLoop()
+{
+    TcpConnectionPtr peer = relayPeer_.lock();
+    if (!peer || peer->disconnected())
+    {
+        return;
+    }
+
+    if (peer->pendingOutputBytes() == 0)
+    {
+        while (relayPipeBytes_ > 0)
+        {
+            ssize_t n = ::splice(relayPipe_[0], nullptr, peer->channel_.fd(), nullptr, relayPipeBytes_,
+                                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0)
+            {
+                relayPipeBytes_ -= n;
+                relayedBytes_.fetch_add(n, std::memory_order_relaxed);
+                peer->unshapedBytes_.fetch_add(n, std::memory_order_relaxed);
+            }
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            else
+            {
+                LOG_ERROR("TcpConnection::spliceOutInLoop [%s] errno %d\n", peer->name().c_str(), errno);
+                peer->handleClose();
+                return;
+            }
+        }
+    }
+
+    if (relayPipeBytes_ > 0)
+    {
+        // 对端写不进去：暂停读取本连接，等对端可写
+        pauseReadInLoop(kPauseByRelay);
+        if (!peer->channel_.isWriting())
+        {
+            peer->channel_.enableWriting();
+        }
+        return;
+    }
+
+    if (peer->channel_.isWriting() && peer->pendingOutputBytes() == 0)
+    {
+        peer->channel_.disableWriting();
+    }
+    if (relayReadEof_)
+    {
+        peer->shutdown();
+        checkRelayFinished(peer);
+    }
+    else
+    {
+        resumeReadInLoop(kPauseByRelay);
+    }
+}
+
+// 两个方向都读到 EOF 并写完：关闭两个连接
+void TcpConnection::checkRelayFinished(const TcpConnectionPtr& peer)
+{
+    if (relayReadEof_ && relayPipeBytes_ == 0 && peer->relayReadEof_ && peer->relayPipeBytes_ == 0)
+    {
+        forceClose();
+        peer->forceClose();
+    }
+}
+
+// 连接关闭时结束转发：归还管道，关闭对端
+void TcpConnection::stopRelayInLoop()
+{
+    TcpConnectionPtr peer = relayPeer_.lock();
+    relayPeer_.reset();
+    if (relaySplice_)
+    {
+        relaySplice_ = false;
+        PipePool::current().release(relayPipe_, relayPipeBytes_ == 0);
+        relayPipeBytes_ = 0;
+        if (peer)
+        {
+            peer->forceClose();
+        }
+    }
+    else if (peer)
+    {
+        peer->shutdown();       // 缓冲转发：对端发送完积压的数据再关闭
+    }
+}
@@ -5,38 +5,79 @@
 #include "Callbacks.h"
 #include "Buffer.h"
 #include "Timestamp.h"
+#include "Socket.h"
+#include "Channel.h"
+#include "Payload.h"
+#include "SocketOptions.h"
 
 #include <memory>
 #include <string>
 #include <atomic>
+#include <vector>
+#include <deque>
+
+#include <initializer_list>
+#include <sys/uio.h>
 
-class Channel;
 class EventLoop;
-class Socket;
+class ConnectionRegistry;
+class MemoryGovernor;
+class TokenBucket;
+struct ComputeOrder;
+
+// 一段待发送的数据，不持有内存，只在 sendv 调用期间有效
+struct Slice
+{
+    Slice(const void* d, size_t n) : data(d), len(n) {}
+    Slice(const std::string& s) : data(s.data()), len(s.size()) {}
 
+    const void* data;
+    size_t len;
+};
+
+/**************************************************************************************
+ * TcpConnection：一个已建立的连接
+ *     Socket、Channel 直接内嵌在对象中，回调由同一个 TcpServer 的所有连接共享
+ * （ConnectionCallbacks），连接名在需要时由前缀和连接编号拼接。TcpServer 通过
+ * std::allocate_shared 在所属 loop 的内存池中创建连接，对象和控制块一次分配。
+**************************************************************************************/
 class TcpConnection : noncopyable, public std::enable_shared_from_this<TcpConnection>
 {
 public:
     TcpConnection(EventLoop* loop,
-                const std::string name,
                 int sockfd,
                 const InetAddress& localAddr,
-                const InetAddress& peerAddr);
+                const InetAddress& peerAddr,
+                ConnectionId id,
+                const ConnectionCallbacksPtr& callbacks = ConnectionCallbacksPtr());
     ~TcpConnection();
 
     EventLoop* getLoop() const {    return loop_;   }
-    const std::string name() const {    return name_;   }
+    const std::string name() const {    return callbacks_->namePrefix + std::to_string(id_);    }
+    ConnectionId id() const {   return id_; }
     const InetAddress& localAddr() const {  return localAddr_;  }
     const InetAddress& peerAddr() const {   return peerAddr_;   }
     bool connected() const {    return state_ == kConnected;    }
     bool disconnected() const { return state_ == kDisconnected; }
 
-    // 设置回调函数
-    void setConnectionCallback(const ConnectionCallback& cb){   connectionCallback_ = cb;   }
-    void setMessageCallback(const MessageCallback& cb)      {   messageCallback_ = cb;      }
-    void setWriteCompleteCallback(const WriteCompleteCallback& cb){ writeCompleteCallback_ = cb;    }
-    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb){ highWaterMarkCallback_ = cb;    }
-    void setCloseCallback(const CloseCallback& cb)          {   closeCallback_ = cb;        }
+    // 设置回调函数：只修改本连接，共享的回调集合先拷贝一份（写时复制）
+    void setConnectionCallback(const ConnectionCallback& cb){   ownCallbacks().connectionCallback = cb;     }
+    void setMessageCallback(const MessageCallback& cb)      {   ownCallbacks().messageCallback = cb;        }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb){ ownCallbacks().writeCompleteCallback = cb;  }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb){ ownCallbacks().highWaterMarkCallback = cb;  }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+    {
+        ownCallbacks().highWaterMarkCallback = cb;
+        highWaterMark_ = highWaterMark;
+    }
+    void setCloseCallback(const CloseCallback& cb)          {   ownCallbacks().closeCallback = cb;          }
+
+    // 连接上的应用层状态（如 HTTP 解析器），只在 loop 线程中访问
+    void setContext(const std::shared_ptr<void>& context) { context_ = context; }
+    const std::shared_ptr<void>& getContext() const {  return context_; }
+
+    // 连接销毁时从注册表中注销
+    void setRegistry(const std::shared_ptr<ConnectionRegistry>& registry) { registry_ = registry; }
 
     // 建立 / 销毁连接
     void connectEstablished();
@@ -46,8 +87,134 @@ public:
     void shutdown();
     void shutdownInLoop();
 
+    // 强制关闭连接，不等待发送缓冲区中的数据发送完成
+    void forceClose();
+
     // 发送数据
     void send(const std::string& buf);
+
+    /**
+     * 分散发送：多段数据（如 头部 + 缓存的正文 + 结尾）不必先拼接。
+     *   loop 线程中先尝试一次 writev，内核没有接收的部分才拷贝进发送缓冲区；
+     * 其他线程调用时拷贝为一段数据再转到 loop 线程。顺序和 WriteCompleteCallback
+     * 与 send 相同。
+     */
+    void sendv(const struct iovec* iov, int iovcnt);
+    void sendv(std::initializer_list<Slice> slices);
+    void sendv(const std::vector<Slice>& slices);
+
+    // 发送共享消息：只增加引用计数，不拷贝数据，任意线程可调用
+    void send(const PayloadPtr& payload);
+    // 发送 buf 中的全部可读数据并清空 buf；loop 线程中不经过 std::string 中转
+    void send(Buffer* buf);
+    // buf 中的数据（如响应头部）后接共享正文（如 mmap 的文件），发送队列为空时一次 writev 写出
+    void send(Buffer* buf, const PayloadPtr& payload);
+
+    /**
+     * 合并写：开启后 send 只把数据追加到发送缓冲区，本轮事件循环结束时
+     * （EventLoop::queueAfterEvents）每个有数据的连接只写一次。
+     * 适合一个请求产生多次 send、或流水线请求的场景。在 loop 线程中设置。
+     */
+    void setWriteCoalescing(bool on);
+    bool writeCoalescing() const {  return writeCoalescing_;    }
+    // 立即写出已合并的数据，任意线程可调用
+    void flush();
+
+    /**
+     * 读取预算：每轮事件循环本连接最多读取 maxBytes 字节、调用 maxReads 次
+     * messageCallback（0 表示不限制），用完后剩余数据留在内核中，下一轮再读，
+     * 避免一个大量发送的连接长时间占用 loop。在 loop 线程中设置。
+     *   设置了预算或边沿触发时，每次读事件循环读取直到 EAGAIN 或用完预算；
+     * 边沿触发的连接用完预算后通过 EventLoop::queueReady 排到下一轮继续读。
+     */
+    void setReadBudget(size_t maxBytes, int maxReads = 0);
+    // 边沿触发，建立连接前或在 loop 线程中设置
+    void setEdgeTriggered(bool on) {    channel_.setEdgeTriggered(on);  }
+
+    /**
+     * 发送限速（令牌桶）：每秒最多写出 bytesPerSecond 字节，0 取消限速，任意线程可调用，
+     * 可随时修改。所有写出路径（send / sendv / 共享消息 / EPOLLOUT）都按令牌数写，
+     * 令牌不足时数据留在发送队列中，由 loop 定时器在令牌补足后继续写。
+     */
+    void setRateLimit(double bytesPerSecond, size_t burst = 0);
+    // 与其他连接共享的令牌桶（TcpServer 整体限速），建立连接前设置
+    void setSharedRateLimiter(const std::shared_ptr<TokenBucket>& limiter) {    sharedRateLimiter_ = limiter;   }
+    // 限速期间 / 不限速时写出的字节数，任意线程可读
+    uint64_t shapedBytes() const {  return shapedBytes_.load(std::memory_order_relaxed);    }
+    uint64_t unshapedBytes() const {    return unshapedBytes_.load(std::memory_order_relaxed);  }
+
+    /**
+     * 低延迟发送：设置 TCP_NOTSENT_LOWAT，每次最多向内核写 notSentLowat 字节，其余数据
+     * 留在用户态发送队列中，内核未发送的数据低于该值（EPOLLOUT）时再写，新消息不必排在
+     * 内核中大量旧数据之后。队列中还没开始发送的消息可以用 discardPendingOutput 丢弃。
+     * 0 关闭，任意线程可调用。
+     */
+    void setLowLatencySend(size_t notSentLowat);
+    size_t notSentLowat() const {   return notSentLowat_;   }
+    // 在 loop 线程中调用：丢弃发送队列中还没开始发送的数据（低延迟模式下按 send 的消息
+    // 为单位，已经写出一部分的消息保留），返回丢弃的字节数
+    size_t discardPendingOutput();
+
+    /**
+     * 转发：把 a、b 两个连接配对，之后一端收到的数据直接写往另一端，不再回调
+     * messageCallback（配对前已读入 inputBuffer 的数据先转发），任意线程可调用。
+     *   同一个 loop 的两个连接用 splice(2) 经过管道（来自 loop 线程的 PipePool）在内核中
+     * 转发，不经过用户态缓冲区；对端写不进去时数据留在管道里，暂停读取源连接直到管道
+     * 清空（背压）。一端读到 EOF 时，管道中的数据写完后半关闭另一端的写，两个方向都
+     * 结束后关闭两个连接；任意一端出错或被关闭时关闭另一端。
+     *   两个连接在不同 loop 上（或任意一端限速 / 低延迟发送、取不到两个管道）时两个方向
+     * 都回退到缓冲转发：
+     * messageCallback 把数据 send 给对端，用水位线和 addProducer 做背压，一端关闭后
+     * 另一端发送完积压的数据再关闭。转发期间不要再调用 send。
+     */
+    static void relay(const TcpConnectionPtr& a, const TcpConnectionPtr& b);
+    // 从本连接读出、转发给对端的字节数，任意线程可读
+    uint64_t relayedBytes() const { return relayedBytes_.load(std::memory_order_relaxed);   }
+
+    // 已连接 socket 的选项（NODELAY、保活、缓冲区、QUICKACK），建立连接前或在 loop 线程中设置
+    void setSocketOptions(const SocketOptions& options);
+    void setTcpNoDelay(bool on)
+    {
+        if (!localAddr_.isUnix())
+        {
+            socket_.setTcpNoDelay(on);
+        }
+    }
+
+    // 读控制：暂停 / 恢复从 socket 读取数据，任意线程可调用
+    void startRead();
+    void stopRead();
+    bool isReading() const {    return reading_;    }
+
+    /**
+     * 背压：在 loop 线程中设置（通常在建立连接时）
+     *   待发送数据 >= highWaterMark 时暂停读取：pauseSelf 为 true 暂停本连接，
+     *   同时暂停通过 addProducer 关联的连接；降到 lowWaterMark 以下后恢复读取。
+     *   不调用本函数时，高水位只触发 HighWaterMarkCallback。
+     */
+    void setWaterMarks(size_t highWaterMark, size_t lowWaterMark, bool pauseSelf = true);
+    void setHighWaterMark(size_t highWaterMark) {   highWaterMark_ = highWaterMark; }
+    // producer 的数据写入本连接（如代理的上游），本连接积压时暂停 producer 的读取
+    void addProducer(const TcpConnectionPtr& producer);
+    // 待发送数据持续超过高水位 seconds 秒，视为慢消费者，强制关闭连接；0 表示不检查
+    void setSlowConsumerTimeout(double seconds) {   slowConsumerTimeout_ = seconds; }
+
+    // 内存统计：输入输出缓冲区的容量累加到 governor 的计数器上，建立连接前设置
+    void setMemoryGovernor(const std::shared_ptr<MemoryGovernor>& governor);
+    int64_t memoryUsage() const {   return memoryCounter_.get();    }
+    // 最后一次读到数据的时间（单调时钟微秒），任意线程可读，用于过载时挑选空闲连接
+    int64_t lastActiveMicros() const {  return lastActiveMicros_.load(std::memory_order_relaxed);  }
+    // 在 loop 线程中调用：释放空缓冲区占用的内存
+    void shrinkBuffers();
+    // 任意线程：内存紧张时暂停 / 恢复读取
+    void setMemoryPressure(bool paused);
+
+    size_t highWaterMark() const {  return highWaterMark_;  }
+    size_t lowWaterMark() const {   return lowWaterMark_;   }
+    size_t pendingOutputBytes() const { return outputBuffer_.readableBytes() + pendingPayloadBytes_; }
+
+    // ComputePool 有序提交的任务顺序，第一次使用时创建，只在 loop 线程中访问
+    ComputeOrder* computeOrder();
 private:
     enum StateE{
         kDisconnected,
@@ -57,35 +224,147 @@ private:
     };
     void setState(StateE state){    state_ = state; }
 
+    // 暂停读取的原因，任意一个原因存在都不读
+    enum ReadPauseReason
+    {
+        kPauseByUser = 1,           // stopRead
+        kPauseByHighWater = 2,      // 本连接发送积压
+        kPauseByMemory = 4,         // 服务器内存紧张
+        kPauseByRelay = 8,          // splice 转发：管道中的数据还没写往对端，或已读到 EOF
+    };
+    void pauseReadInLoop(int reason);
+    void resumeReadInLoop(int reason);
+    void consumerPauseInLoop(bool pause);     // 下游连接积压 / 恢复
+    void updateReadingInLoop();
+
+    // 待发送数据变化后检查高低水位
+    void checkHighWater(size_t oldLen);
+    void checkLowWater();
+    void notifyProducers(bool pause);
+    void checkSlowConsumer(uint64_t epoch);
+
+    void forceCloseInLoop();
+    void flushInLoop();
+
+    // 限速：连接自己或共享的令牌桶有速率限制
+    bool shaping() const;
+    void setRateLimitInLoop(double bytesPerSecond, size_t burst);
+    // 限速或低延迟发送时，写出由 pacedWriteInLoop 控制
+    bool pacedOutput() const {  return notSentLowat_ > 0 || shaping();  }
+    // 按令牌数和低延迟模式的单次上限写出待发送数据，令牌用完时登记补充定时器，
+    // 内核缓冲区满或未发送数据达到上限时关注 EPOLLOUT
+    void pacedWriteInLoop();
+    void refillInLoop();
+    void setLowLatencySendInLoop(size_t notSentLowat);
+
+    // 转发：splice 方向的状态保存在源连接上（relayPipe_ 中是本连接读出、待写往对端的数据）
+    void startSpliceInLoop(const TcpConnectionPtr& peer, int pipe[2]);     // pipe 由 relay 取得，交给本连接
+    void startBufferedRelayInLoop(const TcpConnectionPtr& peer);
+    void spliceReadInLoop();        // 本连接 socket -> 管道，再尝试写往对端
+    void spliceOutInLoop();         // 管道 -> 对端 socket
+    void checkRelayFinished(const TcpConnectionPtr& peer);
+    void stopRelayInLoop();
+
+
+    ConnectionCallbacks& ownCallbacks();
 
     void handleRead(Timestamp receiveTime);
+    void handleReadReady();         // 上一轮用完预算后继续读取
     void handleWrite();
     void handleClose();
     void handleError();
     
+    void sendInLoop(const std::string& message);     // 跨线程发送，message 为拷贝
     void sendInLoop(const void* data, size_t len);
+    void sendSlices(const Slice* slices, size_t count);
+    void sendvInLoop(const struct iovec* iov, int iovcnt);
+    void sendPayloadInLoop(const PayloadPtr& payload);
+    void sendInLoop(const std::string& message, const PayloadPtr& payload);
+    void sendInLoop(const void* data, size_t len, const PayloadPtr& payload);
+    void scheduleOutput();
+
+    // 追加到发送队列末尾（保持与 outputChunks_ 中共享消息的顺序）
+    void appendOutput(const void* data, size_t len);
+    void appendOutput(const PayloadPtr& payload, size_t offset);
+    // 写出最多 maxBytes 字节待发送数据并移除已写出的部分，返回写出的字节数
+    ssize_t writeOutput(int* savedErrno, size_t maxBytes = SIZE_MAX);
 
     EventLoop* loop_;
-    const std::string name_;
+    const ConnectionId id_;
 
     std::atomic_int state_;
-    bool reading_;
+    bool reading_;                  // channel 当前是否关注读事件
+    bool writeCoalescing_;
+    bool flushScheduled_;           // 已经登记了本轮结束时的 flush
+    int readPauseMask_;             // ReadPauseReason 的组合
+    int consumerPauseCount_;        // 处于积压状态的下游连接个数
+
+    size_t readBudgetBytes_;        // 每轮最多读取的字节数，0 表示不限制
+    int readBudgetReads_;           // 每轮最多调用 messageCallback 的次数，0 表示不限制
+    uint64_t budgetIteration_;      // 以下用量所属的 loop 轮次
+    size_t budgetBytesUsed_;
+    int budgetReadsUsed_;
+    bool readyQueued_;              // 已经登记到 loop 的下一轮
+
+    std::unique_ptr<TokenBucket> rateLimiter_;      // 本连接的限速，loop 线程访问
+    std::shared_ptr<TokenBucket> sharedRateLimiter_;
+    bool refillScheduled_;          // 已经登记了令牌补充定时器
+    size_t notSentLowat_;           // 低延迟发送的单次写出上限，0 表示关闭
+    bool quickAck_;                 // 每次读取后重新设置 TCP_QUICKACK
+    std::atomic<int64_t> lastActiveMicros_;
+    std::atomic<uint64_t> shapedBytes_;
+    std::atomic<uint64_t> unshapedBytes_;
 
     // 与 Acceptor 类似
-    std::unique_ptr<Socket> socket_;
-    std::unique_ptr<Channel> channel_;
+    Socket socket_;
+    Channel channel_;
 
     const InetAddress localAddr_;
     const InetAddress peerAddr_;
 
-    ConnectionCallback connectionCallback_;      // 新连接回调
-    MessageCallback messageCallback_;           // 读写消息回调
-    WriteCompleteCallback writeCompleteCallback_;   // 消息发送完成的回调
-    HighWaterMarkCallback highWaterMarkCallback_;
-    CloseCallback closeCallback_;
+    // 新连接 / 读写消息 / 发送完成 / 高水位 / 关闭回调
+    ConnectionCallbacksPtr callbacks_;
+
+    std::weak_ptr<ConnectionRegistry> registry_;
+    std::shared_ptr<void> context_;
 
     size_t highWaterMark_;       // 水位线
+    size_t lowWaterMark_;
+    bool backpressure_;             // setWaterMarks 后开启
+    bool pauseSelfOnHighWater_;
+    bool aboveHighWater_;           // 当前处于高水位之上
+    uint64_t highWaterEpoch_;       // 每次越过高水位加一，用于判断慢消费者定时器是否过期
+    double slowConsumerTimeout_;
+    std::vector<TcpConnectionWeakPtr> producers_;
+
+    TcpConnectionWeakPtr relayPeer_;    // 转发的对端，为空表示没有转发
+    bool relaySplice_;
+    bool relayReadEof_;             // splice 转发：本连接已读到 EOF
+    int relayPipe_[2];
+    size_t relayPipeBytes_;         // 管道中待写往对端的字节数
+    std::atomic<uint64_t> relayedBytes_;
     
+    // 声明在 Buffer 之前：Buffer 析构时还要更新计数器
+    std::shared_ptr<MemoryGovernor> memoryGovernor_;
+    MemoryCounter memoryCounter_;   // 本连接的缓冲区内存，上级为 governor 的计数器
+
     Buffer inputBuffer_;        // 接受数据
     Buffer outputBuffer_;       // 发送数据
+
+    /**
+     * 发送队列：没有共享消息时为空，待发送数据全部在 outputBuffer_ 中。
+     * 有共享消息时按顺序记录每一段：payload 非空为共享消息（从 offset 开始），
+     * payload 为空表示 outputBuffer_ 中接下来的 len 字节。
+     */
+    struct OutputChunk
+    {
+        PayloadPtr payload;
+        size_t offset;
+        size_t len;
+        bool started;           // 已经写出一部分，不能再丢弃
+    };
+    std::deque<OutputChunk> outputChunks_;
+    size_t pendingPayloadBytes_;
+
+    std::unique_ptr<ComputeOrder> computeOrder_;
 };
\ No newline at end of file
@@ -4,10 +4,16 @@
 #include "TcpConnection.h"
 #include "InetAddress.h"
 #include "Callbacks.h"
+#include "ConnectionRegistry.h"
+#include "FixedSizePool.h"
+#include "MemoryGovernor.h"
+#include "TokenBucket.h"
 
 #include <functional>
 #include <strings.h>
 #include <string>
+#include <algorithm>
+#include <unistd.h>
 
 static EventLoop* checkLoopNotNULL(EventLoop* loop)
 {
@@ -27,19 +33,60 @@ TcpServer::TcpServer(EventLoop* loop,
                       name_(nameArg),
                       acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
                       threadPool_(new EventLoopThreadPool(loop, name_)),
-                      connectionCallback_(),
-                      messageCallback_(),
+                      callbacks_(std::make_shared<ConnectionCallbacks>()),
                       nextConnId_(1),
-                      started_(0)
+                      started_(0),
+                      highWaterMark_(64*1024*1024),
+                      lowWaterMark_(0),
+                      backpressure_(false),
+                      pauseSelfOnHighWater_(false),
+                      slowConsumerTimeout_(0),
+                      writeCoalescing_(false),
+                      readBudgetBytes_(0),
+                      readBudgetReads_(0),
+                      edgeTriggered_(false),
+                      rateLimiter_(std::make_shared<TokenBucket>()),
+                      connectionRate_(0),
+                      connectionBurst_(0),
+                      notSentLowat_(0),
+                      lastMemoryLevel_(MemoryGovernor::kNormal),
+                      memoryTicks_(0),
+                      rejectedConnections_(0),
+                      maxConnections_(0),
+                      maxConnectionsPerLoop_(0),
+                      rejectLagMicros_(0),
+                      closeIdleLagMicros_(0),
+                      idleMicros_(0),
+                      overloaded_(false),
+                      shedConnections_(0),
+                      acceptPaused_(false),
+                      registry_(std::make_shared<ConnectionRegistry>())
 {
     // 有新用户连接时，会执行 TcpnewConnection 回调函数
     acceptor_->setNewConnectionCallback(
         std::bind(&TcpServer::newConnection, this, std::placeholders::_1, std::placeholders::_2)
     );
+
+    // 连接名：服务名-ip:port#连接编号
+    callbacks_->namePrefix = name_ + "-" + ipPort + "#";
+    callbacks_->closeCallback = std::bind(&TcpServer::removeConnection, this, std::placeholders::_1);
 }
 
+// 内存预算检查间隔
+static const double kMemoryCheckInterval = 0.1;
+static const double kOverloadCheckInterval = 0.1;
+
 TcpServer::~TcpServer()
 {
+    if (memoryGovernor_)
+    {
+        loop_->cancel(memoryTimer_);
+    }
+    if (rejectLagMicros_ > 0 || closeIdleLagMicros_ > 0)
+    {
+        loop_->cancel(overloadTimer_);
+    }
+
     for (auto & item : connections_)
     {
         TcpConnectionPtr conn(item.second);
@@ -57,11 +104,31 @@ void TcpServer::setThreadNum(int numThreads)
     threadPool_->setThreadNum(numThreads);
 }
 
+bool TcpServer::sendTo(ConnectionId id, const std::string& msg) const
+{
+    return registry_->send(id, msg);
+}
+
 void TcpServer::start()
 {
     if (started_++ == 0)    // 防止一个tcpServer对象被 start多次
     {
         threadPool_->start(threadInitCallback_);    // 启动底层 loop线程池
+        for (EventLoop* ioLoop : threadPool_->getAllLoops())
+        {
+            connectionPools_[ioLoop] = std::make_shared<FixedSizePool>();
+            loopConnections_[ioLoop].reset(new LoopConnectionMap);
+            loopConnectionCounts_[ioLoop] = 0;
+        }
+        if (memoryGovernor_)
+        {
+            memoryTimer_ = loop_->runEvery(kMemoryCheckInterval, std::bind(&TcpServer::checkMemory, this));
+        }
+        if (rejectLagMicros_ > 0 || closeIdleLagMicros_ > 0)
+        {
+            overloadTimer_ = loop_->runEvery(kOverloadCheckInterval, std::bind(&TcpServer::checkOverload, this));
+        }
+        acceptor_->setSocketOptions(socketOptions_);
         loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));    // mainloop 开启监听
     }
 }
@@ -70,49 +137,79 @@ void TcpServer::start()
 // 有一个新客户端连接， acceptor 会执行回调操作
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
-    // 1. 轮询算法选择一个 subLoop，管理channel
-    EventLoop* ioLoop = threadPool_->getNextLoop();
+    // 内存接近预算，拒绝新连接
+    if (memoryGovernor_ && memoryGovernor_->level() >= MemoryGovernor::kRejectNew)
+    {
+        ++rejectedConnections_;
+        LOG_ERROR("TcpServer::newConnection [%s] memory usage %ld over budget, reject %s\n",
+            name_.c_str(), memoryGovernor_->usage(), peerAddr.toIpPort().c_str());
+        ::close(sockfd);
+        return;
+    }
 
-    char buf[64] = {0};
-    snprintf(buf, sizeof(buf), "-%s#%d", ipPort.c_str(), nextConnId_);
-    ++nextConnId_;
+    // 1. 轮询算法选择一个 subLoop，管理channel（跳过连接数已满的 loop）
+    EventLoop* ioLoop = nextAvailableLoop();
+    if (ioLoop == nullptr)
+    {
+        // 正常情况下达到上限时已经暂停了 accept，这里只处理上限在运行中被调小的情况
+        ++rejectedConnections_;
+        ::close(sockfd);
+        updateAccepting();
+        return;
+    }
 
-    std::string connName = name_ + buf;
-    LOG_INFO("TcpServer::newConection [%s] - new connection [%s] from %s \n",
-        name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
+    ConnectionId connId = nextConnId_++;
+    LOG_INFO("TcpServer::newConection [%s] - new connection [%s%llu] from %s \n",
+        name_.c_str(), callbacks_->namePrefix.c_str(), (unsigned long long)connId,
+        peerAddr.toIpPort().c_str());
     
     // 通过 sockfd 获取绑定本机的IP地址和端口号
-    sockaddr_in local;
-    bzero(&local, sizeof(local));
-    socklen_t addrLen = sizeof(local);
-    if (::getsockname(sockfd, (sockaddr*)&local, &addrLen) < 0)
-    {
-        LOG_ERROR("sockets:getsockname\n");
-    }
-    InetAddress localAddr(local);
+    InetAddress localAddr(Socket::localAddress(sockfd));
 
     // 2. 根据连接成功的 sockfd， 创建TcpConnection
-    TcpConnectionPtr conn(new TcpConnection(
+    //    对象与控制块一次分配，内存来自 ioLoop 的连接池；回调共享 callbacks_
+    TcpConnectionPtr conn = std::allocate_shared<TcpConnection>(
+                            PoolAllocator<TcpConnection>(connectionPools_[ioLoop]),
                             ioLoop,
-                            connName,
                             sockfd,
                             localAddr,
-                            peerAddr
-    ));
-    connections_[connName] = conn;
-
-    // // 绑定相应连接
-    // // TcpServer => TcpConnection => Channel => Poller => notify channel 调用回调
-    conn->setConnectionCallback(connectionCallback_);
-    conn->setMessageCallback(messageCallback_);
-    conn->setWriteCompleteCallback(writeCompleteCallback_);
-
-    // // 设置如何关闭连接的回调
-    conn->setCloseCallback(
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)
+                            peerAddr,
+                            connId,
+                            callbacks_
     );
+    connections_[connId] = conn;
+    registry_->add(connId, conn);
+    conn->setRegistry(registry_);
+
+    conn->setHighWaterMark(highWaterMark_);
+    if (backpressure_)
+    {
+        conn->setWaterMarks(highWaterMark_, lowWaterMark_, pauseSelfOnHighWater_);
+    }
+    conn->setSlowConsumerTimeout(slowConsumerTimeout_);
+    conn->setWriteCoalescing(writeCoalescing_);
+    conn->setReadBudget(readBudgetBytes_, readBudgetReads_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setSocketOptions(socketOptions_);
+    conn->setSharedRateLimiter(rateLimiter_);
+    if (connectionRate_ > 0)
+    {
+        conn->setRateLimit(connectionRate_, connectionBurst_);
+    }
+    if (notSentLowat_ > 0)
+    {
+        conn->setLowLatencySend(notSentLowat_);
+    }
+    if (memoryGovernor_)
+    {
+        conn->setMemoryGovernor(memoryGovernor_);
+    }
+
+    ++loopConnectionCounts_[ioLoop];
+    updateAccepting();
+
     // 3. 直接调用 tcpConnection::connectEstablished()
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+    ioLoop->runInLoop(std::bind(&TcpServer::connectEstablishedInLoop, this, conn));
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
@@ -127,9 +224,314 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
     LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s \n",
         name_.c_str(), conn->name().c_str());
 
-    connections_.erase(conn->name());
+    connections_.erase(conn->id());
     EventLoop* ioLoop = conn->getLoop();
+    --loopConnectionCounts_[ioLoop];
+    updateAccepting();
     ioLoop->queueInLoop(
-        std::bind(&TcpConnection::connectDistroyed, conn)
+        std::bind(&TcpServer::connectDestroyedInLoop, this, conn)
     );
 }
+
+void TcpServer::connectEstablishedInLoop(const TcpConnectionPtr& conn)
+{
+    loopConnections_.at(conn->getLoop())->emplace(conn->id(), conn.get());
+    conn->connectEstablished();
+}
+
+void TcpServer::connectDestroyedInLoop(const TcpConnectionPtr& conn)
+{
+    loopConnections_.at(conn->getLoop())->erase(conn->id());
+    conn->connectDistroyed();
+}
+
+void TcpServer::broadcast(const PayloadPtr& payload)
+{
+    std::shared_ptr<const std::vector<ConnectionId>> all;
+    for (EventLoop* ioLoop : threadPool_->getAllLoops())
+    {
+        ioLoop->runInLoop(std::bind(&TcpServer::broadcastInLoop, this, ioLoop, payload, all));
+    }
+}
+
+void TcpServer::broadcast(const PayloadPtr& payload, const std::vector<ConnectionId>& targets)
+{
+    // 目标列表只拷贝一次，各 loop 共享，只处理属于自己的连接
+    std::shared_ptr<const std::vector<ConnectionId>> shared =
+        std::make_shared<const std::vector<ConnectionId>>(targets);
+    for (EventLoop* ioLoop : threadPool_->getAllLoops())
+    {
+        ioLoop->runInLoop(std::bind(&TcpServer::broadcastInLoop, this, ioLoop, payload, shared));
+    }
+}
+
+void TcpServer::broadcastInLoop(EventLoop* loop, const PayloadPtr& payload,
+                                const std::shared_ptr<const std::vector<ConnectionId>>& targets)
+{
+    const LoopConnectionMap& conns = *loopConnections_.at(loop);
+    if (!targets)
+    {
+        for (const LoopConnectionMap::value_type& item : conns)
+        {
+            item.second->send(payload);
+        }
+        return;
+    }
+
+    for (ConnectionId id : *targets)
+    {
+        LoopConnectionMap::const_iterator it = conns.find(id);
+        if (it != conns.end())
+        {
+            it->second->send(payload);
+        }
+    }
+}
+
+void TcpServer::setMemoryBudget(int64_t bytes)
+{
+    memoryGovernor_ = bytes > 0 ? std::make_shared<MemoryGovernor>(bytes) : nullptr;
+}
+
+void TcpServer::setRateLimit(double bytesPerSecond, size_t burst)
+{
+    // 各连接在下一次写时看到新的速率
+    rateLimiter_->setRate(bytesPerSecond, burst);
+}
+
+void TcpServer::setLoadShedding(double rejectLag, double closeIdleLag, double idleSeconds)
+{
+    rejectLagMicros_ = static_cast<int64_t>(rejectLag * Timestamp::kMicroSecondsPerSecond);
+    closeIdleLagMicros_ = static_cast<int64_t>(closeIdleLag * Timestamp::kMicroSecondsPerSecond);
+    idleMicros_ = static_cast<int64_t>(idleSeconds * Timestamp::kMicroSecondsPerSecond);
+}
+
+TcpServerStats TcpServer::stats() const
+{
+    TcpServerStats stats;
+    stats.connections = registry_->size();
+    stats.memoryUsage = memoryGovernor_ ? memoryGovernor_->usage() : 0;
+    stats.memoryBudget = memoryGovernor_ ? memoryGovernor_->budget() : 0;
+    stats.rejectedConnections = rejectedConnections_.load();
+    stats.rateLimitedBytes = rateLimiter_->grantedBytes();
+    stats.loopLagMicros = 0;
+    if (started_)
+    {
+        for (EventLoop* ioLoop : threadPool_->getAllLoops())
+        {
+            stats.loopLagMicros = std::max(stats.loopLagMicros, ioLoop->lagMicros());
+        }
+    }
+    stats.shedConnections = shedConnections_.load();
+    stats.acceptPaused = acceptPaused_.load();
+    return stats;
+}
+
+/********************************************************************************************
+ * 内存预算分级处理（baseloop 定时执行）
+ *     kShrink    ：进入该级别时，以及之后每秒一次，收缩所有空闲连接的缓冲区
+ *     kPauseRead ：每次检查暂停 1/10 占用内存最多、还在读取的连接
+ *     kRejectNew ：newConnection 直接关闭新连接（连接自己也会在读到数据后暂停读取）
+ *     降到 kPauseRead 以下后，恢复所有被暂停的连接
+**********************************************************************************************/
+void TcpServer::checkMemory()
+{
+    int level = memoryGovernor_->level();
+    ++memoryTicks_;
+
+    if (level >= MemoryGovernor::kShrink
+        && (level > lastMemoryLevel_ || memoryTicks_ % 10 == 0))
+    {
+        shrinkIdleBuffers();
+    }
+
+    if (level >= MemoryGovernor::kPauseRead)
+    {
+        pauseLargestConsumers();
+    }
+    else
+    {
+        resumeMemoryPaused();       // 没有暂停的连接时只是取一个空列表
+    }
+
+    if (level != lastMemoryLevel_)
+    {
+        LOG_INFO("TcpServer::checkMemory [%s] memory level %d -> %d, usage %ld / %ld\n",
+            name_.c_str(), lastMemoryLevel_, level, memoryGovernor_->usage(), memoryGovernor_->budget());
+    }
+    lastMemoryLevel_ = level;
+}
+
+void TcpServer::shrinkIdleBuffers()
+{
+    // 按 loop 分组，每个 loop 只投递一个任务
+    std::unordered_map<EventLoop*, std::vector<TcpConnectionPtr>> byLoop;
+    for (const auto& item : connections_)
+    {
+        if (item.second->memoryUsage() > 0)
+        {
+            byLoop[item.second->getLoop()].push_back(item.second);
+        }
+    }
+
+    for (auto& item : byLoop)
+    {
+        std::shared_ptr<std::vector<TcpConnectionPtr>> conns =
+            std::make_shared<std::vector<TcpConnectionPtr>>(std::move(item.second));
+        item.first->queueInLoop([conns]() {
+            for (const TcpConnectionPtr& conn : *conns)
+            {
+                conn->shrinkBuffers();
+            }
+        });
+    }
+}
+
+void TcpServer::pauseLargestConsumers()
+{
+    std::vector<std::pair<int64_t, TcpConnectionPtr>> candidates;
+    for (const auto& item : connections_)
+    {
+        if (memoryPausedIds_.count(item.first) == 0)
+        {
+            candidates.emplace_back(item.second->memoryUsage(), item.second);
+        }
+    }
+    if (candidates.empty())
+    {
+        return;
+    }
+
+    size_t count = std::max<size_t>(1, connections_.size() / 10);
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+        [](const std::pair<int64_t, TcpConnectionPtr>& lhs, const std::pair<int64_t, TcpConnectionPtr>& rhs) {
+            return lhs.first > rhs.first;
+        });
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const TcpConnectionPtr& conn = candidates[i].second;
+        conn->setMemoryPressure(true);
+        memoryPausedIds_.insert(conn->id());
+        memoryGovernor_->addPaused(conn);
+    }
+}
+
+void TcpServer::resumeMemoryPaused()
+{
+    for (const TcpConnectionWeakPtr& weakConn : memoryGovernor_->takePaused())
+    {
+        TcpConnectionPtr conn = weakConn.lock();
+        if (conn)
+        {
+            conn->setMemoryPressure(false);
+        }
+    }
+    memoryPausedIds_.clear();
+}
+
+/********************************************************************************************
+ * 过载保护（baseloop 中执行）
+ *     连接数上限在 newConnection / removeConnectionInLoop 时检查，loop 延迟每 100ms 检查一次；
+ * 任一条件成立都暂停 Acceptor 的读事件，新连接留在内核 backlog 中，不占用 IO loop。
+**********************************************************************************************/
+EventLoop* TcpServer::nextAvailableLoop()
+{
+    for (size_t i = 0; i < loopConnectionCounts_.size(); ++i)
+    {
+        EventLoop* ioLoop = threadPool_->getNextLoop();
+        if (maxConnectionsPerLoop_ == 0 || loopConnectionCounts_[ioLoop] < maxConnectionsPerLoop_)
+        {
+            return ioLoop;
+        }
+    }
+    return nullptr;
+}
+
+void TcpServer::updateAccepting()
+{
+    bool full = maxConnections_ > 0 && connections_.size() >= maxConnections_;
+    if (!full && maxConnectionsPerLoop_ > 0)
+    {
+        full = true;
+        for (const auto& item : loopConnectionCounts_)
+        {
+            if (item.second < maxConnectionsPerLoop_)
+            {
+                full = false;
+                break;
+            }
+        }
+    }
+
+    bool accepting = !full && !overloaded_;
+    if (accepting == acceptPaused_)
+    {
+        LOG_INFO("TcpServer [%s] %s accepting, %zu connections\n",
+            name_.c_str(), accepting ? "resume" : "pause", connections_.size());
+    }
+    acceptor_->setAccepting(accepting);
+    acceptPaused_ = !accepting;
+}
+
+void TcpServer::checkOverload()
+{
+    int64_t lag = 0;
+    for (EventLoop* ioLoop : threadPool_->getAllLoops())
+    {
+        lag = std::max(lag, ioLoop->lagMicros());
+        // 空闲的 loop 不会更新延迟，投递一个空回调让它醒来
+        ioLoop->queueInLoop([]() {});
+    }
+
+    bool overloaded = rejectLagMicros_ > 0 && lag >= rejectLagMicros_;
+    if (overloaded != overloaded_)
+    {
+        LOG_INFO("TcpServer::checkOverload [%s] loop lag %ld us, %s\n",
+            name_.c_str(), lag, overloaded ? "overloaded" : "recovered");
+        overloaded_ = overloaded;
+        updateAccepting();
+    }
+
+    if (closeIdleLagMicros_ > 0 && lag >= closeIdleLagMicros_)
+    {
+        shedIdleConnections();
+    }
+}
+
+// 关闭延迟超标的 loop 上最新建立的空闲连接：新连接最可能是涌入的一批，关闭它们对已有客户端影响最小
+void TcpServer::shedIdleConnections()
+{
+    int64_t now = Timestamp::monotonicMicros();
+    std::vector<TcpConnectionPtr> candidates;
+    for (const auto& item : connections_)
+    {
+        const TcpConnectionPtr& conn = item.second;
+        if (conn->connected()
+            && conn->getLoop()->lagMicros() >= closeIdleLagMicros_
+            && now - conn->lastActiveMicros() >= idleMicros_)
+        {
+            candidates.push_back(conn);
+        }
+    }
+
+    size_t count = std::max<size_t>(1, connections_.size() / 20);
+    if (candidates.size() > count)
+    {
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+            [](const TcpConnectionPtr& a, const TcpConnectionPtr& b) { return a->id() > b->id(); });
+        candidates.resize(count);
+    }
+
+    for (const TcpConnectionPtr& conn : candidates)
+    {
+        conn->forceClose();
+    }
+    if (!candidates.empty())
+    {
+        shedConnections_ += candidates.size();
+        LOG_INFO("TcpServer::shedIdleConnections [%s] close %zu idle connections\n",
+            name_.c_str(), candidates.size());
+    }
+}
@@ -7,14 +7,35 @@
 #include "Callbacks.h"
 #include "TcpConnection.h"
 #include "Buffer.h"
+#include "Payload.h"
+#include "SocketOptions.h"
 
 #include <functional>
 #include <string.h>
 #include <memory>
 #include <atomic>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 class EventLoopThreadPool;
+class ConnectionRegistry;
+class FixedSizePool;
+class MemoryGovernor;
+class TokenBucket;
+
+// 服务器运行统计，任意线程可读
+struct TcpServerStats
+{
+    size_t connections;             // 当前连接数
+    int64_t memoryUsage;            // 所有连接缓冲区占用的内存
+    int64_t memoryBudget;           // 内存预算，0 表示不限制
+    uint64_t rejectedConnections;   // 因内存紧张拒绝的连接数
+    uint64_t rateLimitedBytes;      // 服务器整体限速期间写出的字节数
+    int64_t loopLagMicros;          // 各 IO loop 延迟的最大值，见 EventLoop::lagMicros
+    uint64_t shedConnections;       // 过载时主动关闭的空闲连接数
+    bool acceptPaused;              // 因连接数上限或过载暂停了 accept
+};
 
 class TcpServer : noncopyable
 {
@@ -28,13 +49,89 @@ public:
     TcpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string nameArg, Option option = kNoReusePort);
     ~TcpServer();
 
+    // 回调需要在 start 之前设置，所有连接共享同一份回调集合
     void setThreadInitCallback(const ThreadInitCallback& cb) {  threadInitCallback_ = cb;   }
-    void setConnectionCallback(const ConnectionCallback& cb) {  connectionCallback_ = cb;   }
-    void setMessageCalback(const MessageCallback& cb)        {  messageCallback_ = cb;      }
-    void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb;}
+    void setConnectionCallback(const ConnectionCallback& cb) {  callbacks_->connectionCallback = cb;    }
+    void setMessageCalback(const MessageCallback& cb)        {  callbacks_->messageCallback = cb;       }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb) { callbacks_->writeCompleteCallback = cb; }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+    {
+        callbacks_->highWaterMarkCallback = cb;
+        highWaterMark_ = highWaterMark;
+    }
+
+    // 背压与慢消费者淘汰，对之后建立的每个连接生效，见 TcpConnection::setWaterMarks
+    void setWaterMarks(size_t highWaterMark, size_t lowWaterMark, bool pauseSelf = true)
+    {
+        highWaterMark_ = highWaterMark;
+        lowWaterMark_ = lowWaterMark;
+        backpressure_ = highWaterMark > 0;
+        pauseSelfOnHighWater_ = pauseSelf;
+    }
+    void setSlowConsumerTimeout(double seconds) {   slowConsumerTimeout_ = seconds; }
+    // 合并写，对之后建立的每个连接生效，见 TcpConnection::setWriteCoalescing
+    void setWriteCoalescing(bool on) {  writeCoalescing_ = on;  }
+    // 每轮事件循环的读取预算与边沿触发，对之后建立的每个连接生效，见 TcpConnection::setReadBudget
+    void setReadBudget(size_t maxBytes, int maxReads = 0)
+    {
+        readBudgetBytes_ = maxBytes;
+        readBudgetReads_ = maxReads;
+    }
+    void setEdgeTriggered(bool on) {    edgeTriggered_ = on;    }
+
+    // 低延迟发送，对之后建立的每个连接生效，见 TcpConnection::setLowLatencySend
+    void setLowLatencySend(size_t notSentLowat) {   notSentLowat_ = notSentLowat;   }
+
+    // 发送限速：整个服务器共享一个令牌桶，任意线程可调用，可随时修改，0 表示不限制
+    void setRateLimit(double bytesPerSecond, size_t burst = 0);
+    // 每个连接单独的限速，对之后建立的连接生效；已有连接用 TcpConnection::setRateLimit 修改
+    void setConnectionRateLimit(double bytesPerSecond, size_t burst = 0)
+    {
+        connectionRate_ = bytesPerSecond;
+        connectionBurst_ = burst;
+    }
+
+    /**
+     * socket 选项：监听 socket 的部分在 start 时设置，已连接 socket 的部分对之后建立的
+     * 每个连接生效。预设见 SocketOptions::latency() / SocketOptions::throughput()。
+     */
+    void setSocketOptions(const SocketOptions& options) {   socketOptions_ = options;   }
+    const SocketOptions& socketOptions() const {    return socketOptions_;  }
+
+    /**
+     * 过载保护，start 之前设置，0 表示不限制：
+     *   连接数达到 maxConnections，或者每个 loop 都达到 maxPerLoop 时暂停 accept，
+     * 新连接留在内核 backlog 中，有连接关闭后恢复；达到 maxPerLoop 的 loop 不再分配连接。
+     *   按 loop 延迟卸载：每 100ms 检查一次各 IO loop 的延迟（见 EventLoop::lagMicros），
+     * 最大值超过 rejectLag 秒时暂停 accept；某个 loop 超过 closeIdleLag 秒时，关闭该 loop
+     * 上最新建立、超过 idleSeconds 秒没有读到数据的连接（每次最多 1/20）。
+     */
+    void setMaxConnections(size_t maxConnections, size_t maxPerLoop = 0)
+    {
+        maxConnections_ = maxConnections;
+        maxConnectionsPerLoop_ = maxPerLoop;
+    }
+    void setLoadShedding(double rejectLag, double closeIdleLag, double idleSeconds = 1.0);
+
+    // 所有连接缓冲区的内存预算（字节），start 之前设置，见 MemoryGovernor
+    void setMemoryBudget(int64_t bytes);
+
+    TcpServerStats stats() const;
 
     void setThreadNum(int numThreads);
 
+    // 任意线程：按连接编号查找连接 / 推送数据
+    const std::shared_ptr<ConnectionRegistry>& registry() const {   return registry_;   }
+    bool sendTo(ConnectionId id, const std::string& msg) const;
+
+    /**
+     * 任意线程：把同一条共享消息发给所有连接 / 指定的连接。
+     *   每个 loop 只投递一个任务，任务在 loop 线程中遍历本 loop 的连接入队，
+     * 各连接只持有 payload 的引用，不拷贝数据。start 之后调用。
+     */
+    void broadcast(const PayloadPtr& payload);
+    void broadcast(const PayloadPtr& payload, const std::vector<ConnectionId>& targets);
+
     void start();       // 开启监听
 
 
@@ -42,23 +139,80 @@ private:
     void newConnection(int sockfd, const InetAddress& peerAddr);
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
+    // 在连接所属 loop 中执行，同时维护该 loop 的连接表
+    void connectEstablishedInLoop(const TcpConnectionPtr& conn);
+    void connectDestroyedInLoop(const TcpConnectionPtr& conn);
+    void broadcastInLoop(EventLoop* loop, const PayloadPtr& payload,
+                         const std::shared_ptr<const std::vector<ConnectionId>>& targets);
 
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    // 过载保护，baseloop 中执行
+    EventLoop* nextAvailableLoop();
+    void updateAccepting();
+    void checkOverload();
+    void shedIdleConnections();
+
+    // 内存预算检查，baseloop 中定时执行
+    void checkMemory();
+    void shrinkIdleBuffers();
+    void pauseLargestConsumers();
+    void resumeMemoryPaused();
+
+    using ConnectionMap = std::unordered_map<ConnectionId, TcpConnectionPtr>;
+    using PoolMap = std::unordered_map<EventLoop*, std::shared_ptr<FixedSizePool>>;
+    // 每个 loop 自己的连接表，只在该 loop 线程中访问
+    using LoopConnectionMap = std::unordered_map<ConnectionId, TcpConnection*>;
+    using LoopConnectionsMap = std::unordered_map<EventLoop*, std::unique_ptr<LoopConnectionMap>>;
 
     EventLoop* loop_;       // base loop: the acceptor loop
     const std::string ipPort;
     const std::string name_;
     
     std::unique_ptr<Acceptor> acceptor_;        // 监听连接事件
+    // start 时创建，之后外层 map 不再修改；声明在线程池之前，
+    // 保证 IO 线程退出之后才析构（线程中可能还有未执行的建立 / 销毁连接任务）
+    LoopConnectionsMap loopConnections_;
     std::shared_ptr<EventLoopThreadPool> threadPool_;
 
-    ConnectionCallback connectionCallback_;      // 新连接回调
-    MessageCallback messageCallback_;           // 读写消息回调
-    WriteCompleteCallback writeCompleteCallback_;   // 消息发送完成的回调
+    ConnectionCallbacksPtr callbacks_;          // 新连接、读写消息、发送完成、关闭回调
     ThreadInitCallback threadInitCallback_;     // 线程初始化
 
     std::atomic_int started_;
 
-    int nextConnId_;
-    ConnectionMap connections_;     // 保存所有连接
+    size_t highWaterMark_;
+    size_t lowWaterMark_;
+    bool backpressure_;
+    bool pauseSelfOnHighWater_;
+    double slowConsumerTimeout_;
+    bool writeCoalescing_;
+    size_t readBudgetBytes_;
+    int readBudgetReads_;
+    bool edgeTriggered_;
+    std::shared_ptr<TokenBucket> rateLimiter_;  // 所有连接共享，默认不限制
+    double connectionRate_;
+    size_t connectionBurst_;
+    size_t notSentLowat_;
+    SocketOptions socketOptions_;
+
+    std::shared_ptr<MemoryGovernor> memoryGovernor_;
+    TimerId memoryTimer_;
+    int lastMemoryLevel_;
+    int memoryTicks_;
+    std::unordered_set<ConnectionId> memoryPausedIds_;      // 因内存紧张暂停读取的连接
+    std::atomic<uint64_t> rejectedConnections_;
+
+    size_t maxConnections_;
+    size_t maxConnectionsPerLoop_;
+    int64_t rejectLagMicros_;
+    int64_t closeIdleLagMicros_;
+    int64_t idleMicros_;
+    TimerId overloadTimer_;
+    bool overloaded_;               // 延迟超过 rejectLag，只在 baseloop 中访问
+    std::unordered_map<EventLoop*, size_t> loopConnectionCounts_;   // 只在 baseloop 中访问
+    std::atomic<uint64_t> shedConnections_;
+    std::atomic_bool acceptPaused_;
+
+    ConnectionId nextConnId_;
+    ConnectionMap connections_;     // 保存所有连接, 只在 baseloop 中访问
+    std::shared_ptr<ConnectionRegistry> registry_;   // 连接编号索引, 任意线程可读
+    PoolMap connectionPools_;       // 每个 loop 一个 TcpConnection 内存池, start 时创建
 };
\ No newline at end of file
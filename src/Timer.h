@@ -0,0 +1,55 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <functional>
+#include <atomic>
+#include <stdint.h>
+
+using TimerCallback = std::function<void()>;
+
+/**************************************************************************************
+ * 定时器：到期时间使用单调时钟（Timestamp::monotonicMicros），interval > 0 表示周期定时器
+**************************************************************************************/
+class Timer : noncopyable
+{
+public:
+    Timer(TimerCallback cb, int64_t expiration, int64_t interval)
+        : callback_(std::move(cb)),
+          expiration_(expiration),
+          interval_(interval),
+          sequence_(++numCreated_)
+    {
+    }
+
+    void run() const    {   callback_();    }
+
+    int64_t expiration() const  {   return expiration_; }
+    bool repeat() const {   return interval_ > 0;   }
+    int64_t sequence() const    {   return sequence_;   }
+
+    void restart(int64_t now)   {   expiration_ = now + interval_;  }
+
+private:
+    const TimerCallback callback_;
+    int64_t expiration_;
+    const int64_t interval_;
+    const int64_t sequence_;
+
+    static std::atomic<int64_t> numCreated_;
+};
+
+/**************************************************************************************
+ * 定时器标识，用于取消定时器。sequence 用来区分地址被复用的不同定时器
+**************************************************************************************/
+class TimerId
+{
+public:
+    TimerId() : timer_(nullptr), sequence_(0) {}
+    TimerId(Timer* timer, int64_t seq) : timer_(timer), sequence_(seq) {}
+
+    friend class TimerQueue;
+private:
+    Timer* timer_;
+    int64_t sequence_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timer.h"
+#include "Channel.h"
+
+#include <set>
+#include <vector>
+#include <memory>
+
+class EventLoop;
+
+/**************************************************************************************
+ * 定时器队列：一个 timerfd 注册为 loop 中的一个 Channel，timerfd 总是设置为最早到期
+ * 的定时器的时间。timerfd 可读时，取出所有到期定时器执行回调，周期定时器重新加入队列。
+ *     addTimer / cancel 可以在任意线程调用，实际操作都在 loop 线程中完成。
+**************************************************************************************/
+class TimerQueue : noncopyable
+{
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    // when：单调时钟微秒，interval > 0 为周期定时器
+    TimerId addTimer(TimerCallback cb, int64_t when, int64_t interval);
+    void cancel(TimerId timerId);
+
+private:
+    using Entry = std::pair<int64_t, Timer*>;       // 按到期时间排序
+    using TimerList = std::set<Entry>;
+    using ActiveTimer = std::pair<Timer*, int64_t>; // 按地址排序，用于取消
+    using ActiveTimerSet = std::set<ActiveTimer>;
+
+    void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
+    void handleRead();      // timerfd 可读
+
+    std::vector<Entry> getExpired(int64_t now);
+    void reset(const std::vector<Entry>& expired, int64_t now);
+    bool insert(Timer* timer);      // 返回 是否成为最早到期的定时器
+    void resetTimerfd(int64_t expiration);
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    TimerList timers_;
+    ActiveTimerSet activeTimers_;
+
+    bool callingExpiredTimers_;
+    ActiveTimerSet cancelingTimers_;    // 回调执行期间被取消的周期定时器
+};
@@ -1,6 +1,7 @@
 #include "Timestamp.h"
 
 #include <time.h>
+#include <stdio.h>
 
 Timestamp::Timestamp() : microSecondsSinceEpoch_(0){}
 
@@ -9,27 +10,39 @@ Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
     {}
 
 Timestamp Timestamp::now(){
-    return Timestamp(time(NULL));
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return Timestamp(static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond + ts.tv_nsec / 1000);
 }
 
-std::string Timestamp::toString() const{
-    char buf[128] = {0};
-    tm* tm_time = localtime(&microSecondsSinceEpoch_);
-
-    snprintf(buf, 128, "%4d/%02d/%02d %02d:%02d:%02d",
-            tm_time->tm_year + 1900,
-            tm_time->tm_mon  + 1,
-            tm_time->tm_mday,
-            tm_time->tm_hour,
-            tm_time->tm_min,
-            tm_time->tm_sec);
-    return buf;
+int64_t Timestamp::monotonicMicros(){
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * kMicroSecondsPerSecond + ts.tv_nsec / 1000;
 }
 
-// #include <iostream>
-
-// int main(){
-//     std::cout << Timestamp::now().toString() << std::endl;
+std::string Timestamp::toString() const{
+    return toFormattedString(false);
+}
 
-//     return 0;
-// }
\ No newline at end of file
+std::string Timestamp::toFormattedString(bool showMicroseconds) const{
+    char buf[64] = {0};
+    // localtime 返回静态缓冲区，多线程写日志时不安全
+    time_t seconds = secondsSinceEpoch();
+    tm tm_time;
+    localtime_r(&seconds, &tm_time);
+
+    int len = snprintf(buf, sizeof(buf), "%4d/%02d/%02d %02d:%02d:%02d",
+            tm_time.tm_year + 1900,
+            tm_time.tm_mon  + 1,
+            tm_time.tm_mday,
+            tm_time.tm_hour,
+            tm_time.tm_min,
+            tm_time.tm_sec);
+    if (showMicroseconds)
+    {
+        snprintf(buf + len, sizeof(buf) - len, ".%06d",
+                 static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond));
+    }
+    return buf;
+}
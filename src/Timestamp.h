@@ -2,14 +2,55 @@
 
 #include <iostream>
 #include <string>
+#include <stdint.h>
+#include <time.h>
 
+/**************************************************************************************
+ * 时间戳：自 Epoch 以来的微秒数（CLOCK_REALTIME）。
+ *     计算时间间隔、超时使用 monotonicMicros()（CLOCK_MONOTONIC），不受系统时间调整影响；
+ * 同一次循环中的大量读取使用 EventLoop::now() / nowMonotonic() 缓存的值。
+**************************************************************************************/
 class Timestamp{
 public:
     Timestamp();
     explicit Timestamp(int64_t microSecondsSinceEpoch);
     static Timestamp now();
+    // 单调时钟，单位微秒
+    static int64_t monotonicMicros();
+
+    // "2021/01/01 12:00:00"，showMicroseconds 时追加 ".123456"
     std::string toString() const;
+    std::string toFormattedString(bool showMicroseconds = true) const;
+
+    int64_t microSecondsSinceEpoch() const {    return microSecondsSinceEpoch_; }
+    time_t secondsSinceEpoch() const {  return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond);  }
+    bool valid() const {    return microSecondsSinceEpoch_ > 0; }
+
+    static const int kMicroSecondsPerSecond = 1000 * 1000;
 
 private:
     int64_t microSecondsSinceEpoch_;
-};
\ No newline at end of file
+};
+
+inline bool operator<(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+// 两个时间戳相差的秒数
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+inline Timestamp addTime(Timestamp timestamp, double seconds)
+{
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
@@ -0,0 +1,99 @@
+#include "TokenBucket.h"
+#include "Timestamp.h"
+
+TokenBucket::TokenBucket(double bytesPerSecond, size_t burst)
+    : rate_(0),
+      burst_(0),
+      tokens_(0),
+      lastRefill_(Timestamp::monotonicMicros()),
+      granted_(0)
+{
+    setRate(bytesPerSecond, burst);
+}
+
+void TokenBucket::setRate(double bytesPerSecond, size_t burst)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    refill(Timestamp::monotonicMicros());
+
+    double rate = bytesPerSecond > 0 ? bytesPerSecond : 0;
+    burst_ = burst > 0 ? static_cast<double>(burst) : rate / 10;
+    if (burst_ < kMinBurst)
+    {
+        burst_ = kMinBurst;
+    }
+    // 从不限速切换过来时桶是满的；降低 burst 时丢弃多余的令牌
+    if (!limited() || tokens_ > burst_)
+    {
+        tokens_ = burst_;
+    }
+    rate_.store(rate, std::memory_order_relaxed);
+}
+
+size_t TokenBucket::burst() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return static_cast<size_t>(burst_);
+}
+
+void TokenBucket::refill(int64_t nowMicros)
+{
+    if (nowMicros > lastRefill_)
+    {
+        tokens_ += rate() * static_cast<double>(nowMicros - lastRefill_) / 1000000;
+        if (tokens_ > burst_)
+        {
+            tokens_ = burst_;
+        }
+        lastRefill_ = nowMicros;
+    }
+}
+
+size_t TokenBucket::take(size_t want, int64_t nowMicros)
+{
+    if (!limited())
+    {
+        return want;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    refill(nowMicros);
+    size_t granted = tokens_ < static_cast<double>(want) ? static_cast<size_t>(tokens_) : want;
+    tokens_ -= static_cast<double>(granted);
+    granted_.fetch_add(granted, std::memory_order_relaxed);
+    return granted;
+}
+
+void TokenBucket::refund(size_t n)
+{
+    if (n == 0 || !limited())
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    tokens_ += static_cast<double>(n);
+    if (tokens_ > burst_)
+    {
+        tokens_ = burst_;
+    }
+    granted_.fetch_sub(n, std::memory_order_relaxed);
+}
+
+int64_t TokenBucket::waitMicros(size_t n, int64_t nowMicros)
+{
+    double rate = this->rate();
+    if (rate <= 0)
+    {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    refill(nowMicros);
+    double need = static_cast<double>(n) < burst_ ? static_cast<double>(n) : burst_;
+    if (tokens_ >= need)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>((need - tokens_) * 1000000 / rate) + 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+
+/**************************************************************************************
+ * 令牌桶：按 rate 字节/秒补充令牌，最多积累 burst 个，发送前取令牌，取到多少发多少。
+ *     连接自己的桶只在 loop 线程使用；TcpServer 的桶由所有 IO 线程共享，因此内部加锁。
+ * 速率可以随时修改，rate 为 0 表示不限制（take 总是全部给出）。
+**************************************************************************************/
+class TokenBucket : noncopyable
+{
+public:
+    explicit TokenBucket(double bytesPerSecond = 0, size_t burst = 0);
+
+    // 任意线程：修改速率，burst 为 0 时取 100ms 的流量（至少 kMinBurst）
+    void setRate(double bytesPerSecond, size_t burst = 0);
+    double rate() const {   return rate_.load(std::memory_order_relaxed);  }
+    bool limited() const {  return rate() > 0;  }
+
+    // 取走最多 want 个令牌，返回实际取到的数量
+    size_t take(size_t want, int64_t nowMicros);
+    // 归还取到但没有用掉的令牌（内核缓冲区满时）
+    void refund(size_t n);
+    // 令牌积累到 n 个还需要的时间（微秒）
+    int64_t waitMicros(size_t n, int64_t nowMicros);
+
+    size_t burst() const;
+    // 限速期间累计发出的字节数
+    uint64_t grantedBytes() const { return granted_.load(std::memory_order_relaxed);    }
+
+    static const size_t kMinBurst = 4096;
+
+private:
+    void refill(int64_t nowMicros);
+
+    mutable std::mutex mutex_;
+    std::atomic<double> rate_;
+    double burst_;
+    double tokens_;
+    int64_t lastRefill_;
+    std::atomic<uint64_t> granted_;
+};
@@ -0,0 +1,431 @@
+#include "UdpChannel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+const size_t UdpChannel::kDefaultBatchSize;
+const size_t UdpChannel::kDefaultMaxDatagramSize;
+const size_t UdpChannel::kMaxSendQueue;
+const int UdpChannel::kMaxReadRounds;
+const size_t UdpChannel::kMaxGsoSegments;
+const size_t UdpChannel::kMaxGsoBytes;
+
+// GRO 合并后的数据报最大 64KB
+static const size_t kGroSlotSize = 65536;
+// 每个消息的控制信息空间：接收 UDP_GRO（int），发送 UDP_SEGMENT（uint16_t）
+static const size_t kControlSpace = CMSG_SPACE(sizeof(int));
+
+static int createUdpSocket(sa_family_t family)
+{
+    int sockfd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sockfd < 0)
+    {
+        LOG_FATAL("%s:%s:%d udp socket create error: %d", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+UdpChannel::UdpChannel(EventLoop* loop, const InetAddress& bindAddr, bool reusePort)
+    : loop_(loop),
+      socket_(createUdpSocket(bindAddr.family())),
+      channel_(loop, socket_.fd()),
+      localAddr_(bindAddr),
+      batchSize_(kDefaultBatchSize),
+      maxDatagramSize_(kDefaultMaxDatagramSize),
+      gso_(false),
+      gro_(false),
+      started_(false),
+      slotSize_(0),
+      sendMsgs_(kMaxSendQueue),
+      sendIov_(kMaxSendQueue),
+      sendControl_(kMaxSendQueue * kControlSpace),
+      sendMsgCounts_(kMaxSendQueue),
+      flushQueued_(false),
+      receivedPackets_(0),
+      receivedBytes_(0),
+      recvCalls_(0),
+      truncated_(0),
+      sentPackets_(0),
+      sentBytes_(0),
+      sendCalls_(0),
+      droppedSends_(0)
+{
+    socket_.setReuseAddr(true);
+    if (reusePort)
+    {
+        socket_.setReusePort(true);
+    }
+    socket_.bindAddress(bindAddr);
+
+    localAddr_ = Socket::localAddress(socket_.fd());     // 绑定端口 0 时取内核分配的端口
+    sendQueue_.reserve(kMaxSendQueue);
+
+    channel_.setReadCallback(std::bind(&UdpChannel::handleRead, this, std::placeholders::_1));
+    channel_.setWriteCallback(std::bind(&UdpChannel::handleWrite, this));
+}
+
+UdpChannel::~UdpChannel()
+{
+    if (started_)
+    {
+        channel_.disableAll();
+        channel_.remove();
+    }
+}
+
+void UdpChannel::start()
+{
+    loop_->runInLoop(std::bind(&UdpChannel::startInLoop, shared_from_this()));
+}
+
+void UdpChannel::startInLoop()
+{
+    if (started_)
+    {
+        return;
+    }
+    started_ = true;
+
+    if (gro_)
+    {
+        int on = 1;
+        if (::setsockopt(socket_.fd(), SOL_UDP, UDP_GRO, &on, sizeof(on)) < 0)
+        {
+            LOG_ERROR("UdpChannel::start fd %d UDP_GRO not supported: %d\n", socket_.fd(), errno);
+            gro_ = false;
+        }
+    }
+
+    // 接收数组只在这里分配，之后每次 recvmmsg 复用
+    slotSize_ = gro_ ? kGroSlotSize : maxDatagramSize_;
+    recvData_.resize(batchSize_ * slotSize_);
+    recvMsgs_.resize(batchSize_);
+    recvIov_.resize(batchSize_);
+    recvAddrs_.resize(batchSize_);
+    recvControl_.resize(batchSize_ * kControlSpace);
+    sendData_.reserve(batchSize_ * maxDatagramSize_);
+
+    channel_.tie(shared_from_this());
+    channel_.enableReading();
+}
+
+void UdpChannel::handleRead(Timestamp receiveTime)
+{
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t calls = 0;
+    for (int round = 0; round < kMaxReadRounds; ++round)
+    {
+        for (size_t i = 0; i < batchSize_; ++i)
+        {
+            recvIov_[i].iov_base = &recvData_[i * slotSize_];
+            recvIov_[i].iov_len = slotSize_;
+            msghdr& hdr = recvMsgs_[i].msg_hdr;
+            hdr.msg_name = &recvAddrs_[i];
+            hdr.msg_namelen = sizeof(sockaddr_storage);
+            hdr.msg_iov = &recvIov_[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = gro_ ? &recvControl_[i * kControlSpace] : nullptr;
+            hdr.msg_controllen = gro_ ? kControlSpace : 0;
+            hdr.msg_flags = 0;
+        }
+
+        int n = ::recvmmsg(socket_.fd(), recvMsgs_.data(), static_cast<unsigned int>(batchSize_), 0, nullptr);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                LOG_ERROR("UdpChannel::handleRead fd %d recvmmsg errno %d\n", socket_.fd(), errno);
+            }
+            break;
+        }
+        ++calls;
+
+        for (int i = 0; i < n; ++i)
+        {
+            const msghdr& hdr = recvMsgs_[i].msg_hdr;
+            if (hdr.msg_flags & MSG_TRUNC)
+            {
+                ++truncated_;
+                continue;
+            }
+            // GRO 合并的数据报带有原来的段长度
+            size_t segment = 0;
+            if (gro_)
+            {
+                for (cmsghdr* cm = CMSG_FIRSTHDR(&hdr); cm != nullptr; cm = CMSG_NXTHDR(const_cast<msghdr*>(&hdr), cm))
+                {
+                    if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+                    {
+                        int size = 0;
+                        memcpy(&size, CMSG_DATA(cm), sizeof(size));
+                        segment = size > 0 ? static_cast<size_t>(size) : 0;
+                    }
+                }
+            }
+            size_t len = recvMsgs_[i].msg_len;
+            InetAddress peer(reinterpret_cast<const sockaddr*>(&recvAddrs_[i]), hdr.msg_namelen);
+            packets += dispatch(peer, &recvData_[i * slotSize_], len, segment, receiveTime);
+            bytes += len;
+        }
+
+        if (static_cast<size_t>(n) < batchSize_)
+        {
+            break;
+        }
+    }
+
+    receivedPackets_.fetch_add(packets, std::memory_order_relaxed);
+    receivedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    recvCalls_.fetch_add(calls, std::memory_order_relaxed);
+}
+
+size_t UdpChannel::dispatch(const InetAddress& peer, const char* data, size_t len,
+                            size_t segment, Timestamp receiveTime)
+{
+    if (segment == 0 || segment >= len)
+    {
+        segment = len;
+    }
+    size_t count = 0;
+    size_t offset = 0;
+    do
+    {
+        size_t piece = len - offset < segment ? len - offset : segment;
+        if (messageCallback_)
+        {
+            messageCallback_(this, peer, data + offset, piece, receiveTime);
+        }
+        offset += piece;
+        ++count;
+    } while (offset < len);
+    return count;
+}
+
+bool UdpChannel::send(const InetAddress& peer, const char* data, size_t len)
+{
+    if (!loop_->isInLoopThread())
+    {
+        std::weak_ptr<UdpChannel> weakSelf(shared_from_this());
+        std::string copy(data, len);
+        loop_->runInLoop([weakSelf, peer, copy]() {
+            UdpChannelPtr self = weakSelf.lock();
+            if (self)
+            {
+                self->send(peer, copy.data(), copy.size());
+            }
+        });
+        return true;
+    }
+
+    if (len > maxDatagramSize_)
+    {
+        ++droppedSends_;
+        return false;
+    }
+    if (sendQueue_.size() >= kMaxSendQueue)
+    {
+        // 没有等待可写时先把队列发出去
+        if (!channel_.isWriting())
+        {
+            flush();
+        }
+        if (sendQueue_.size() >= kMaxSendQueue)
+        {
+            ++droppedSends_;
+            return false;
+        }
+    }
+
+    Outgoing out;
+    out.peer = peer;
+    out.offset = sendData_.size();
+    out.len = len;
+    sendData_.insert(sendData_.end(), data, data + len);
+    sendQueue_.push_back(out);
+    queueFlush();
+    return true;
+}
+
+// 本轮事件处理完后一次发出，等待可写时由 handleWrite 发出
+void UdpChannel::queueFlush()
+{
+    if (flushQueued_ || channel_.isWriting())
+    {
+        return;
+    }
+    flushQueued_ = true;
+    std::weak_ptr<UdpChannel> weakSelf(shared_from_this());
+    loop_->queueAfterEvents([weakSelf]() {
+        UdpChannelPtr self = weakSelf.lock();
+        if (self)
+        {
+            self->flush();
+        }
+    });
+}
+
+size_t UdpChannel::buildMessages(size_t first)
+{
+    size_t numMsgs = 0;
+    size_t numIov = 0;
+    size_t i = first;
+    while (i < sendQueue_.size())
+    {
+        const Outgoing& head = sendQueue_[i];
+        size_t count = 1;
+        size_t total = head.len;
+        if (gso_)
+        {
+            // 连续发往同一对端、长度相同的数据报合并，更短的只能是最后一个
+            while (i + count < sendQueue_.size() && count < kMaxGsoSegments)
+            {
+                const Outgoing& next = sendQueue_[i + count];
+                if (next.len == 0 || next.len > head.len || total + next.len > kMaxGsoBytes
+                    || !(next.peer == head.peer))
+                {
+                    break;
+                }
+                total += next.len;
+                ++count;
+                if (next.len < head.len)
+                {
+                    break;
+                }
+            }
+        }
+
+        msghdr& hdr = sendMsgs_[numMsgs].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = const_cast<sockaddr*>(head.peer.getSockAddr());
+        hdr.msg_namelen = head.peer.length();
+        hdr.msg_iov = &sendIov_[numIov];
+        hdr.msg_iovlen = count;
+        for (size_t k = 0; k < count; ++k)
+        {
+            const Outgoing& out = sendQueue_[i + k];
+            sendIov_[numIov].iov_base = &sendData_[out.offset];
+            sendIov_[numIov].iov_len = out.len;
+            ++numIov;
+        }
+        if (count > 1)
+        {
+            char* control = &sendControl_[numMsgs * kControlSpace];
+            memset(control, 0, kControlSpace);
+            hdr.msg_control = control;
+            hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment = static_cast<uint16_t>(head.len);
+            memcpy(CMSG_DATA(cm), &segment, sizeof(segment));
+        }
+        sendMsgCounts_[numMsgs] = count;
+        ++numMsgs;
+        i += count;
+    }
+    return numMsgs;
+}
+
+void UdpChannel::flush()
+{
+    flushQueued_ = false;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t calls = 0;
+    size_t first = 0;
+    while (first < sendQueue_.size())
+    {
+        size_t numMsgs = buildMessages(first);
+        int n = ::sendmmsg(socket_.fd(), sendMsgs_.data(), static_cast<unsigned int>(numMsgs), 0);
+        if (n < 0)
+        {
+            int err = errno;
+            if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS)
+            {
+                break;
+            }
+            if (err == EINTR)
+            {
+                continue;
+            }
+            if (gso_ && (err == EIO || err == EINVAL) && sendMsgCounts_[0] > 1)
+            {
+                // 内核或网卡不支持 GSO，关闭后逐个发送
+                LOG_ERROR("UdpChannel::flush fd %d UDP_SEGMENT failed: %d, disable gso\n", socket_.fd(), err);
+                gso_ = false;
+                continue;
+            }
+            // 第一个消息发送失败（如目的不可达），丢弃后继续
+            LOG_ERROR("UdpChannel::flush fd %d sendmmsg errno %d\n", socket_.fd(), err);
+            droppedSends_.fetch_add(sendMsgCounts_[0], std::memory_order_relaxed);
+            first += sendMsgCounts_[0];
+            continue;
+        }
+
+        ++calls;
+        for (int i = 0; i < n; ++i)
+        {
+            packets += sendMsgCounts_[i];
+            bytes += sendMsgs_[i].msg_len;
+            first += sendMsgCounts_[i];
+        }
+    }
+
+    if (first == sendQueue_.size())
+    {
+        sendQueue_.clear();
+        sendData_.clear();
+        if (channel_.isWriting())
+        {
+            channel_.disableWriting();
+        }
+    }
+    else
+    {
+        // 内核发送缓冲区满：去掉已发出的部分，等待可写
+        if (first > 0)
+        {
+            size_t base = sendQueue_[first].offset;
+            sendData_.erase(sendData_.begin(), sendData_.begin() + base);
+            sendQueue_.erase(sendQueue_.begin(), sendQueue_.begin() + first);
+            for (Outgoing& out : sendQueue_)
+            {
+                out.offset -= base;
+            }
+        }
+        if (!channel_.isWriting())
+        {
+            channel_.enableWriting();
+        }
+    }
+
+    sentPackets_.fetch_add(packets, std::memory_order_relaxed);
+    sentBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    sendCalls_.fetch_add(calls, std::memory_order_relaxed);
+}
+
+void UdpChannel::handleWrite()
+{
+    flush();
+}
+
+UdpStats UdpChannel::stats() const
+{
+    UdpStats stats;
+    stats.receivedPackets = receivedPackets_.load(std::memory_order_relaxed);
+    stats.receivedBytes = receivedBytes_.load(std::memory_order_relaxed);
+    stats.recvCalls = recvCalls_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    stats.sentPackets = sentPackets_.load(std::memory_order_relaxed);
+    stats.sentBytes = sentBytes_.load(std::memory_order_relaxed);
+    stats.sendCalls = sendCalls_.load(std::memory_order_relaxed);
+    stats.droppedSends = droppedSends_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Socket.h"
+#include "Channel.h"
+#include "InetAddress.h"
+#include "Timestamp.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+class EventLoop;
+class UdpChannel;
+
+// 收到一个数据报，data 只在回调期间有效；回调中可以直接 channel->send 回复
+using UdpMessageCallback = std::function<void(UdpChannel* channel, const InetAddress& peer,
+                                              const char* data, size_t len, Timestamp receiveTime)>;
+
+// UDP 收发统计，任意线程可读
+struct UdpStats
+{
+    uint64_t receivedPackets;       // 收到的数据报（GRO 合并的按拆分后计）
+    uint64_t receivedBytes;
+    uint64_t recvCalls;             // recvmmsg 调用次数
+    uint64_t truncated;             // 超过 maxDatagramSize 被截断丢弃的数据报
+    uint64_t sentPackets;
+    uint64_t sentBytes;
+    uint64_t sendCalls;             // sendmmsg 调用次数
+    uint64_t droppedSends;          // 发送队列已满或发送出错丢弃的数据报
+};
+
+/**************************************************************************************
+ * 一个绑定在某个地址（IPv4 或 IPv6）上的 UDP socket，属于一个 loop。
+ *     读：可读时用 recvmmsg 一次收 batchSize 个数据报到预先分配的缓冲区，逐个回调，
+ * 每次读事件最多收 kMaxReadRounds 批。开启 GRO 后内核把同一条流的多个数据报合并成一个
+ * （每个接收槽 64KB），回调前按 cmsg 中的段长度拆开，用户看到的仍是原来的数据报。
+ *     写：send 只把数据报拷贝进发送队列，本轮事件处理完后（或队列满时）用 sendmmsg 一次
+ * 发出。开启 GSO 后，队列中连续发往同一个对端、长度相同（最后一个可以更短）的数据报
+ * 合并成一个消息，由内核（或网卡）切分。内核发送缓冲区满时等待可写再发，队列满时丢弃。
+ *     UdpChannel 用 shared_ptr 管理，在 loop 线程中析构；配置在 start 之前设置。
+**************************************************************************************/
+class UdpChannel : noncopyable,
+                   public std::enable_shared_from_this<UdpChannel>
+{
+public:
+    static const size_t kDefaultBatchSize = 64;
+    static const size_t kDefaultMaxDatagramSize = 2048;
+    static const size_t kMaxSendQueue = 1024;       // 发送队列最多的数据报数，也是一次 sendmmsg 的上限
+    static const int kMaxReadRounds = 8;
+    static const size_t kMaxGsoSegments = 64;
+    static const size_t kMaxGsoBytes = 60000;       // 一个 GSO 消息的最大字节数
+
+    // reusePort 为 true 时多个 UdpChannel 可以绑定同一个地址，由内核按四元组分配数据报
+    UdpChannel(EventLoop* loop, const InetAddress& bindAddr, bool reusePort = false);
+    ~UdpChannel();
+
+    void setMessageCallback(const UdpMessageCallback& cb) { messageCallback_ = cb;  }
+    // 一次 recvmmsg 最多收的数据报数
+    void setBatchSize(size_t n) {   batchSize_ = n > 0 ? n : 1; }
+    // 接收的数据报上限，超过的被截断丢弃；发送的数据报同样不能超过
+    void setMaxDatagramSize(size_t bytes) { maxDatagramSize_ = bytes;   }
+    void setGso(bool on) {  gso_ = on;  }
+    void setGro(bool on) {  gro_ = on;  }
+    void setRecvBuffer(int bytes) { socket_.setRecvBuffer(bytes);   }
+    void setSendBuffer(int bytes) { socket_.setSendBuffer(bytes);   }
+
+    // 任意线程：在 loop 中开始读取
+    void start();
+
+    /**
+     * 发送一个数据报，返回是否进入发送队列。loop 线程中调用时只拷贝进队列；
+     * 其他线程调用时拷贝一份交给 loop（此时总是返回 true）。
+     */
+    bool send(const InetAddress& peer, const char* data, size_t len);
+    // loop 线程：立即发出队列中的数据报
+    void flush();
+
+    EventLoop* getLoop() const {    return loop_;   }
+    int fd() const {    return socket_.fd();    }
+    const InetAddress& localAddress() const {   return localAddr_;  }
+    bool gsoEnabled() const {   return gso_;    }
+    bool groEnabled() const {   return gro_;    }
+    UdpStats stats() const;
+
+private:
+    // 发送队列中的一个数据报，数据在 sendData_ 的 offset 处
+    struct Outgoing
+    {
+        InetAddress peer;
+        size_t offset;
+        size_t len;
+    };
+
+    void startInLoop();
+    void handleRead(Timestamp receiveTime);
+    void handleWrite();
+    // 按 GRO 段长度拆开后逐个回调，返回数据报数
+    size_t dispatch(const InetAddress& peer, const char* data, size_t len, size_t segment, Timestamp receiveTime);
+    void queueFlush();
+    // 从 first 开始把发送队列组装成消息，返回消息数
+    size_t buildMessages(size_t first);
+
+    EventLoop* loop_;
+    Socket socket_;
+    Channel channel_;
+    InetAddress localAddr_;
+    UdpMessageCallback messageCallback_;
+    size_t batchSize_;
+    size_t maxDatagramSize_;
+    bool gso_;
+    bool gro_;
+    bool started_;
+
+    // 接收用的消息数组和缓冲区，start 时按 batchSize 分配
+    size_t slotSize_;
+    std::vector<char> recvData_;
+    std::vector<mmsghdr> recvMsgs_;
+    std::vector<iovec> recvIov_;
+    std::vector<sockaddr_storage> recvAddrs_;
+    std::vector<char> recvControl_;
+
+    // 发送队列和组装 sendmmsg 用的数组（按 kMaxSendQueue 预先分配）
+    std::vector<char> sendData_;
+    std::vector<Outgoing> sendQueue_;
+    std::vector<mmsghdr> sendMsgs_;
+    std::vector<iovec> sendIov_;
+    std::vector<char> sendControl_;
+    std::vector<size_t> sendMsgCounts_;     // 每个消息包含的数据报数
+    bool flushQueued_;
+
+    std::atomic<uint64_t> receivedPackets_;
+    std::atomic<uint64_t> receivedBytes_;
+    std::atomic<uint64_t> recvCalls_;
+    std::atomic<uint64_t> truncated_;
+    std::atomic<uint64_t> sentPackets_;
+    std::atomic<uint64_t> sentBytes_;
+    std::atomic<uint64_t> sendCalls_;
+    std::atomic<uint64_t> droppedSends_;
+};
+
+using UdpChannelPtr = std::shared_ptr<UdpChannel>;
@@ -0,0 +1,104 @@
+#include "UdpServer.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logger.h"
+
+#include <future>
+
+UdpServer::UdpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name)
+    : loop_(loop),
+      listenAddr_(listenAddr),
+      name_(name),
+      threadPool_(new EventLoopThreadPool(loop, name)),
+      batchSize_(UdpChannel::kDefaultBatchSize),
+      maxDatagramSize_(UdpChannel::kDefaultMaxDatagramSize),
+      gso_(false),
+      gro_(false),
+      recvBufferBytes_(0),
+      sendBufferBytes_(0),
+      started_(0)
+{
+    if (loop == nullptr)
+    {
+        LOG_FATAL("%s:%s:%d MainLoop is NULL!\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+}
+
+UdpServer::~UdpServer()
+{
+    // 每个 UdpChannel 在自己的 loop 中析构（从 poller 中移除）
+    for (UdpChannelPtr& channel : channels_)
+    {
+        EventLoop* ioLoop = channel->getLoop();
+        if (ioLoop->isInLoopThread())
+        {
+            channel.reset();
+            continue;
+        }
+        std::promise<void> removed;
+        UdpChannelPtr last;
+        last.swap(channel);
+        ioLoop->runInLoop([&last, &removed]() {
+            last.reset();
+            removed.set_value();
+        });
+        removed.get_future().wait();
+    }
+}
+
+void UdpServer::setThreadNum(int numThreads)
+{
+    threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start()
+{
+    if (started_++ != 0)
+    {
+        return;
+    }
+    threadPool_->start(threadInitCallback_);
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    for (EventLoop* ioLoop : loops)
+    {
+        UdpChannelPtr channel = std::make_shared<UdpChannel>(ioLoop, listenAddr_, loops.size() > 1);
+        channel->setMessageCallback(messageCallback_);
+        channel->setBatchSize(batchSize_);
+        channel->setMaxDatagramSize(maxDatagramSize_);
+        channel->setGso(gso_);
+        channel->setGro(gro_);
+        if (recvBufferBytes_ > 0)
+        {
+            channel->setRecvBuffer(recvBufferBytes_);
+        }
+        if (sendBufferBytes_ > 0)
+        {
+            channel->setSendBuffer(sendBufferBytes_);
+        }
+        channels_.push_back(channel);
+    }
+    for (const UdpChannelPtr& channel : channels_)
+    {
+        channel->start();
+    }
+    LOG_INFO("UdpServer [%s] listening on %s with %zu sockets\n",
+        name_.c_str(), listenAddr_.toIpPort().c_str(), channels_.size());
+}
+
+UdpStats UdpServer::stats() const
+{
+    UdpStats total = UdpStats();
+    for (const UdpChannelPtr& channel : channels_)
+    {
+        UdpStats stats = channel->stats();
+        total.receivedPackets += stats.receivedPackets;
+        total.receivedBytes += stats.receivedBytes;
+        total.recvCalls += stats.recvCalls;
+        total.truncated += stats.truncated;
+        total.sentPackets += stats.sentPackets;
+        total.sentBytes += stats.sentBytes;
+        total.sendCalls += stats.sendCalls;
+        total.droppedSends += stats.droppedSends;
+    }
+    return total;
+}
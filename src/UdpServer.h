@@ -0,0 +1,72 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "UdpChannel.h"
+#include "InetAddress.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+
+class EventLoop;
+class EventLoopThreadPool;
+
+/**************************************************************************************
+ * UDP 服务器：每个 loop（setThreadNum 为 0 时只有 baseloop）一个 UdpChannel，都用
+ * SO_REUSEPORT 绑定同一个地址，内核按源地址哈希把数据报分给各个 socket，同一个对端的
+ * 数据报总在同一个 loop 中处理，loop 之间不共享状态。
+ *     回调和选项在 start 之前设置，对每个 UdpChannel 生效，见 UdpChannel。
+ * UdpServer 在 baseloop 线程中析构，析构时等待各个 loop 移除自己的 socket。
+ *
+ *     UdpServer server(&loop, InetAddress(9125), "statsd");
+ *     server.setThreadNum(4);
+ *     server.setMessageCallback([](UdpChannel* ch, const InetAddress& peer,
+ *                                  const char* data, size_t len, Timestamp) { ... });
+ *     server.start();
+**************************************************************************************/
+class UdpServer : noncopyable
+{
+public:
+    using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+    UdpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name);
+    ~UdpServer();
+
+    void setThreadNum(int numThreads);
+    void setThreadInitCallback(const ThreadInitCallback& cb) {  threadInitCallback_ = cb;   }
+    void setMessageCallback(const UdpMessageCallback& cb) { messageCallback_ = cb;  }
+    void setBatchSize(size_t n) {   batchSize_ = n; }
+    void setMaxDatagramSize(size_t bytes) { maxDatagramSize_ = bytes;   }
+    void setGso(bool on) {  gso_ = on;  }
+    void setGro(bool on) {  gro_ = on;  }
+    // 每个 socket 的内核接收 / 发送缓冲区，0 为系统默认
+    void setRecvBuffer(int bytes) { recvBufferBytes_ = bytes;   }
+    void setSendBuffer(int bytes) { sendBufferBytes_ = bytes;   }
+
+    void start();
+
+    const std::string& name() const {   return name_;   }
+    // start 之后不再变化，UdpChannel 的 send 任意线程可调用
+    const std::vector<UdpChannelPtr>& channels() const {    return channels_;   }
+    // 所有 socket 的统计之和
+    UdpStats stats() const;
+
+private:
+    EventLoop* loop_;
+    const InetAddress listenAddr_;
+    const std::string name_;
+    std::shared_ptr<EventLoopThreadPool> threadPool_;
+    std::vector<UdpChannelPtr> channels_;       // 声明在线程池之后，先于 IO 线程退出析构
+
+    ThreadInitCallback threadInitCallback_;
+    UdpMessageCallback messageCallback_;
+    size_t batchSize_;
+    size_t maxDatagramSize_;
+    bool gso_;
+    bool gro_;
+    int recvBufferBytes_;
+    int sendBufferBytes_;
+    std::atomic_int started_;
+};